@@ -3580,6 +3580,14 @@ compile_aux_clauses(Clauses) :-
     ->  true
     ;   '$type_error'(integer, X)
     ).
+'$must_be'(positive_integer, X) :- !,
+    (   integer(X)
+    ->  (   X >= 1
+        ->  true
+        ;   '$type_error'(positive_integer, X)
+        )
+    ;   '$must_be'(integer, X)
+    ).
 '$must_be'(callable, X) :- !,
     (   callable(X)
     ->  true
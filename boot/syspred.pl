@@ -400,13 +400,29 @@ flag(Name, Old, New) :-
     with_mutex('$flag', update_flag(Name, Old, New)).
 
 update_flag(Name, Old, New) :-
-    get_flag(Name, Old),
-    (   atom(New)
-    ->  set_flag(Name, New)
-    ;   Value is New,
-        set_flag(Name, Value)
+    get_flag(Name, Current),
+    \+ Current \= Old,
+    copy_term(Old-New, Current-Expr),
+    (   atom(Expr)
+    ->  Value = Expr
+    ;   Value is Expr
+    ),
+    (   set_flag_if(Name, Current, Value)
+    ->  Old = Current
+    ;   update_flag(Name, Old, New)
     ).
 
+%   Use atomic_cas/4 for integers, such that flag/3 is atomic with
+%   respect to atomic_add/3.
+
+set_flag_if(Name, Current, Value) :-
+    integer(Current),
+    integer(Value),
+    !,
+    atomic_cas(Name, Current, Value, Current).
+set_flag_if(Name, _, Value) :-
+    set_flag(Name, Value).
+
 
                  /*******************************
                  *            RATIONAL          *
@@ -40,8 +40,13 @@
             tnot/1,                     % :Goal
 
             current_table/2,            % :Variant, ?Table
+            table_statistics/2,         % :Variant, -Stats
+            table_statistics_top/3,     % +Key, +Count, -Tables
             abolish_all_tables/0,
             abolish_table_subgoals/1,   % :Subgoal
+            set_table_space_limit/2,    % :PI, +Limit
+            table_space_limit/3,        % :PI, -Limit, -Used
+            table_concurrent/2,         % :Goals, +Options
 
             start_tabling/2,            % +Wrapper, :Worker
             start_tabling/4             % +Wrapper, :Worker, :Variant, ?ModeArgs
@@ -52,7 +57,11 @@
     start_tabling(+, 0),
     start_tabling(+, 0, +, ?),
     current_table(:, -),
-    abolish_table_subgoals(:).
+    table_statistics(:, -),
+    abolish_table_subgoals(:),
+    set_table_space_limit(:, +),
+    table_space_limit(:, -, -),
+    table_concurrent(:, +).
 
 /** <module> Tabled execution (SLG WAM)
 
@@ -332,6 +341,19 @@ update(M:Wrapper, A1, A2, A3) :-
     M:'$table_update'(Wrapper, A1, A2, A3),
     A1 \=@= A3.
 
+%!  update_modes(+Wrapper, -Modes) is semidet.
+%
+%   Modes is a list with an  element   for  each moded argument of the
+%   tabled goal Wrapper. Each element is one of `first`, `last`, `min`,
+%   `max`, `sum` or `count` if the  aggregation is implemented in C or
+%   `prolog` if update/4 must be used.
+
+:- public
+    update_modes/2.
+
+update_modes(M:Wrapper, Modes) :-
+    M:'$table_update_modes'(Wrapper, Modes).
+
 
 %!  completion(+Component)
 %
@@ -451,6 +473,187 @@ abolish_table_subgoals(M:SubGoal) :-
            '$tbl_destroy_table'(Trie)).
 
 
+                 /*******************************
+                 *          TABLE SPACE         *
+                 *******************************/
+
+%!  set_table_space_limit(:PI, +Limit) is det.
+%
+%   Limit the space used by the  completed   tables  of  PI to Limit
+%   bytes. If the limit is exceeded after completing a table of PI, the
+%   least recently used completed tables of   PI are evicted. Limit is
+%   `infinite` to remove the limit. Tables are thread-local and thus
+%   the limit applies per thread.
+
+set_table_space_limit(M:PI, Limit) :-
+    table_pi(PI, M, QPI),
+    '$tbl_set_space_limit'(QPI, Limit).
+
+%!  table_space_limit(:PI, -Limit, -Used) is semidet.
+%
+%   True when PI has a table space  limit   of  Limit bytes and the
+%   completed tables of PI of the calling thread use Used bytes.
+
+table_space_limit(M:PI, Limit, Used) :-
+    table_pi(PI, M, QPI),
+    '$tbl_space_limit'(QPI, Limit, Used).
+
+table_pi(Var, _, _) :-
+    var(Var),
+    !,
+    '$instantiation_error'(Var).
+table_pi(M:PI, _, QPI) :-
+    !,
+    table_pi(PI, M, QPI).
+table_pi(Name//DCGArity, M, M:Name/Arity) :-
+    !,
+    '$must_be'(integer, DCGArity),
+    Arity is DCGArity+2.
+table_pi(PI, M, M:PI).
+
+
+                 /*******************************
+                 *    CONCURRENT EVALUATION     *
+                 *******************************/
+
+%!  table_concurrent(:Goals, +Options) is det.
+%
+%   Call the independent goals from the list Goals to exhaustion using a
+%   pool of worker threads and add the  tables completed by the workers
+%   to the tables of the calling thread if  this thread has no table for
+%   the variant yet.  This does not  parallelize the evaluation of a
+%   single goal: each goal is evaluated by one worker using the normal
+%   SLG resolution.  As tables are local  to a thread, workers do not
+%   share tables and subgoals shared by goals of different workers are
+%   evaluated by each of them.  Importing  a table copies all its answers.
+%   This is only worthwhile if the goals  are expensive and share few
+%   subgoals.  Options is a list of
+%
+%     - threads(+Count)
+%       Number of workers.  Default is the flag `cpu_count`.
+
+table_concurrent(M:Goals, Options) :-
+    '$must_be'(list, Goals),
+    (   '$option'(threads(N), Options)
+    ->  '$must_be'(positive_integer, N)
+    ;   current_prolog_flag(cpu_count, N)
+    ),
+    length(Goals, Len),
+    Workers is max(1, min(N, Len)),
+    (   current_prolog_flag(threads, true),
+        Workers > 1
+    ->  setup_call_cleanup(
+            ( message_queue_create(WorkQ),
+              message_queue_create(DoneQ)
+            ),
+            run_table_workers(Workers, M, Goals, WorkQ, DoneQ),
+            ( message_queue_destroy(WorkQ),
+              message_queue_destroy(DoneQ)
+            ))
+    ;   forall('$member'(G, Goals), forall(M:G, true))
+    ).
+
+run_table_workers(N, M, Goals, WorkQ, DoneQ) :-
+    forall('$member'(G, Goals), thread_send_message(WorkQ, goal(G))),
+    forall(between(1, N, _), thread_send_message(WorkQ, done)),
+    setup_call_catcher_cleanup(
+        create_table_workers(N, M, WorkQ, DoneQ, [], Ids),
+        collect_table_results(Ids, DoneQ, Errors),
+        Catcher,
+        join_table_workers(Catcher, Ids)),
+    (   Errors = [E|_]
+    ->  throw(E)
+    ;   true
+    ).
+
+%!  create_table_workers(+N, +M, +WorkQ, +DoneQ, +Ids0, -Ids)
+%
+%   Create N workers. If creating a worker   raises an exception, the
+%   workers created so far are stopped before re-throwing the exception.
+
+create_table_workers(0, _, _, _, Ids, Ids) :-
+    !.
+create_table_workers(N, M, WorkQ, DoneQ, Ids0, Ids) :-
+    catch(thread_create(table_worker(M, WorkQ, DoneQ), Id, []), E, true),
+    (   var(E)
+    ->  N1 is N-1,
+        create_table_workers(N1, M, WorkQ, DoneQ, [Id|Ids0], Ids)
+    ;   join_table_workers(exception(E), Ids0),
+        throw(E)
+    ).
+
+%!  join_table_workers(+Catcher, +Ids)
+%
+%   Join the workers. If we did not   collect all results, the workers
+%   may still be running and are aborted first.
+
+join_table_workers(Catcher, Ids) :-
+    (   Catcher == exit
+    ->  true
+    ;   forall('$member'(Id, Ids),
+               catch(thread_signal(Id, abort), _, true))
+    ),
+    forall('$member'(Id, Ids),
+           catch(thread_join(Id, _), _, true)).
+
+table_worker(M, WorkQ, DoneQ) :-
+    thread_get_message(WorkQ, Msg),
+    (   Msg = goal(G)
+    ->  catch(forall(M:G, true), E, true),
+        (   var(E)
+        ->  table_worker(M, WorkQ, DoneQ)
+        ;   thread_self(Me),
+            thread_send_message(DoneQ, table_result(Me, error(E))),
+            drain_work(WorkQ)
+        )
+    ;   completed_tables(Tables),
+        thread_self(Me),
+        thread_send_message(DoneQ, table_result(Me, Tables))
+    ).
+
+drain_work(WorkQ) :-
+    thread_get_message(WorkQ, Msg),
+    (   Msg == done
+    ->  true
+    ;   drain_work(WorkQ)
+    ).
+
+completed_tables(Tables) :-
+    (   '$tbl_variant_table'(VariantTrie)
+    ->  findall(Variant-Answers,
+                ( trie_gen(VariantTrie, Variant, Trie),
+                  '$tbl_table_status'(Trie, complete, _, _),
+                  findall(Key-Value, trie_gen(Trie, Key, Value), Answers)
+                ),
+                Tables)
+    ;   Tables = []
+    ).
+
+collect_table_results([], _, []).
+collect_table_results([Id|Ids], DoneQ, Errors) :-
+    thread_get_message(DoneQ, table_result(Id0, Result)),
+    '$select'(Id0, [Id|Ids], Rest),
+    (   Result = error(E)
+    ->  Errors = [E|Errors1]
+    ;   import_tables(Result),
+        Errors = Errors1
+    ),
+    collect_table_results(Rest, DoneQ, Errors1).
+
+import_tables(Tables) :-
+    forall('$member'(Variant-Answers, Tables),
+           import_table(Variant, Answers)).
+
+import_table(Variant, Answers) :-
+    '$tbl_variant_table'(Variant, Trie, Status, _Skeleton),
+    (   Status == fresh
+    ->  forall('$member'(Key-Value, Answers),
+               ( trie_insert(Trie, Key, Value) -> true ; true )),
+        '$tbl_table_complete'(Trie)
+    ;   true
+    ).
+
+
                  /*******************************
                  *        EXAMINE TABLES        *
                  *******************************/
@@ -464,6 +667,58 @@ current_table(M:Variant, Trie) :-
     (   (var(Variant) ; var(M))
     ->  trie_gen(VariantTrie, M:Variant, Trie)
     ;   trie_lookup(VariantTrie, M:Variant, Trie)
+    ).
+
+%!  table_statistics(:Variant, -Stats) is nondet.
+%
+%   True when Stats is a list  of   Key(Value)  terms  describing the
+%   answer table for Variant. Keys are:
+%
+%     - answers(-Count)
+%       Number of answers in the table.
+%     - space(-Bytes)
+%       Memory used by the answer trie.
+%     - time(-Seconds)
+%       Wall time to complete the table.
+%     - reused(-Count)
+%       Number of calls that used the completed table.
+%     - suspensions(-Count)
+%       Number of suspensions on the table while it was incomplete.
+%
+%   The keys `time`, `reused` and `suspensions` are only maintained while
+%   the flag `table_statistics` is `true`.
+
+table_statistics(Variant, Stats) :-
+    current_table(Variant, Trie),
+    '$tbl_table_statistics'(Trie, Stats).
+
+%!  table_statistics_top(+Key, +Count, -Tables) is det.
+%
+%   Tables is a list of Value-Variant pairs   for the Count tables with
+%   the highest Value for Key. See table_statistics/2 for the keys.
+
+table_statistics_top(Key, Count, Tables) :-
+    '$must_be'(oneof(atom, table_statistics_key,
+                     [answers, space, time, reused, suspensions]), Key),
+    '$must_be'(integer, Count),
+    KeyValue =.. [Key, Value],
+    findall(Value-Variant,
+            ( '$tbl_variant_table'(VariantTrie),
+              trie_gen(VariantTrie, Variant, Trie),
+              '$tbl_table_statistics'(Trie, Stats),
+              memberchk(KeyValue, Stats)
+            ),
+            Pairs),
+    sort(1, @>=, Pairs, Sorted),
+    first_n(Count, Sorted, Tables).
+
+first_n(N, List, Prefix) :-
+    (   N > 0,
+        List = [H|T]
+    ->  Prefix = [H|Prefix1],
+        N1 is N-1,
+        first_n(N1, T, Prefix1)
+    ;   Prefix = []
     ).
 
 
@@ -635,12 +890,19 @@ indexed_mode(+).                                % B
 %!  updater_clauses(+Modes, +Head, -Clauses)
 %
 %   Generates a clause to update the aggregated state.  Modes is
-%   a list of predicate names we apply to the state.
+%   a list of predicate names we apply to the state.  In addition,
+%   generate '$table_update_modes'/2 that tells the C core which
+%   modes it can handle natively.
 
 updater_clauses([], _, []) :- !.
-updater_clauses([P], Head, [('$table_update'(Head, S0, S1, S2) :- Body)]) :- !,
-    update_goal(P, S0,S1,S2, Body).
-updater_clauses(Modes, Head, [('$table_update'(Head, S0, S1, S2) :- Body)]) :-
+updater_clauses([P], Head, [ ('$table_update'(Head, S0, S1, S2) :- Body),
+                             '$table_update_modes'(Head, Native)
+                           ]) :- !,
+    update_goal(P, S0,S1,S2, Body),
+    native_modes([P], Native).
+updater_clauses(Modes, Head, [ ('$table_update'(Head, S0, S1, S2) :- Body),
+                               '$table_update_modes'(Head, Native)
+                             ]) :-
     length(Modes, Len),
     functor(S0, s, Len),
     functor(S1, s, Len),
@@ -648,7 +910,8 @@ updater_clauses(Modes, Head, [('$table_update'(Head, S0, S1, S2) :- Body)]) :-
     S0 =.. [_|Args0],
     S1 =.. [_|Args1],
     S2 =.. [_|Args2],
-    update_body(Modes, Args0, Args1, Args2, true, Body).
+    update_body(Modes, Args0, Args1, Args2, true, Body),
+    native_modes(Modes, Native).
 
 update_body([], _, _, _, Body, Body).
 update_body([P|TM], [A0|Args0], [A1|Args1], [A2|Args2], Body0, Body) :-
@@ -708,6 +971,29 @@ update_alias(last,  lattice('$tabling':last/3)).
 update_alias(min,   lattice('$tabling':min/3)).
 update_alias(max,   lattice('$tabling':max/3)).
 update_alias(sum,   lattice('$tabling':sum/3)).
+update_alias(count, lattice('$tabling':count/3)).
+
+%!  native_modes(+Modes, -Native) is det.
+%
+%   Map the modes to the aggregation   names  understood by the C update
+%   for '$tbl_wkl_mode_add_answer'/4 or `prolog` for  modes that must be
+%   handled by update/4.
+
+native_modes([], []).
+native_modes([H|T0], [N|T]) :-
+    (   native_mode(H, N0)
+    ->  N = N0
+    ;   N = prolog
+    ),
+    native_modes(T0, T).
+
+native_mode(first, first).
+native_mode(-,     first).
+native_mode(last,  last).
+native_mode(min,   min).
+native_mode(max,   max).
+native_mode(sum,   sum).
+native_mode(count, count).
 
 mkconj(true, G,  G) :- !.
 mkconj(G1,   G2, (G1,G2)).
@@ -722,16 +1008,19 @@ mkconj(G1,   G2, (G1,G2)).
 %!  min(+S0, +S1, -S) is det.
 %!  max(+S0, +S1, -S) is det.
 %!  sum(+S0, +S1, -S) is det.
+%!  count(+S0, +S1, -S) is det.
 %
-%   Implement YAP tabling modes.
+%   Implement YAP tabling modes.   These  are normally executed natively
+%   by '$tbl_wkl_mode_add_answer'/4.
 
-:- public first/3, last/3, min/3, max/3, sum/3.
+:- public first/3, last/3, min/3, max/3, sum/3, count/3.
 
 first(S, _, S).
 last(_, S, S).
 min(S0, S1, S) :- (S0 @< S1 -> S = S0 ; S = S1).
 max(S0, S1, S) :- (S0 @> S1 -> S = S0 ; S = S1).
 sum(S0, S1, S) :- S is S0+S1.
+count(S0, _, S) :- S is S0+1.
 
 
 		 /*******************************
@@ -764,7 +1053,8 @@ rename_term(Name, WrapName) :-
 system:term_expansion((:- table(Preds)),
                       [ (:- multifile('$tabled'/1)),
                         (:- multifile('$table_mode'/3)),
-                        (:- multifile('$table_update'/4))
+                        (:- multifile('$table_update'/4)),
+                        (:- multifile('$table_update_modes'/2))
                       | Clauses
                       ]) :-
     \+ current_prolog_flag(xref, true),
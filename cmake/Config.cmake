@@ -15,6 +15,8 @@ check_include_file(ieeefp.h HAVE_IEEEFP_H)
 check_include_file(ieee754.h HAVE_IEEE754_H)
 check_include_file(libloaderapi.h HAVE_LIBLOADERAPI_H)
 check_include_file(limits.h HAVE_LIMITS_H)
+check_include_file(linux/futex.h HAVE_LINUX_FUTEX_H)
+check_include_file(linux/mempolicy.h HAVE_LINUX_MEMPOLICY_H)
 check_include_file(locale.h HAVE_LOCALE_H)
 if(NOT CMAKE_SYSTEM_NAME STREQUAL "FreeBSD")
 check_include_file(malloc.h HAVE_MALLOC_H)
@@ -34,6 +36,7 @@ check_include_file(sys/ndir.h HAVE_SYS_NDIR_H)
 check_include_file(sys/param.h HAVE_SYS_PARAM_H)
 check_include_file(sys/resource.h HAVE_SYS_RESOURCE_H)
 check_include_file(sys/select.h HAVE_SYS_SELECT_H)
+check_include_file(sys/sendfile.h HAVE_SYS_SENDFILE_H)
 check_include_file(sys/stat.h HAVE_SYS_STAT_H)
 check_include_file(sys/syscall.h HAVE_SYS_SYSCALL_H)
 check_include_file(sys/termio.h HAVE_SYS_TERMIO_H)
@@ -123,6 +126,7 @@ check_function_exists(fchmod HAVE_FCHMOD)
 check_function_exists(fcntl HAVE_FCNTL)
 check_function_exists(fstat HAVE_FSTAT)
 check_function_exists(ftruncate HAVE_FTRUNCATE)
+check_function_exists(sendfile HAVE_SENDFILE)
 check_function_exists(getcwd HAVE_GETCWD)
 check_function_exists(getwd HAVE_GETWD)
 check_function_exists(opendir HAVE_OPENDIR)
@@ -192,6 +192,10 @@
 		     [ timeout(number),
 		       deadline(number)
 		     ]).
+:- predicate_options(system:thread_get_messages/4, 4,
+		     [ timeout(number),
+		       deadline(number)
+		     ]).
 :- predicate_options(system:locale_create/3, 3,
 		     [ alias(atom),
 		       decimal_point(atom),
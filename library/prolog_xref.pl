@@ -1218,6 +1218,9 @@ xref_meta(setup_call_cleanup(A, B, C),[A, B, C]).
 xref_meta(setup_call_catcher_cleanup(A, B, _, C),[A, B, C]).
 xref_meta(call_residue_vars(A,_), [A]).
 xref_meta(with_mutex(_,A),      [A]).
+xref_meta(with_read_lock(_,A),  [A]).
+xref_meta(with_write_lock(_,A), [A]).
+xref_meta(with_optimistic_read(_,A), [A]).
 xref_meta(assume(G),            [G]).   % library(debug)
 xref_meta(assertion(G),         [G]).   % library(debug)
 xref_meta(freeze(_, G),         [G]).
@@ -42,6 +42,8 @@
             read_file_to_codes/3,       % +File, -Codes, +Options
 
             read_line_to_string/2,      % +Stream, -Line (without trailing \n)
+            read_lines_to_strings/3,    % +Stream, +Max, -Lines
+            read_lines_to_strings/4,    % +Stream, +Max, -Lines, +Options
             read_file_to_string/3,      % +File, -Codes, +Options
 
             read_file_to_terms/3        % +File, -Terms, +Options
@@ -62,6 +64,10 @@ implementation if the shared object cannot be found.
 @see library(lazy_lists) for creating lazy lists from input.
 */
 
+:- predicate_options(read_lines_to_strings/4, 4,
+                     [ separators(text),
+                       padding(text)
+                     ]).
 :- predicate_options(read_file_to_codes/3, 3,
                      [ tail(list_or_partial_list),
                        pass_to(system:open/4, 4)
@@ -187,6 +193,46 @@ read_line_to_string(Stream, String) :-
     ;   String = String0
     ).
 
+%!  read_lines_to_strings(+Stream, +Max, -Lines:list(string)) is det.
+%!  read_lines_to_strings(+Stream, +Max, -Lines:list(string),
+%!                        +Options) is det.
+%
+%   Read at most Max lines from Stream as a list of strings. The lines
+%   are read as by read_line_to_string/2, but in a single call that
+%   scans the stream buffer for the line separators. Fewer than Max
+%   lines are returned if the end of the input is reached. If Max is
+%   positive, Lines is `[]` if and only if the input is at its end. If
+%   Max is 0, Lines is `[]` and nothing is read. This allows for
+%   processing large inputs in batches:
+%
+%   ```
+%   process_lines(Stream) :-
+%       read_lines_to_strings(Stream, 1000, Lines),
+%       (   Lines == []
+%       ->  true
+%       ;   maplist(process_line, Lines),
+%           process_lines(Stream)
+%       ).
+%   ```
+%
+%   Options processed:
+%
+%     * separators(+Chars)
+%     Characters that end a record.  Default is `"\n"`.
+%     * padding(+Chars)
+%     Characters removed from both ends of a record.  Default is
+%     `"\r"`.
+%
+%   @see read_string/5 for the semantics of separators and padding.
+
+read_lines_to_strings(Stream, Max, Lines) :-
+    '$read_strings'(Stream, Max, "\n", "\r", Lines).
+
+read_lines_to_strings(Stream, Max, Lines, Options) :-
+    option(separators(Sep), Options, "\n"),
+    option(padding(Pad), Options, "\r"),
+    '$read_strings'(Stream, Max, Sep, Pad, Lines).
+
 
                  /*******************************
                  *     STREAM (ENTIRE INPUT)    *
@@ -38,13 +38,24 @@
             concurrent_maplist/2,       % :Goal, +List
             concurrent_maplist/3,       % :Goal, ?List1, ?List2
             concurrent_maplist/4,       % :Goal, ?List1, ?List2, ?List3
-            first_solution/3            % -Var, :Goals, +Options
+            concurrent_forall/2,        % :Cond, :Action
+            concurrent_forall/3,        % :Cond, :Action, +Options
+            concurrent_aggregate_all/3, % +Spec, :Goal, -Result
+            first_solution/3,           % -Var, :Goals, +Options
+            async/2,                    % :Goal, -Future
+            await/2,                    % +Future, -Result
+            await/3,                    % +Future, -Result, +Options
+            await_all/2,                % +Futures, -Results
+            await_all/3,                % +Futures, -Results, +Options
+            await_any/2,                % +Futures, -Future
+            await_any/3                 % +Futures, -Future, +Options
           ]).
 :- use_module(library(debug)).
 :- use_module(library(error)).
 :- use_module(library(lists)).
 :- use_module(library(apply)).
 :- use_module(library(option)).
+:- use_module(library(aggregate)).
 
 %:- debug(concurrent).
 
@@ -53,16 +64,34 @@
     concurrent_maplist(1, +),
     concurrent_maplist(2, ?, ?),
     concurrent_maplist(3, ?, ?, ?),
-    first_solution(-, :, +).
+    concurrent_forall(0, 0),
+    concurrent_forall(0, 0, +),
+    concurrent_aggregate_all(?, 0, -),
+    first_solution(-, :, +),
+    async(0, -).
 
 :- predicate_options(concurrent/3, 3,
-                     [ pass_to(system:thread_create/3, 3)
+                     [ executor(boolean),
+                       pass_to(system:thread_create/3, 3)
+                     ]).
+:- predicate_options(concurrent_forall/3, 3,
+                     [ threads(positive_integer)
                      ]).
 :- predicate_options(first_solution/3, 3,
                      [ on_fail(oneof([stop,continue])),
                        on_error(oneof([stop,continue])),
                        pass_to(system:thread_create/3, 3)
                      ]).
+:- predicate_options(await/3, 3,
+                     [ timeout(number),
+                       deadline(number)
+                     ]).
+:- predicate_options(await_all/3, 3,
+                     [ pass_to(await/3, 3)
+                     ]).
+:- predicate_options(await_any/3, 3,
+                     [ pass_to(await/3, 3)
+                     ]).
 
 /** <module> High level thread primitives
 
@@ -129,14 +158,28 @@ following consequences:
 %     * If one or more of the goals may fail or produce an error,
 %     using a higher number of threads may find this earlier.
 %
+%   If Options contains executor(true)  and   N  does  not exceed the
+%   number of workers of the executor plus   one, the goals are executed
+%   by the calling thread and workers  of the process-wide executor that
+%   is also used by concurrent_maplist/2, which avoids creating threads.
+%   The executor has as many workers as  the Prolog flag =cpu_count=. In
+%   this case a goal may run in the calling thread, goals that run in the
+%   same worker share its thread_self/1,  thread local predicates and
+%   global variables, and a goal only starts when a worker is available.
+%   Goals that wait for each other may  therefore deadlock if the
+%   executor is busy.  If a goal fails  or raises an exception, goals
+%   that are running are interrupted using thread_signal/2 and goals
+%   that did not start are discarded.  Without this option, each worker
+%   is a new thread.
+%
 %   @param N Number of worker-threads to create. Using 1, no threads
 %          are created.  If N is larger than the number of Goals we
 %          create exactly as many threads as there are Goals.
 %   @param Goals List of callable terms.
 %   @param Options Passed to thread_create/3 for creating the
-%          workers.  Only options changing the stack-sizes can
-%          be used. In particular, do not pass the detached or alias
-%          options.
+%          workers, except for executor(Bool).  Only options changing
+%          the stack-sizes can be used. In particular, do not pass the
+%          detached or alias options.
 %   @see In many cases, concurrent_maplist/2 and friends
 %        is easier to program and is tractable to program
 %        analysis.
@@ -148,6 +191,19 @@ concurrent(N, M:List, Options) :-
     must_be(positive_integer, N),
     must_be(list(callable), List),
     length(List, JobCount),
+    select_option(executor(Executor), Options, ThreadOptions, false),
+    (   Executor == true,
+        Helpers is max(0, min(N, JobCount) - 1),
+        executor(_, Size),
+        Helpers =< Size
+    ->  maplist(qualify(M), List, Goals),
+        executor_run(Goals, Helpers)
+    ;   concurrent_threads(N, JobCount, M:List, ThreadOptions)
+    ).
+
+qualify(M, Goal, M:Goal).
+
+concurrent_threads(N, JobCount, M:List, Options) :-
     message_queue_create(Done),
     message_queue_create(Queue),
     WorkerCount is min(N, JobCount),
@@ -277,6 +333,321 @@ join_all([Id|T]) :-
     join_all(T).
 
 
+                 /*******************************
+                 *            EXECUTOR          *
+                 *******************************/
+
+%   The executor is a process-wide  pool   of  worker  threads that is
+%   created on first usage and  shared   by  concurrent/3  (if no thread
+%   options are given) and concurrent_maplist/2-4.  A call  adds its jobs
+%   to a private job queue and  posts   up  to  Helpers help(Jobs, Done)
+%   requests to the executor.  Idle  workers   take  such a request and
+%   run jobs from the job queue  until  it   is  empty.  The caller runs
+%   jobs as well, so the call completes   even if all workers are busy,
+%   for example because the caller is itself a job of the executor.
+%   Each job reports its result using  a   single  message on the Done
+%   queue.
+
+:- dynamic
+    executor_queue/2.                   % Queue, Size
+
+%!  executor(-Queue, -Size) is semidet.
+%
+%   Get the queue of the executor and its number of workers, creating
+%   the executor if it does not yet exist.
+
+executor(Queue, Size) :-
+    executor_queue(Queue, Size),
+    !.
+executor(Queue, Size) :-
+    with_mutex(thread_executor, create_executor(Queue, Size)).
+
+create_executor(Queue, Size) :-
+    executor_queue(Queue, Size),
+    !.
+create_executor(Queue, Size) :-
+    current_prolog_flag(cpu_count, Size),
+    message_queue_create(Queue),
+    forall(between(1, Size, _),
+           thread_create(executor_worker(Queue), _, [detached(true)])),
+    assertz(executor_queue(Queue, Size)).
+
+executor_worker(Queue) :-
+    thread_get_message(Queue, Request),
+    catch(executor_request(Request), _, true),
+    executor_worker(Queue).
+
+executor_request(help(Jobs, Done)) :-
+    run_jobs(Jobs, Done).
+executor_request(serve(Jobs, Done)) :-
+    serve_jobs(Jobs, Done).
+executor_request(future(Queue, Goal, Vars)) :-
+    run_future(Queue, Goal, Vars).
+
+%!  executor_run(+Goals, +Helpers) is semidet.
+%
+%   Run Goals using at most Helpers  workers   of  the executor and the
+%   calling thread.  Behaves as concurrent/3:  succeeds if all goals
+%   succeed, binding their variables, and fails   or raises an error if
+%   some goal fails or raises an error.  In  that case jobs that have
+%   not yet been started are discarded.
+
+executor_run(Goals, Helpers0) :-
+    executor(Executor, Size),
+    Helpers is min(Helpers0, Size),
+    executor_jobs(Goals, 1, Jobs, VarList),
+    length(Jobs, Count),
+    VT =.. [vars|VarList],
+    length(Requests, Helpers),
+    setup_call_cleanup(
+        ( message_queue_create(JobQueue),
+          message_queue_create(Done)
+        ),
+        ( thread_send_messages(JobQueue, Jobs),
+          maplist(=(help(JobQueue, Done)), Requests),
+          thread_send_messages(Executor, Requests),
+          run_jobs(JobQueue, Done),
+          collect_jobs(Count, JobQueue, Done, VT, true, Result)
+        ),
+        ( retractall(executor_cancelled(JobQueue)),
+          message_queue_destroy(JobQueue),
+          message_queue_destroy(Done)
+        )),
+    (   Result == true
+    ->  true
+    ;   Result = exception(Error)
+    ->  throw(Error)
+    ).
+
+executor_jobs([], _, [], []).
+executor_jobs([Goal|T0], I, [job(I, Goal, Vars)|T], [Vars|VT]) :-
+    term_variables(Goal, Vars),
+    I2 is I + 1,
+    executor_jobs(T0, I2, T, VT).
+
+%!  run_jobs(+Jobs, +Done) is det.
+%
+%   Run jobs from the queue Jobs  until   it  is  empty or a job does
+%   not succeed.
+
+run_jobs(Jobs, Done) :-
+    executor_active(Jobs, run_jobs_(Jobs, Done)).
+
+run_jobs_(Jobs, Done) :-
+    (   thread_get_message(Jobs, Job, [timeout(0)])
+    ->  run_job(Job, Jobs, Done, Result),
+        (   Result = done(_, _)
+        ->  run_jobs_(Jobs, Done)
+        ;   true
+        )
+    ;   true
+    ).
+
+%!  serve_jobs(+Jobs, +Done) is det.
+%
+%   Run jobs from the queue Jobs until we receive `end`.
+
+serve_jobs(Jobs, Done) :-
+    executor_active(Jobs, serve_jobs_(Jobs, Done)).
+
+serve_jobs_(Jobs, Done) :-
+    thread_get_message(Jobs, Msg),
+    (   Msg = job(_,_,_)
+    ->  run_job(Msg, Jobs, Done, _),
+        serve_jobs_(Jobs, Done)
+    ;   true
+    ).
+
+%!  run_job(+Job, +Jobs, +Done, -Result) is det.
+%
+%   Run Job and send Result to Done.  If the job does not succeed, the
+%   jobs from Jobs that are running in other threads are cancelled
+%   before sending the result, such that the cancellation is complete
+%   when the collector has received all results.
+
+run_job(job(I, Goal, Vars), Jobs, Done, Result) :-
+    (   catch(executor_call(Jobs, Goal), E, true)
+    ->  (   var(E)
+        ->  Result = done(I, Vars)
+        ;   Result = exception(I, E)
+        )
+    ;   Result = false(I)
+    ),
+    (   Result = done(_, _)
+    ->  true
+    ;   executor_cancelled(Jobs)
+    ->  true
+    ;   cancel_jobs(Jobs)
+    ),
+    thread_send_message(Done, Result).
+
+%   Cancellation of running jobs.  Threads  that   run  jobs  from a job
+%   queue are registered using executor_thread/2.   While a thread runs
+%   a job, the global variable `$executor_jobs` holds the job queues of
+%   the jobs it is running (more than one if a job calls the executor).
+%   cancel_jobs/1 marks the job queue as cancelled and signals the other
+%   registered threads.  The signal handler only raises an exception if
+%   the thread is running a job from the cancelled queue, so the
+%   exception is always caught by run_job/4.  Jobs that start after the
+%   cancellation raise the same exception without running.
+
+:- dynamic
+    executor_thread/2,                  % Jobs, Thread
+    executor_cancelled/1.               % Jobs
+
+executor_active(Jobs, Goal) :-
+    thread_self(Me),
+    setup_call_cleanup(
+        assertz(executor_thread(Jobs, Me), Ref),
+        Goal,
+        erase(Ref)).
+
+executor_call(Jobs, Goal) :-
+    (   nb_current('$executor_jobs', Active)
+    ->  true
+    ;   Active = []
+    ),
+    setup_call_cleanup(
+        b_setval('$executor_jobs', [Jobs|Active]),
+        (   executor_cancelled(Jobs)
+        ->  throw('$executor_cancelled')
+        ;   once(Goal)
+        ),
+        b_setval('$executor_jobs', Active)).
+
+cancel_jobs(Jobs) :-
+    assertz(executor_cancelled(Jobs)),
+    thread_self(Me),
+    forall(( executor_thread(Jobs, Thread),
+             Thread \== Me
+           ),
+           catch(thread_signal(Thread, cancel_job(Jobs)), _, true)).
+
+cancel_job(Jobs) :-
+    nb_current('$executor_jobs', Active),
+    memberchk(Jobs, Active),
+    !,
+    throw('$executor_cancelled').
+cancel_job(_).
+
+%!  collect_jobs(+Count, +Jobs, +Done, +VT, +Result0, -Result) is det.
+%
+%   Wait for the results of Count jobs.  After the first job that does
+%   not succeed, the remaining jobs are removed from the job queue.
+%   Cancelled jobs only determine the result if no job failed or raised
+%   an error, which happens if the cancellation comes from an enclosing
+%   call.
+
+collect_jobs(0, _, _, _, Result, Result) :- !.
+collect_jobs(Count, Jobs, Done, VT, Result0, Result) :-
+    thread_get_message(Done, Msg),
+    Count1 is Count - 1,
+    (   Msg = done(I, Vars)
+    ->  (   Result0 == true
+        ->  arg(I, VT, Vars)
+        ;   true
+        ),
+        Count2 = Count1,
+        Result1 = Result0
+    ;   job_result(Msg, New),
+        (   Result0 == true
+        ->  Result1 = New,
+            discard_jobs(Jobs, Count1, Count2)
+        ;   Result0 == exception('$executor_cancelled')
+        ->  Result1 = New,
+            Count2 = Count1
+        ;   Result1 = Result0,
+            Count2 = Count1
+        )
+    ),
+    collect_jobs(Count2, Jobs, Done, VT, Result1, Result).
+
+job_result(exception(_, Error), exception(Error)).
+job_result(false(_), false).
+
+%!  executor_stream(:Generator, ?Template, :MakeJob, +Helpers,
+%!                  -Results) is semidet.
+%
+%   Run jobs created from the solutions  of Generator using at most
+%   Helpers workers and the  calling  thread.   The  instances  of
+%   Template are collected in chunks  of   increasing  size  and each
+%   chunk is turned into a job  using call(MakeJob, Items, Goal, Result).
+%   Results is the list of  Result  values   for  all  chunks in order.
+%   Fails or raises an exception as executor_run/2, in which case we
+%   stop enumerating Generator as soon as possible.  Generator runs in
+%   an engine, which avoids copying the chunk built so far on every
+%   solution.
+
+executor_stream(Generator, Template, MakeJob, Helpers0, Results) :-
+    executor(Executor, Size),
+    Helpers is min(Helpers0, Size),
+    length(Requests, Helpers),
+    length(Ends, Helpers),
+    setup_call_cleanup(
+        ( message_queue_create(JobQueue),
+          message_queue_create(Done),
+          engine_create(Template, Generator, Engine)
+        ),
+        ( maplist(=(serve(JobQueue, Done)), Requests),
+          thread_send_messages(Executor, Requests),
+          stream_jobs(Engine, 1, 0, Count, MakeJob, JobQueue, Done),
+          run_jobs(JobQueue, Done),
+          functor(VT, vars, Count),
+          collect_jobs(Count, JobQueue, Done, VT, true, Result),
+          maplist(=(end), Ends),
+          thread_send_messages(JobQueue, Ends)
+        ),
+        ( engine_destroy(Engine),
+          retractall(executor_cancelled(JobQueue)),
+          message_queue_destroy(JobQueue),
+          message_queue_destroy(Done)
+        )),
+    (   Result == true
+    ->  VT =.. [_|Results]
+    ;   Result = exception(Error)
+    ->  throw(Error)
+    ).
+
+stream_jobs(Engine, Size, I0, I, MakeJob, JobQueue, Done) :-
+    (   job_failed(Done)
+    ->  I = I0
+    ;   next_solutions(Size, Engine, Items),
+        Items \== []
+    ->  I1 is I0 + 1,
+        call(MakeJob, Items, Goal, Result),
+        thread_send_message(JobQueue, job(I1, Goal, Result)),
+        (   length(Items, Size)
+        ->  Size1 is min(Size*2, 256),
+            stream_jobs(Engine, Size1, I1, I, MakeJob, JobQueue, Done)
+        ;   I = I1
+        )
+    ;   I = I0
+    ).
+
+job_failed(Done) :-
+    (   thread_peek_message(Done, false(_))
+    ->  true
+    ;   thread_peek_message(Done, exception(_, _))
+    ).
+
+next_solutions(0, _, []) :- !.
+next_solutions(N, Engine, Solutions) :-
+    (   engine_next(Engine, Solution)
+    ->  Solutions = [Solution|T],
+        N1 is N - 1,
+        next_solutions(N1, Engine, T)
+    ;   Solutions = []
+    ).
+
+discard_jobs(_, 0, 0) :- !.
+discard_jobs(Jobs, Count0, Count) :-
+    (   thread_get_messages(Jobs, Discarded, Count0, [timeout(0)])
+    ->  length(Discarded, Len),
+        Count is Count0 - Len
+    ;   Count = Count0
+    ).
+
+
                  /*******************************
                  *             MAPLIST          *
                  *******************************/
@@ -285,8 +656,8 @@ join_all([Id|T]) :-
 %!  concurrent_maplist(:Goal, +List1, +List2) is semidet.
 %!  concurrent_maplist(:Goal, +List1, +List2, +List3) is semidet.
 %
-%   Concurrent version of maplist/2. This   predicate uses concurrent/3,
-%   using multiple _worker_ threads.  The  number   of  threads  is  the
+%   Concurrent version of maplist/2.  This   predicate  uses  multiple
+%   _worker_ threads.  The  number   of  threads  is  the
 %   minimum of the list length and the   number  of cores available. The
 %   number of cores is determined using  the prolog flag =cpu_count=. If
 %   this flag is absent or 1 or List   has  less than two elements, this
@@ -294,50 +665,95 @@ join_all([Id|T]) :-
 %   based on once/1. Note that all goals   are executed as if wrapped in
 %   once/1 and therefore these predicates are _semidet_.
 %
-%   Note that the the overhead  of   this  predicate is considerable and
-%   therefore Goal must  be  fairly  expensive   before  one  reaches  a
-%   speedup.
+%   The lists are split into chunks   that are processed by the workers
+%   of a process-wide executor  that  is   shared  with  concurrent/3,
+%   together with the calling thread.  The   number  of chunks is four
+%   times the number of workers,  which   balances  the load between the
+%   workers while the communication cost is independent from the length
+%   of the lists.  Note that the  lists   are  copied  to the workers and
+%   the results are copied back, so  Goal   must  still  be fairly
+%   expensive before one reaches a speedup.
 
-concurrent_maplist(Goal, List) :-
+concurrent_maplist(M:Goal, List) :-
     workers(List, WorkerCount),
     !,
-    maplist(ml_goal(Goal), List, Goals),
-    concurrent(WorkerCount, Goals, []).
+    chunks(List, WorkerCount, Sizes),
+    split_list(Sizes, List, Chunks),
+    maplist(ml_chunk(M, Goal), Chunks, Goals),
+    Helpers is WorkerCount - 1,
+    executor_run(Goals, Helpers).
 concurrent_maplist(M:Goal, List) :-
     maplist(once_in_module(M, Goal), List).
 
 once_in_module(M, Goal, Arg) :-
     call(M:Goal, Arg), !.
 
-ml_goal(Goal, Elem, call(Goal, Elem)).
+ml_chunk(M, Goal, Chunk, maplist(once_in_module(M, Goal), Chunk)).
 
-concurrent_maplist(Goal, List1, List2) :-
+concurrent_maplist(M:Goal, List1, List2) :-
     same_length(List1, List2),
     workers(List1, WorkerCount),
     !,
-    maplist(ml_goal(Goal), List1, List2, Goals),
-    concurrent(WorkerCount, Goals, []).
+    chunks(List1, WorkerCount, Sizes),
+    split_list(Sizes, List1, Chunks1),
+    split_list(Sizes, List2, Chunks2),
+    maplist(ml_chunk(M, Goal), Chunks1, Chunks2, Goals),
+    Helpers is WorkerCount - 1,
+    executor_run(Goals, Helpers).
 concurrent_maplist(M:Goal, List1, List2) :-
     maplist(once_in_module(M, Goal), List1, List2).
 
 once_in_module(M, Goal, Arg1, Arg2) :-
     call(M:Goal, Arg1, Arg2), !.
 
-ml_goal(Goal, Elem1, Elem2, call(Goal, Elem1, Elem2)).
+ml_chunk(M, Goal, Chunk1, Chunk2,
+         maplist(once_in_module(M, Goal), Chunk1, Chunk2)).
 
-concurrent_maplist(Goal, List1, List2, List3) :-
+concurrent_maplist(M:Goal, List1, List2, List3) :-
     same_length(List1, List2, List3),
     workers(List1, WorkerCount),
     !,
-    maplist(ml_goal(Goal), List1, List2, List3, Goals),
-    concurrent(WorkerCount, Goals, []).
+    chunks(List1, WorkerCount, Sizes),
+    split_list(Sizes, List1, Chunks1),
+    split_list(Sizes, List2, Chunks2),
+    split_list(Sizes, List3, Chunks3),
+    maplist(ml_chunk(M, Goal), Chunks1, Chunks2, Chunks3, Goals),
+    Helpers is WorkerCount - 1,
+    executor_run(Goals, Helpers).
 concurrent_maplist(M:Goal, List1, List2, List3) :-
     maplist(once_in_module(M, Goal), List1, List2, List3).
 
 once_in_module(M, Goal, Arg1, Arg2, Arg3) :-
     call(M:Goal, Arg1, Arg2, Arg3), !.
 
-ml_goal(Goal, Elem1, Elem2, Elem3, call(Goal, Elem1, Elem2, Elem3)).
+ml_chunk(M, Goal, Chunk1, Chunk2, Chunk3,
+         maplist(once_in_module(M, Goal), Chunk1, Chunk2, Chunk3)).
+
+%!  chunks(+List, +WorkerCount, -Sizes) is det.
+%
+%   Sizes is a list of chunk sizes  that   add  up  to the length of
+%   List.
+
+chunks(List, WorkerCount, Sizes) :-
+    length(List, Len),
+    ChunkCount is min(Len, WorkerCount*4),
+    Size is Len // ChunkCount,
+    Extra is Len mod ChunkCount,
+    length(Sizes, ChunkCount),
+    foldl(chunk_size(Size, Extra), Sizes, 0, _).
+
+chunk_size(Size, Extra, ChunkSize, I0, I) :-
+    (   I0 < Extra
+    ->  ChunkSize is Size + 1
+    ;   ChunkSize = Size
+    ),
+    I is I0 + 1.
+
+split_list([], [], []).
+split_list([Size|Sizes], List, [Chunk|Chunks]) :-
+    length(Chunk, Size),
+    append(Chunk, Rest, List),
+    split_list(Sizes, Rest, Chunks).
 
 workers(List, Count) :-
     current_prolog_flag(cpu_count, Cores),
@@ -352,6 +768,355 @@ same_length([_|T1], [_|T2], [_|T3]) :-
     same_length(T1, T2, T3).
 
 
+                 /*******************************
+                 *      FORALL AND AGGREGATION  *
+                 *******************************/
+
+%!  concurrent_forall(:Cond, :Action) is semidet.
+%!  concurrent_forall(:Cond, :Action, +Options) is semidet.
+%
+%   True when Action is true for all  solutions of Cond.  This is the
+%   same as forall/2, but the instances of Action are executed using
+%   the workers of the executor  used   by  concurrent_maplist/2  and
+%   the calling thread, while the calling  thread enumerates Cond.  The
+%   solutions of Cond are  grouped  in   chunks  of  increasing size,
+%   reducing the communication overhead if Action is cheap.  If some
+%   Action fails or raises an  exception,   the  enumeration of Cond is
+%   stopped as soon as possible and  the   call  fails or re-throws the
+%   exception.  Options:
+%
+%     - threads(+Count)
+%       Use at most Count threads, including the calling thread.
+%       Default is the Prolog flag =cpu_count=.
+%
+%   As with concurrent/3, Action must  be   thread-safe  and  its
+%   variable bindings are lost.
+
+concurrent_forall(Cond, Action) :-
+    concurrent_forall(Cond, Action, []).
+
+concurrent_forall(Cond, Action, Options) :-
+    option_threads(Options, Threads),
+    Threads > 1,
+    !,
+    Helpers is Threads - 1,
+    executor_stream(Cond, Action, forall_job, Helpers, _).
+concurrent_forall(Cond, Action, _) :-
+    forall(Cond, Action).
+
+forall_job(Actions, forall(lists:member(Action, Actions), Action), true).
+
+option_threads(Options, Threads) :-
+    (   option(threads(Threads), Options)
+    ->  must_be(positive_integer, Threads)
+    ;   current_prolog_flag(cpu_count, Threads)
+    ).
+
+%!  concurrent_aggregate_all(+Spec, :Goal, -Result) is semidet.
+%
+%   Concurrent version of aggregate_all/3 from library(aggregate).  If
+%   Goal is a conjunction (Generator, Test), the calling thread
+%   enumerates Generator and the  solutions   are  distributed over the
+%   workers of the executor used by concurrent_maplist/2, which run
+%   Test for their chunk of solutions  and compute a partial aggregate
+%   that is combined by the calling thread.   Other goals are handled
+%   by aggregate_all/3.  Spec is one of `count`,  sum(Expr), max(Expr),
+%   min(Expr), max(Expr, Witness), min(Expr,  Witness), bag(Template)
+%   or set(Template).  The order of the  elements of bag(Template) is
+%   the same as for aggregate_all/3.
+%
+%   Note that the  instances  of  Test  are   copied  to  the  workers.
+%   Generator should thus produce small terms,   while  Test should be
+%   fairly expensive before one reaches a speedup.
+
+concurrent_aggregate_all(Spec, M:Goal, Result) :-
+    aggregate_template(Spec, Template),
+    strip_module(M:Goal, M1, Body),
+    nonvar(Body),
+    Body = (Generator, Test),
+    current_prolog_flag(cpu_count, Threads),
+    Threads > 1,
+    !,
+    Helpers is Threads - 1,
+    executor_stream(M1:Generator, Template-(M1:Test),
+                    aggregate_job(Spec), Helpers, Partials),
+    aggregate_partials(Spec, Partials, Result).
+concurrent_aggregate_all(Spec, Goal, Result) :-
+    aggregate_all(Spec, Goal, Result).
+
+aggregate_template(Spec, _) :-
+    var(Spec),
+    !,
+    instantiation_error(Spec).
+aggregate_template(count,     true).
+aggregate_template(sum(E),    E).
+aggregate_template(max(E),    E).
+aggregate_template(min(E),    E).
+aggregate_template(max(E, W), E-W).
+aggregate_template(min(E, W), E-W).
+aggregate_template(bag(T),    T).
+aggregate_template(set(T),    T).
+
+%   aggregate_job(+Spec, +Items, -Goal, -Partial)
+%
+%   Create the job for a chunk.  Items is a list of Template-Test
+%   and Partial is the aggregate for the solutions of all Tests.
+
+aggregate_job(Spec, Items, aggregate_chunk(Spec, Items, Partial),
+              Partial).
+
+aggregate_chunk(Spec, Items, Partial) :-
+    findall(Template,
+            ( lists:member(Template-Test, Items),
+              call(Test)
+            ),
+            Templates),
+    partial_aggregate(Spec, Templates, Partial).
+
+partial_aggregate(count, Templates, Count) :-
+    length(Templates, Count).
+partial_aggregate(sum(_), Templates, Sum) :-
+    aggregate_all(sum(E), lists:member(E, Templates), Sum).
+partial_aggregate(max(_), Templates, Max) :-
+    (   aggregate_all(max(E), lists:member(E, Templates), Max0)
+    ->  Max = Max0
+    ;   Max = none
+    ).
+partial_aggregate(min(_), Templates, Min) :-
+    (   aggregate_all(min(E), lists:member(E, Templates), Min0)
+    ->  Min = Min0
+    ;   Min = none
+    ).
+partial_aggregate(max(_,_), Templates, Max) :-
+    (   aggregate_all(max(E, W), lists:member(E-W, Templates), Max0)
+    ->  Max = Max0
+    ;   Max = none
+    ).
+partial_aggregate(min(_,_), Templates, Min) :-
+    (   aggregate_all(min(E, W), lists:member(E-W, Templates), Min0)
+    ->  Min = Min0
+    ;   Min = none
+    ).
+partial_aggregate(bag(_), Templates, Templates).
+partial_aggregate(set(_), Templates, Set) :-
+    sort(Templates, Set).
+
+aggregate_partials(count, Partials, Count) :-
+    sum_list(Partials, Count).
+aggregate_partials(sum(_), Partials, Sum) :-
+    sum_list(Partials, Sum).
+aggregate_partials(max(_), Partials, Max) :-
+    exclude(==(none), Partials, Maxes),
+    max_list(Maxes, Max).
+aggregate_partials(min(_), Partials, Min) :-
+    exclude(==(none), Partials, Mins),
+    min_list(Mins, Min).
+aggregate_partials(max(_,_), Partials, Max) :-
+    aggregate_all(max(E, W), lists:member(max(E, W), Partials), Max).
+aggregate_partials(min(_,_), Partials, Min) :-
+    aggregate_all(min(E, W), lists:member(min(E, W), Partials), Min).
+aggregate_partials(bag(_), Partials, Bag) :-
+    append(Partials, Bag).
+aggregate_partials(set(_), Partials, Set) :-
+    append(Partials, Bag),
+    sort(Bag, Set).
+
+
+                 /*******************************
+                 *            FUTURES           *
+                 *******************************/
+
+%   A future is a term future(Queue, Goal, Vars), where Queue is an
+%   anonymous message queue that is reclaimed by atom garbage collection.
+%   Initially Queue holds the token `pending`. The executor worker that
+%   runs the goal or an awaiting thread first claims this token, so a
+%   goal that has not yet started is run by the awaiting thread rather
+%   than blocking it.  This avoids deadlocks if futures are awaited by
+%   jobs of the executor.  The result is stored in Queue as
+%   result(Result).  Threads blocked in await_any/3 ask for a ready(I)
+%   message by adding notify(Ready, I) to Queue.
+
+%!  async(:Goal, -Future) is det.
+%
+%   Schedule Goal for execution by a   worker  of the process-wide
+%   executor that is shared  with  concurrent_maplist/2   and  return  a
+%   Future that can be used  to  wait   for  the  result.  Goal is
+%   executed as once/1 on a copy.  The   result  is  made available to
+%   await/2 by copying it through a message  queue. Goal must thus be
+%   independent from the calling thread, as for concurrent/3.
+
+async(Goal, future(Queue, Goal, Vars)) :-
+    term_variables(Goal, Vars),
+    executor(Executor, _),
+    message_queue_create(Queue),
+    thread_send_message(Queue, pending),
+    thread_send_message(Executor, future(Queue, Goal, Vars)).
+
+%!  await(+Future, -Result) is det.
+%!  await(+Future, -Result, +Options) is semidet.
+%
+%   Wait for Future to  complete.  Result  is   `true`  if  the  goal
+%   succeeded, in which case  the  variables  of   the  goal  passed to
+%   async/2 are unified with the  bindings   of  the  answer, `false`
+%   if the goal failed or exception(Error) if the goal raised Error.  If
+%   the goal has not been started by   the executor and no timeout is
+%   given, it is executed by the   calling thread.  Future may be awaited
+%   multiple times.  Options:
+%
+%     - timeout(+Seconds)
+%       Fail if Future does not complete within Seconds.
+%     - deadline(+AbsTime)
+%       Fail if Future has not completed at AbsTime.
+
+await(Future, Result) :-
+    await(Future, Result, []).
+
+await(Future, Result, Options) :-
+    Future = future(Queue, _, Vars),
+    (   wait_options(Options, WaitOptions),
+        WaitOptions == [],
+        run_pending(Future, Result0)
+    ->  true
+    ;   await_any([Future], _, Options),
+        thread_peek_message(Queue, result(Result0))
+    ),
+    future_status(Result0, Vars, Result).
+
+future_status(true(Vars), Vars, true).
+future_status(false, _, false).
+future_status(exception(Error), _, exception(Error)).
+
+%!  await_all(+Futures, -Results) is det.
+%!  await_all(+Futures, -Results, +Options) is semidet.
+%
+%   Wait for all Futures to complete, where   Results is a list of the
+%   results as returned by await/2.  Options   is  as  for await/3,
+%   where a timeout applies to the entire call.
+
+await_all(Futures, Results) :-
+    await_all(Futures, Results, []).
+
+await_all(Futures, Results, Options) :-
+    deadline_options(Options, AwaitOptions),
+    maplist(await_future(AwaitOptions), Futures, Results).
+
+await_future(Options, Future, Result) :-
+    await(Future, Result, Options).
+
+%!  await_any(+Futures, -Future) is det.
+%!  await_any(+Futures, -Future, +Options) is semidet.
+%
+%   Wait for the first of Futures to complete  and unify Future with it.
+%   The result is obtained using await/2,  which   no  longer blocks.  If
+%   no future has completed, no timeout is  given and there are futures
+%   that have not been started, one of   these is executed by the calling
+%   thread.  Options is as for await/3.
+
+await_any(Futures, Future) :-
+    await_any(Futures, Future, []).
+
+await_any(Futures, Future, _) :-
+    member(Future, Futures),
+    future_done(Future),
+    !.
+await_any(Futures, Future, Options) :-
+    wait_options(Options, WaitOptions),
+    WaitOptions == [],
+    member(Future, Futures),
+    run_pending(Future, _),
+    !.
+await_any(Futures, Future, Options) :-
+    must_be(list, Futures),
+    Futures \== [],
+    wait_options(Options, WaitOptions),
+    message_queue_create(Ready),
+    setup_call_cleanup(
+        forall(nth1(I, Futures, future(Queue, _, _)),
+               thread_send_message(Queue, notify(Ready, I))),
+        (   member(Future, Futures),
+            future_done(Future)
+        ->  true
+        ;   thread_get_message(Ready, ready(I), WaitOptions),
+            nth1(I, Futures, Future)
+        ),
+        ( forall(member(future(Queue, _, _), Futures),
+                 ignore(thread_get_message(Queue, notify(Ready, _),
+                                           [timeout(0)]))),
+          message_queue_destroy(Ready)
+        )).
+
+future_done(future(Queue, _, _)) :-
+    thread_peek_message(Queue, result(_)).
+
+%   wait_options(+Options, -WaitOptions) translates the options of
+%   await/3 into a timeout for thread_get_message/3.  deadline_options/2
+%   translates a timeout into a deadline for a sequence of waits.
+
+wait_options(Options, [timeout(Time)]) :-
+    option(deadline(Deadline), Options),
+    !,
+    get_time(Now),
+    Time is max(0, Deadline-Now).
+wait_options(Options, [timeout(Time)]) :-
+    option(timeout(Time), Options),
+    !.
+wait_options(_, []).
+
+deadline_options(Options, [deadline(Deadline)]) :-
+    option(deadline(Deadline), Options),
+    !.
+deadline_options(Options, [deadline(Deadline)]) :-
+    option(timeout(Time), Options),
+    !,
+    get_time(Now),
+    Deadline is Now+Time.
+deadline_options(_, []).
+
+%!  run_pending(+Future, -Result) is semidet.
+%
+%   Claim Future and run it in the calling thread if it has not yet
+%   been started.  The goal is executed on a copy, such that bindings
+%   are only made by await/2, as if the goal was run by a worker.
+
+run_pending(future(Queue, Goal, Vars), Result) :-
+    thread_get_message(Queue, pending, [timeout(0)]),
+    copy_term(Goal-Vars, Goal1-Vars1),
+    future_result(Goal1, Vars1, Result),
+    complete_future(Queue, Result).
+
+%!  run_future(+Queue, :Goal, +Vars) is det.
+%
+%   Executor request to run a future, unless it was already claimed by
+%   an awaiting thread.
+
+run_future(Queue, Goal, Vars) :-
+    (   thread_get_message(Queue, pending, [timeout(0)])
+    ->  future_result(Goal, Vars, Result),
+        complete_future(Queue, Result)
+    ;   true
+    ).
+
+future_result(Goal, Vars, Result) :-
+    (   catch(Goal, E, true)
+    ->  (   var(E)
+        ->  Result = true(Vars)
+        ;   Result = exception(E)
+        )
+    ;   Result = false
+    ).
+
+complete_future(Queue, Result) :-
+    thread_send_message(Queue, result(Result)),
+    notify_waiters(Queue).
+
+notify_waiters(Queue) :-
+    (   thread_get_message(Queue, notify(Ready, I), [timeout(0)])
+    ->  catch(thread_send_message(Ready, ready(I)), _, true),
+        notify_waiters(Queue)
+    ;   true
+    ).
+
+
                  /*******************************
                  *             FIRST            *
                  *******************************/
@@ -112,6 +112,10 @@ otherwise during startup of the application.
 %   state of a thread. Threads can   be  created both =detached= and
 %   normal and must be joined using   thread_join/2  if they are not
 %   detached.
+%
+%   A pool can be pinned to a NUMA node   by  passing the thread_create/3
+%   option numa_node(Node), e.g., create one pool per node to keep the
+%   threads and their memory on the same node.
 
 thread_pool_create(Name, Size, Options) :-
     must_be(list, Options),
@@ -47,7 +47,13 @@ of these these are in pre-unit test format in the main test.pl
 
 test_io :-
 	run_tests([ io,
-		    stream_pair
+		    stream_pair,
+		    copy_stream_data,
+		    buffer_size,
+		    mmap,
+		    bulk_text,
+		    output_redirect,
+		    read_lines
 		  ]).
 
 :- begin_tests(io, [sto(rational_trees)]).
@@ -119,3 +125,409 @@ test(close, true) :-
 	assertion(var(Out)).
 
 :- end_tests(stream_pair).
+
+:- begin_tests(copy_stream_data, [sto(rational_trees)]).
+
+test(binary, Copy == Data) :-
+	numlist(0, 255, Bytes),
+	findall(B, (between(1, 100, _), member(B, Bytes)), Data),
+	copy_file_data(Data, Copy, [type(binary)], [type(binary)], -).
+test(utf8, Copy == Data) :-
+	text_data(Data),
+	copy_file_data(Data, Copy, [encoding(utf8)], [encoding(utf8)], -).
+test(transcode, Copy == Data) :-
+	text_data(Data),
+	copy_file_data(Data, Copy, [encoding(utf8)], [encoding(wchar_t)], -).
+test(len_utf8, Copy == Prefix) :-
+	text_data(Data),
+	length(Prefix, 100),
+	append(Prefix, _, Data),
+	copy_file_data(Data, Copy, [encoding(utf8)], [encoding(utf8)], 100).
+test(len_octet, Copy == Prefix) :-
+	numlist(0, 255, Data),
+	length(Prefix, 100),
+	append(Prefix, _, Data),
+	copy_file_data(Data, Copy, [type(binary)], [type(binary)], 100).
+test(position, Pos == 101-1900) :-
+	text_data(Data),
+	setup_call_cleanup(
+	    tmp_file_stream(utf8, File, Out),
+	    format(Out, '~s', [Data]),
+	    close(Out)),
+	setup_call_cleanup(
+	    open(File, read, In, [encoding(utf8)]),
+	    ( with_output_to(string(_),
+			     ( copy_stream_data(In, current_output),
+			       line_count(current_output, Lines)
+			     )),
+	      character_count(In, Chars)
+	    ),
+	    close(In)),
+	delete_file(File),
+	Pos = Lines-Chars.
+
+text_data(Data) :-
+	findall(C,
+		( between(1, 100, _),
+		  member(C, `h\u00e9llo \u20ac w\u00f6rld\tline\n`)
+		), Data).
+
+copy_file_data(Data, Copy, InOptions, OutOptions, Len) :-
+	tmp_file(copy_in, In),
+	tmp_file(copy_out, Out),
+	setup_call_cleanup(
+	    open(In, write, S0, InOptions),
+	    forall(member(C, Data), put_code_or_byte(S0, C)),
+	    close(S0)),
+	setup_call_cleanup(
+	    open(In, read, S1, InOptions),
+	    setup_call_cleanup(
+		open(Out, write, S2, OutOptions),
+		(   Len == (-)
+		->  copy_stream_data(S1, S2)
+		;   copy_stream_data(S1, S2, Len)
+		),
+		close(S2)),
+	    close(S1)),
+	setup_call_cleanup(
+	    open(Out, read, S3, OutOptions),
+	    read_all(S3, Copy),
+	    close(S3)),
+	delete_file(In),
+	delete_file(Out).
+
+put_code_or_byte(S, C) :-
+	(   stream_property(S, type(binary))
+	->  put_byte(S, C)
+	;   put_code(S, C)
+	).
+
+read_all(S, Data) :-
+	(   stream_property(S, type(binary))
+	->  get_byte(S, C)
+	;   get_code(S, C)
+	),
+	(   C == -1
+	->  Data = []
+	;   Data = [C|T],
+	    read_all(S, T)
+	).
+
+:- end_tests(copy_stream_data).
+
+:- begin_tests(buffer_size, [sto(rational_trees)]).
+
+test(open, Size == 1000) :-
+	setup_call_cleanup(
+	    tmp_file_stream(binary, File, Out),
+	    ( open(File, read, In, [type(binary), buffer_size(1000)]),
+	      stream_property(In, buffer_size(Size)),
+	      close(In)
+	    ),
+	    ( close(Out),
+	      delete_file(File)
+	    )).
+test(open, error(domain_error(not_less_than_one, 0))) :-
+	setup_call_cleanup(
+	    tmp_file_stream(binary, File, Out),
+	    open(File, read, _, [buffer_size(0)]),
+	    ( close(Out),
+	      delete_file(File)
+	    )).
+test(flag, error(domain_error(not_less_than_one, 0))) :-
+	set_prolog_flag(stream_buffer_size, 0).
+test(adaptive, [Data == Copy, Calls < 100]) :-
+	numlist(0, 255, Bytes),
+	findall(B, (between(1, 4000, _), member(B, Bytes)), Data),
+	setup_call_cleanup(
+	    tmp_file_stream(binary, File, Out),
+	    ( forall(member(B, Data), put_byte(Out, B)),
+	      close(Out),
+	      setup_call_cleanup(
+		  open(File, read, In, [type(binary)]),
+		  ( read_all(In, Copy),
+		    stream_property(In, syscalls(Calls-0))
+		  ),
+		  close(In))
+	    ),
+	    delete_file(File)).
+
+test(peek, Terms == [A, b]) :-		% end of term at end of buffer
+	length(Codes, 4095),
+	maplist(=(0'x), Codes),
+	atom_codes(A, Codes),
+	setup_call_cleanup(
+	    tmp_file_stream(text, File, Out),
+	    ( format(Out, '~w.~nb.~n', [A]),
+	      close(Out),
+	      setup_call_cleanup(
+		  open(File, read, In),
+		  ( read(In, T1),
+		    read(In, T2),
+		    Terms = [T1,T2]
+		  ),
+		  close(In))
+	    ),
+	    delete_file(File)).
+
+read_all(S, Data) :-
+	get_byte(S, C),
+	(   C == -1
+	->  Data = []
+	;   Data = [C|T],
+	    read_all(S, T)
+	).
+
+:- end_tests(buffer_size).
+
+:- begin_tests(mmap, [sto(rational_trees)]).
+
+test(read, Terms == [a(1), b("two"), c([x,y])]) :-
+	mmap_file(File, 'a(1).\nb("two").\nc([x,y]).\n'),
+	setup_call_cleanup(
+	    open(File, read, In, [mmap(true)]),
+	    findall(T, (repeat, read(In, T), (T == end_of_file -> !, fail ; true)),
+		    Terms),
+	    close(In)),
+	delete_file(File).
+test(seek, Chars == [b,c,a,b]) :-
+	mmap_file(File, abcdef),
+	setup_call_cleanup(
+	    open(File, read, In, [mmap(true)]),
+	    ( seek(In, 1, bof, _),
+	      get_char(In, C1),
+	      get_char(In, C2),
+	      seek(In, 0, bof, _),
+	      get_char(In, C3),
+	      peek_char(In, C4)
+	    ),
+	    close(In)),
+	delete_file(File),
+	Chars = [C1,C2,C3,C4].
+test(position, Line-Rest == 2-"def") :-
+	mmap_file(File, 'abc\ndef'),
+	setup_call_cleanup(
+	    open(File, read, In, [mmap(true)]),
+	    ( read_line_to_string(In, _),
+	      stream_property(In, position(Pos)),
+	      read_string(In, _, _),
+	      set_stream_position(In, Pos),
+	      line_count(In, Line),
+	      read_string(In, _, Rest)
+	    ),
+	    close(In)),
+	delete_file(File).
+test(empty, T == end_of_file) :-
+	mmap_file(File, ''),
+	setup_call_cleanup(
+	    open(File, read, In, [mmap(true)]),
+	    read(In, T),
+	    close(In)),
+	delete_file(File).
+
+mmap_file(File, Text) :-
+	setup_call_cleanup(
+	    tmp_file_stream(text, File, Out),
+	    write(Out, Text),
+	    close(Out)).
+
+:- end_tests(mmap).
+
+:- begin_tests(bulk_text, [sto(rational_trees)]).
+
+test(read_string, Lines-Pos == ["abc", "d\u00e9f", "", "xyz"]-(4-13)) :-
+	bulk_file(File, "abc\r\nd\u00e9f\n\nxyz"),
+	setup_call_cleanup(
+	    open(File, read, In, [encoding(utf8)]),
+	    ( findall(L, bulk_line(In, L), Lines),
+	      line_count(In, LineNo),
+	      character_count(In, Chars)
+	    ),
+	    close(In)),
+	delete_file(File),
+	Pos = LineNo-Chars.
+test(read_string, S-Line == "ab\u00e9"-2) :-
+	bulk_file(File, "ab\u00e9\ncd"),
+	setup_call_cleanup(
+	    open(File, read, In, [encoding(utf8)]),
+	    ( read_string(In, 3, S),
+	      get_char(In, _),
+	      line_count(In, Line)
+	    ),
+	    close(In)),
+	delete_file(File).
+test(nul_separator, Records == [Expected, Expected]) :-
+	Expected = [0-"abc", 0-"", 0-"def", -1-"ghi"],
+	bulk_file(File, "abc\u0000\u0000def\u0000ghi"),
+	findall(Recs,
+		( member(Enc, [utf8, octet]),
+		  setup_call_cleanup(
+		      open(File, read, In, [encoding(Enc)]),
+		      findall(Sep-Rec, nul_record(In, Sep, Rec), Recs),
+		      close(In))
+		),
+		Records),
+	delete_file(File).
+test(write, S == "f(abc,'h \u00e9',\"str\")\n") :-
+	with_output_to(string(S),
+		       ( writeq(f(abc,'h \u00e9',"str")), nl )).
+test(write, Codes == `ab\u00e9\ncd`) :-
+	setup_call_cleanup(
+	    tmp_file_stream(utf8, File, Out),
+	    write(Out, 'ab\u00e9\ncd'),
+	    close(Out)),
+	read_file_to_codes(File, Codes, [encoding(utf8)]),
+	delete_file(File).
+test(write, Codes == `a\r\nb\r\n`) :-
+	setup_call_cleanup(
+	    tmp_file_stream(binary, File, Out0),
+	    true,
+	    close(Out0)),
+	setup_call_cleanup(
+	    open(File, write, Out),
+	    ( set_stream(Out, newline(dos)),
+	      write(Out, 'a\nb\n')
+	    ),
+	    close(Out)),
+	read_file_to_codes(File, Codes, [type(binary)]),
+	delete_file(File).
+
+bulk_file(File, Text) :-
+	setup_call_cleanup(
+	    tmp_file_stream(utf8, File, Out),
+	    write(Out, Text),
+	    close(Out)).
+
+bulk_line(In, Line) :-
+	repeat,
+	read_string(In, "\n", "\r", Sep, Line0),
+	(   Sep == -1
+	->  !,
+	    Line0 \== "",
+	    Line = Line0
+	;   Line = Line0
+	).
+
+nul_record(In, Sep, Record) :-
+	repeat,
+	read_string(In, "\u0000", "", Sep, Record),
+	(   Sep == -1
+	->  !
+	;   true
+	).
+
+:- end_tests(bulk_text).
+
+:- begin_tests(output_redirect, [sto(rational_trees)]).
+
+test(atom, A == 'x-42') :-
+	format(atom(A), '~w-~w', [x, 42]).
+test(widen, S == "abc\u00e9\u0416def") :-
+	with_output_to(string(S),
+		       ( write(abc), put_char('\u00e9'),
+			 put_char('\u0416'), write(def) )).
+test(widen, Len-Last == 5001-0'\u0416) :-
+	with_output_to(codes(Codes),
+		       ( forall(between(1, 5000, _), put_char(a)),
+			 put_char('\u0416') )),
+	length(Codes, Len),
+	last(Codes, Last).
+test(quoted, A == '\u03b1\u03b2') :-
+	format(atom(A), '~q', ['\u03b1\u03b2']).
+test(quoted, A == '\'\u0416 x\'') :-
+	format(atom(A), '~q', ['\u0416 x']).
+test(nested, S == "outer(inner)") :-
+	with_output_to(string(S),
+		       ( with_output_to(string(I), write(inner)),
+			 write(outer(I)) )).
+test(diff, Tail == [x]) :-
+	with_output_to(codes(Codes, Tail0), write(ab)),
+	Tail0 = [x],
+	Codes = [0'a, 0'b|Tail].
+test(reuse, S == "after") :-
+	catch(with_output_to(string(_), (write(x), throw(oops))), oops, true),
+	\+ with_output_to(string(_), (write(y), fail)),
+	with_output_to(string(S), write(after)).
+test(closed, error(existence_error(stream, S))) :-
+	with_output_to(string(_), current_output(S)),
+	write(S, x).
+test(encoding, L == ["abcd", "abcd", "abcd"]) :-
+	findall(S,
+		( member(Enc, [wchar_t, octet, utf8]),
+		  with_output_to(string(S),
+				 ( write(abc),
+				   current_output(Out),
+				   set_stream(Out, encoding(Enc)),
+				   write(d) ))
+		), L).
+test(encoding, S == "\u00e9\u4e2dd\u00e9x") :-
+	with_output_to(string(S),
+		       ( write('\u00e9\u4e2d'),
+			 current_output(Out),
+			 set_stream(Out, encoding(utf8)),
+			 write(d), put_char('\u00e9'),
+			 set_stream(Out, encoding(wchar_t)),
+			 write(x) )).
+test(encoding, A == abc) :-
+	with_output_to(atom(A),
+		       ( current_output(Out),
+			 set_stream(Out, encoding(wchar_t)),
+			 write(abc) )).
+test(encoding, error(permission_error(encoding, stream, _))) :-
+	with_output_to(string(_),
+		       ( write('\u4e2d'),
+			 current_output(Out),
+			 set_stream(Out, encoding(iso_latin_1)) )).
+
+:- end_tests(output_redirect).
+
+:- begin_tests(read_lines, [sto(rational_trees)]).
+
+test(batch, Batches == [["a","bb"], ["","c\u00e9","last"], []]) :-
+	bulk_file(File, "a\r\nbb\n\nc\u00e9\r\nlast"),
+	setup_call_cleanup(
+	    open(File, read, In, [encoding(utf8)]),
+	    ( read_lines_to_strings(In, 2, L1),
+	      read_lines_to_strings(In, 10, L2),
+	      read_lines_to_strings(In, 10, L3)
+	    ),
+	    close(In)),
+	delete_file(File),
+	Batches = [L1,L2,L3].
+test(same, Lines == Lines2) :-
+	bulk_file(File, "one\ntwo\r\n\r\nthree\n"),
+	setup_call_cleanup(
+	    open(File, read, In),
+	    read_lines_to_strings(In, 100, Lines),
+	    close(In)),
+	setup_call_cleanup(
+	    open(File, read, In2),
+	    findall(L, line(In2, L), Lines2),
+	    close(In2)),
+	delete_file(File).
+test(records, Records == ["x","y","","z"]) :-
+	open_string("x,y,,z\n", In),
+	read_lines_to_strings(In, 10, Records,
+			      [ separators(",\n"), padding("") ]).
+test(nul, Records-Rest == ["a","","b c"]-"") :-
+	open_string("a\u0000\u0000b c\u0000", In),
+	read_lines_to_strings(In, 10, Records,
+			      [ separators("\u0000"), padding("") ]),
+	read_string(In, _, Rest).
+test(max, Lines-Rest == []-"x\ny\n") :-
+	open_string("x\ny\n", In),
+	read_lines_to_strings(In, 0, Lines),
+	read_string(In, _, Rest).
+test(max, error(domain_error(not_less_than_zero, -1))) :-
+	open_string("x", In),
+	read_lines_to_strings(In, -1, _).
+
+line(In, Line) :-
+	repeat,
+	read_line_to_string(In, Line0),
+	(   Line0 == end_of_file
+	->  !, fail
+	;   Line = Line0
+	).
+
+:- end_tests(read_lines).
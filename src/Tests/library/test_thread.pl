@@ -40,6 +40,7 @@ test_thread :-
 
 :- use_module(library(plunit)).
 :- use_module(library(thread)).
+:- use_module(library(aggregate)).
 
 :- begin_tests(thread, [condition(current_prolog_flag(threads,true))]).
 
@@ -53,11 +54,74 @@ test(fail, fail) :-
 	concurrent(2, [_A=3, fail, _B = 4], []).
 test(error, throws(x)) :-
 	concurrent(2, [_A=3, throw(x), _B = 4], []).
+test(abandon, true(Time < 2)) :-
+	get_time(T0),
+	\+ concurrent(2, [sleep(3), (sleep(0.1),fail)], [executor(true)]),
+	get_time(T1),
+	Time is T1-T0.
 test(concur, true) :-
 	forall(between(0, 20, _),
 	       (   concurrent(2, [X=1,Y=2], []),
 		   ground(X-Y))).
 
+test(busy, true) :-
+	current_prolog_flag(cpu_count, N),
+	message_queue_create(Gate),
+	findall(F, (between(1, N, _), async(thread_get_message(Gate, go), F)),
+		Futures),
+	message_queue_create(Q),
+	call_cleanup(
+	    concurrent(2, [thread_get_message(Q, x), thread_send_message(Q, x)],
+		       []),
+	    ( forall(member(_, Futures), thread_send_message(Gate, go)),
+	      await_all(Futures, _),
+	      message_queue_destroy(Q),
+	      message_queue_destroy(Gate))).
+test(concur, true([A,B]==[1,2])) :-
+	concurrent(2, [A=1,B=2], [stack_limit(100 000 000)]).
+
+test(maplist, true(L2==L3)) :-
+	numlist(1, 1000, L1),
+	maplist(succ, L1, L2),
+	concurrent_maplist(succ, L1, L3).
+test(maplist, fail) :-
+	numlist(1, 1000, L),
+	concurrent_maplist([X]>>(X < 900), L).
+test(maplist, throws(x)) :-
+	numlist(1, 1000, L),
+	concurrent_maplist([X]>>(X == 500 -> throw(x) ; true), L).
+test(maplist, true(L4==[3,6,9])) :-
+	concurrent_maplist([X,Y,Z]>>(Z is X+Y), [1,2,3], [2,4,6], L4).
+test(maplist, true(Sums==[1,3,6,10,15,21,28,36])) :-
+	numlist(1, 8, L),
+	concurrent_maplist(nested_sum, L, Sums).
+
+test(forall, true) :-
+	concurrent_forall(between(1, 1000, X), X > 0).
+test(forall, fail) :-
+	concurrent_forall(between(1, 1000, X), X < 900, [threads(2)]).
+test(forall, throws(x)) :-
+	concurrent_forall(between(1, inf, X), (X == 500 -> throw(x) ; true)).
+
+test(aggregate, true(Count==Count0)) :-
+	aggregate_all(count, (between(1, 1000, X), X mod 3 =:= 0), Count0),
+	concurrent_aggregate_all(count, (between(1, 1000, X), X mod 3 =:= 0),
+				 Count).
+test(aggregate, true(Sum==500500)) :-
+	concurrent_aggregate_all(sum(X), (between(1, 1000, X), true), Sum).
+test(aggregate, true(Max==max(1000,x(1000)))) :-
+	concurrent_aggregate_all(max(X, x(X)), (between(1, 1000, X), true), Max).
+test(aggregate, true(Bag==L)) :-
+	numlist(1, 1000, L),
+	concurrent_aggregate_all(bag(X), (member(X, L), integer(X)), Bag).
+test(aggregate, fail) :-
+	concurrent_aggregate_all(max(X), (between(1, 10, X), X > 20), _).
+
+nested_sum(N, Sum) :-
+	numlist(1, N, L),
+	concurrent_maplist(=, L, L2),
+	sum_list(L2, Sum).
+
 test(first, true(X==1)) :-
 	first_solution(X, [X=1,X=1], []).
 test(first, fail) :-
@@ -67,4 +131,42 @@ test(first, true(X==1)) :-
 test(first, true(X==1)) :-
 	first_solution(X, [(repeat,fail), X=1], []).
 
+test(future, true(R-X==true-1)) :-
+	async(X = 1, F),
+	await(F, R).
+test(future, true(R==false)) :-
+	async(fail, F),
+	await(F, R).
+test(future, true(R==exception(x))) :-
+	async(throw(x), F),
+	await(F, R).
+test(future, true(R1-R2==true-true)) :-
+	async(true, F),
+	await(F, R1),
+	await(F, R2).
+test(future, fail) :-
+	async(sleep(1), F),
+	sleep(0.1),
+	await(F, _, [timeout(0.05)]).
+test(future, true(Vs==[1,4,9,16,25,36,49,64,81,100])) :-
+	numlist(1, 10, L),
+	maplist([I,V,F]>>async(V is I*I, F), L, Vs, Fs),
+	await_all(Fs, Rs),
+	maplist(==(true), Rs).
+test(future, true(R==true)) :-
+	async(sleep(0.2), F1),
+	async(true, F2),
+	await_any([F1,F2], F),
+	memberchk(F, [F1,F2]),
+	await(F, R, [timeout(0)]).
+test(future, true(Rs==[true,true,true,true])) :-
+	length(Fs, 4),
+	maplist([F]>>async(nested_future, F), Fs),
+	await_all(Fs, Rs).
+
+nested_future :-
+	findall(F, (between(1, 8, I), async(succ(I, _), F)), Fs),
+	await_all(Fs, Rs),
+	maplist(==(true), Rs).
+
 :- end_tests(thread).
@@ -70,11 +70,17 @@ test_tabling :-
 		tabling_minpath,
 		tabling_maxpath,
 		tabling_train,
+		tabling_aggregate,
 		moded_tabling_path,
 						% tests requiring sub components
 		mode_components1,
 		mode_components2,
-                pathss
+                pathss,
+						% table space management
+		table_space,
+						% concurrent evaluation
+		table_concurrent,
+		table_statistics
 	      ]).
 
 		 /*******************************
@@ -1118,6 +1124,38 @@ test(tabling_maxpath, N =:= 2) :-
 
 :- end_tests(tabling_maxpath).
 
+:- begin_tests(tabling_aggregate, [cleanup(abolish_all_tables)]).
+:- table
+    agg_count(_,count),
+    agg_sum(_,sum),
+    agg_big(_,sum),
+    agg_last(_,last),
+    agg_minmax(_,min,max).
+
+agg_count(X, _) :- agg_data(X, _).
+agg_sum(X, V) :- agg_data(X, V).
+agg_big(x, V) :- member(V, [9223372036854775807, 1]).
+agg_last(X, V) :- agg_data(X, V).
+agg_minmax(X, V, V) :- agg_data(X, V).
+
+agg_data(a, 1).
+agg_data(a, 5).
+agg_data(a, 2).
+agg_data(b, 3).
+
+test(count, N == 3) :-
+    agg_count(a, N).
+test(sum, S == 8) :-
+    agg_sum(a, S).
+test(sum_big, S == 9223372036854775808) :-
+    agg_big(x, S).
+test(last, V == 2) :-
+    agg_last(a, V).
+test(minmax, Min-Max == 1-5) :-
+    agg_minmax(a, Min, Max).
+
+:- end_tests(tabling_aggregate).
+
 :- begin_tests(tabling_train, [cleanup(abolish_all_tables)]).
 :- table train(_,_,lattice(shortest/3)).
 
@@ -1305,6 +1343,130 @@ test(kurt, P3 = [ [bernd, ingo, kurt],
 :- end_tests(pathss).
 
 
+		 /*******************************
+		 *	    TABLE SPACE		*
+		 *******************************/
+
+:- begin_tests(table_space, [cleanup(abolish_all_tables)]).
+
+:- table upto/2.
+
+upto(N, X) :- between(1, N, X).
+
+count_upto(N) :-
+    aggregate_all(count, upto(N, _), N).
+
+test(evict, Evicted > 0) :-
+    abolish_all_tables,
+    current_prolog_flag(table_space, Old),
+    statistics(table_space_evictions, E0),
+    setup_call_cleanup(
+        set_prolog_flag(table_space, 100000),
+        forall(between(1, 200, N), count_upto(N)),
+        set_prolog_flag(table_space, Old)),
+    statistics(table_space_evictions, E1),
+    Evicted is E1-E0.
+test(consume, Count == 10) :-
+    abolish_all_tables,
+    current_prolog_flag(table_space, Old),
+    setup_call_cleanup(
+        set_prolog_flag(table_space, 50000),
+        aggregate_all(count,
+                      ( upto(200, X),
+                        X mod 20 =:= 0,
+                        count_upto(X)
+                      ), Count),
+        set_prolog_flag(table_space, Old)).
+test(predicate_limit, Used =< 20000) :-
+    abolish_all_tables,
+    setup_call_cleanup(
+        set_table_space_limit(upto/2, 20000),
+        ( forall(between(1, 100, N), count_upto(N)),
+          table_space_limit(upto/2, 20000, Used)
+        ),
+        set_table_space_limit(upto/2, infinite)).
+
+:- end_tests(table_space).
+
+
+		 /*******************************
+		 *     CONCURRENT EVALUATION	*
+		 *******************************/
+
+:- begin_tests(table_concurrent, [cleanup(abolish_all_tables)]).
+
+:- table reach/2.
+
+reach(X, Y) :- step(X, Y).
+reach(X, Y) :- reach(X, Z), step(Z, Y).
+
+step(X, Y) :- between(1, 50, X), Y is (X*7+3) mod 50.
+step(X, Y) :- between(1, 50, X), Y is (X*13+1) mod 50.
+
+reach_count(N) :-
+    aggregate_all(count, (between(1, 20, I), reach(I, _)), N).
+
+test(import, Count == Expected) :-
+    abolish_all_tables,
+    reach_count(Expected),
+    abolish_all_tables,
+    findall(reach(I,_), between(1, 20, I), Goals),
+    table_concurrent(Goals, [threads(4)]),
+    aggregate_all(count,
+                  ( current_table(_:reach(_,_), Trie),
+                    '$tbl_table_status'(Trie, complete, _, _)
+                  ), 20),
+    reach_count(Count).
+test(error, throws(table_error)) :-
+    table_concurrent([reach(1,_), throw(table_error)], [threads(2)]).
+test(threads, error(type_error(positive_integer, 0))) :-
+    table_concurrent([reach(1,_)], [threads(0)]).
+
+:- end_tests(table_concurrent).
+
+
+		 /*******************************
+		 *	    STATISTICS		*
+		 *******************************/
+
+:- begin_tests(table_statistics, [cleanup(abolish_all_tables)]).
+
+:- table tfib/2.
+
+tfib(0, 0).
+tfib(1, 1).
+tfib(N, F) :-
+    N > 1,
+    N1 is N-1,
+    N2 is N-2,
+    tfib(N1, F1),
+    tfib(N2, F2),
+    F is F1+F2.
+
+test(reused, Reused-Answers == 2-1) :-
+    abolish_all_tables,
+    setup_call_cleanup(
+        set_prolog_flag(table_statistics, true),
+        ( tfib(20, _),
+          tfib(20, _),
+          tfib(20, _)
+        ),
+        set_prolog_flag(table_statistics, false)),
+    table_statistics(tfib(20, _), Stats),
+    memberchk(reused(Reused), Stats),
+    memberchk(answers(Answers), Stats).
+test(top, Keys == [1,1,1]) :-
+    abolish_all_tables,
+    setup_call_cleanup(
+        set_prolog_flag(table_statistics, true),
+        tfib(20, _),
+        set_prolog_flag(table_statistics, false)),
+    table_statistics_top(reused, 3, Top),
+    pairs_keys(Top, Keys).
+
+:- end_tests(table_statistics).
+
+
 		 /*******************************
 		 *	      COMMON		*
 		 *******************************/
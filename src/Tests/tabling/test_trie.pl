@@ -120,6 +120,76 @@ test(delete, Keys == [aap,mies]) :-
 	assertion(N==n),
 	findall(K, trie_gen(T, K, _), Keys0),
 	sort(Keys0, Keys).
+test(delete_prune, Nodes == 0) :-
+	trie_new(T),
+	forall(between(1, 1000, I),
+	       ( trie_insert(T, f(I,x,y), I),
+		 trie_delete(T, f(I,x,y), _) )),
+	trie_property(T, node_count(Nodes)).
+
+test(save_load, Pairs =@= Pairs0) :-
+	trie_new(T),
+	forall(between(1, 100, I),
+	       ( atom_concat(a, I, A),
+		 F is I/3,
+		 trie_insert(T, k(I, A, "s", F, f(_,X,X)), v(I)) )),
+	trie_insert(T, aap, noot),
+	findall(K-V, trie_gen(T, K, V), Pairs1),
+	msort(Pairs1, Pairs0),
+	image_copy(T, M),
+	findall(K-V, trie_gen(M, K, V), Pairs2),
+	msort(Pairs2, Pairs).
+test(load_lookup, V-W == v(7)-noot) :-
+	trie_new(T),
+	forall(between(1, 10, I),
+	       trie_insert(T, k(I, "s", f(_,X,X)), v(I))),
+	trie_insert(T, aap, noot),
+	image_copy(T, M),
+	trie_lookup(M, k(7, "s", f(_,Y,Y)), V),
+	trie_lookup(M, aap, W),
+	assertion(\+ trie_lookup(M, k(7, "s", f(_,_,_)), _)),
+	assertion(\+ trie_lookup(M, mies, _)).
+test(load_readonly, error(permission_error(modify, trie, M))) :-
+	trie_new(T),
+	trie_insert(T, aap, noot),
+	image_copy(T, M),
+	trie_insert(M, mies, wim).
+
+test(load_corrupt, error(domain_error(trie_image, File))) :-
+	trie_new(T),
+	trie_insert(T, k(1, "s"), v(1)),
+	tmp_file(trie, File),
+	trie_save(T, File),
+	call_cleanup(
+	    ( corrupt_children(File),
+	      trie_load(File, _)
+	    ),
+	    delete_file(File)).
+
+%	corrupt_children(+File)
+%
+%	Make the child index of the root node of a trie image point
+%	outside the node array.  The root node follows the 56 byte
+%	header and its child index is at offset 16 in the node.
+
+corrupt_children(File) :-
+	setup_call_cleanup(
+	    open(File, read, In, [type(binary)]),
+	    read_stream_to_codes(In, Bytes),
+	    close(In)),
+	length(Before, 72),
+	append(Before, [_,_,_,_|After], Bytes),
+	append(Before, [255,255,0,0|After], Corrupt),
+	setup_call_cleanup(
+	    open(File, write, Out, [type(binary)]),
+	    forall(member(B, Corrupt), put_byte(Out, B)),
+	    close(Out)).
+
+image_copy(Trie, Copy) :-
+	tmp_file(trie, File),
+	trie_save(Trie, File),
+	call_cleanup(trie_load(File, Copy),
+		     delete_file(File)).
 
 shared_list(N, t(List,N)) :-
 	length(List, N),
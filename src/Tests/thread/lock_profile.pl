@@ -0,0 +1,74 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(lock_profile,
+	  [ lock_profile/0
+	  ]).
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Test lock profiling (Prolog flag lock_profile and lock_statistics/1).
+Several threads compete for a mutex using with_mutex/2. With sampling
+every acquisition, the number of timed acquisitions must be exact and
+the histograms must account for all of them.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+lock_profile :-
+	current_prolog_flag(lock_profile, Old),
+	setup_call_cleanup(
+	    mutex_create(M),
+	    setup_call_cleanup(
+		set_prolog_flag(lock_profile, 1),
+		profile_test(M),
+		set_prolog_flag(lock_profile, Old)),
+	    mutex_destroy(M)).
+
+profile_test(M) :-
+	findall(Id, (between(1, 4, _), thread_create(work(M), Id, [])), Ids),
+	maplist(joined, Ids),
+	lock_statistics(Locks),
+	memberchk(lock(mutex(M), 400, C, W, H, WH, HH), Locks),
+	integer(C), C =< 400,
+	float(W), float(H),
+	sum_list(WH, 400),
+	sum_list(HH, 400),
+	catch(set_prolog_flag(lock_profile, -1),
+	      error(domain_error(lock_profile, -1), _), true),
+	current_prolog_flag(lock_profile, 1).
+
+work(M) :-
+	forall(between(1, 100, _),
+	       with_mutex(M, numlist(1, 100, _))).
+
+joined(Id) :-
+	thread_join(Id, Status),
+	Status == true.
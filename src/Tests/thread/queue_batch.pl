@@ -0,0 +1,101 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+:- module(queue_batch,
+	  [ queue_batch/0
+	  ]).
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Test thread_send_messages/2 and thread_get_messages/3,4 on unbounded and
+bounded queues.  Messages must arrive in the order they were sent and a
+batch sent to an unbounded queue is not interleaved with other messages.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+queue_batch :-
+	batch_basic,
+	batch_bounded,
+	batch_threads.
+
+batch_basic :-
+	message_queue_create(Q),
+	thread_send_messages(Q, [a, b(1), c]),
+	thread_send_message(Q, d),
+	thread_send_messages(Q, []),
+	thread_get_messages(Q, L1, 2),
+	L1 == [a, b(1)],
+	thread_get_messages(Q, L2, 10),
+	L2 == [c, d],
+	\+ thread_get_messages(Q, _, 1, [timeout(0)]),
+	catch(thread_get_messages(Q, _, 0), error(domain_error(_,_),_), true),
+	message_queue_property(Q, size(0)),
+	message_queue_destroy(Q).
+
+batch_bounded :-
+	message_queue_create(Q, [max_size(3)]),
+	numlist(1, 100, List),
+	thread_create(thread_send_messages(Q, List), Id, []),
+	collect(Q, 100, Received),
+	thread_join(Id, true),
+	message_queue_destroy(Q),
+	Received == List.
+
+collect(_, 0, []) :- !.
+collect(Q, N, List) :-
+	thread_get_messages(Q, Batch, 7),
+	length(Batch, Len),
+	N1 is N - Len,
+	append(Batch, Rest, List),
+	collect(Q, N1, Rest).
+
+batch_threads :-
+	message_queue_create(Q),
+	findall(Id,
+		( between(1, 4, _),
+		  thread_create(forall(between(1, 100, _),
+				       ( numlist(1, 10, L),
+					 thread_send_messages(Q, L)
+				       )), Id, [])
+		), Producers),
+	thread_create(( collect(Q, 4000, Received),
+			batches(Received)
+		      ), Consumer, []),
+	maplist(thread_join, Producers),
+	thread_join(Consumer, true),
+	message_queue_destroy(Q).
+
+%	messages of thread_send_messages/2 are added together
+
+batches([]).
+batches([1,2,3,4,5,6,7,8,9,10|T]) :-
+	batches(T).
@@ -0,0 +1,95 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+:- module(queue_mpmc,
+	  [ queue_mpmc/0,
+	    queue_mpmc/3			% +Producers, +Consumers, +Count
+	  ]).
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Test many producers and consumers on  an  unbounded  queue.  Messages to
+such queues are sent without locking the queue and readers waiting  with
+an unbound message are woken one  at  a  time.  We  verify  no  message
+is lost or duplicated and that a  selective  reader on the same queue is
+still woken.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+queue_mpmc :-
+	queue_mpmc(4, 4, 2000),
+	queue_mpmc(1, 6, 2000),
+	queue_mpmc(6, 1, 2000).
+
+queue_mpmc(P, C, N) :-
+	message_queue_create(Q),
+	message_queue_create(Results),
+	findall(Id,
+		( between(1, C, _),
+		  thread_create(consume(Q, Results), Id, [])
+		), Consumers),
+	findall(Id,
+		( between(1, P, _),
+		  thread_create(produce(Q, N), Id, [])
+		), Producers),
+	maplist(thread_join, Producers),
+	forall(between(1, C, _), thread_send_message(Q, done)),
+	findall(S, (between(1, C, _), thread_get_message(Results, sum(S))), Sums),
+	maplist(thread_join, Consumers),
+	sum_list(Sums, Sum),
+	Sum =:= P*N*(N+1)//2,
+	message_queue_property(Q, size(0)),
+	thread_create(thread_get_message(Q, selective(_)), Selective, []),
+	thread_send_message(Q, other),
+	thread_send_message(Q, selective(42)),
+	thread_join(Selective, true),
+	thread_get_message(Q, Other),
+	message_queue_destroy(Q),
+	message_queue_destroy(Results),
+	Other == other.
+
+produce(Q, N) :-
+	forall(between(1, N, I),
+	       thread_send_message(Q, msg(I))).
+
+consume(Q, Results) :-
+	consume(Q, 0, Sum),
+	thread_send_message(Results, sum(Sum)).
+
+consume(Q, Sum0, Sum) :-
+	thread_get_message(Q, Msg),
+	(   Msg = msg(I)
+	->  Sum1 is Sum0+I,
+	    consume(Q, Sum1, Sum)
+	;   Msg == done
+	->  Sum = Sum0
+	).
@@ -0,0 +1,101 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(rwlock,
+	  [ rwlock/0
+	  ]).
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Test read/write locks. Writers update   two  facts that must always be
+equal. Readers check the invariant under  with_read_lock/2 and using
+with_optimistic_read/2, which must retry   if  a writer interfered. Also
+tests nested locking, error handling and destruction.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+:- dynamic
+	a/1, b/1.
+
+rwlock :-
+	rwlock(reader),
+	rwlock(writer),
+	errors.
+
+rwlock(Prefer) :-
+	retractall(a(_)), retractall(b(_)),
+	assertz(a(0)), assertz(b(0)),
+	rwlock_create(L, [prefer(Prefer)]),
+	findall(Id, (between(1, 4, _), thread_create(reader(L), Id, [])), Rs),
+	findall(Id, (between(1, 2, _), thread_create(writer(L), Id, [])), Ws),
+	append(Rs, Ws, All),
+	maplist(joined, All),
+	a(400),
+	with_write_lock(L, with_read_lock(L, with_write_lock(L, true))),
+	rwlock_destroy(L).
+
+reader(L) :-
+	forall(between(1, 500, _),
+	       ( with_read_lock(L, (a(X), b(Y))), X == Y,
+		 with_optimistic_read(L, (a(X2), b(Y2))), X2 == Y2
+	       )).
+
+writer(L) :-
+	forall(between(1, 200, _),
+	       with_write_lock(L, update)).
+
+update :-
+	retract(a(X)),
+	X1 is X+1,
+	assertz(a(X1)),
+	retract(b(_)),
+	assertz(b(X1)).
+
+errors :-
+	rwlock_create(_, [alias(rwlock_test)]),
+	catch(rwlock_create(_, [alias(rwlock_test)]),
+	      error(permission_error(create, rwlock, rwlock_test), _), true),
+	rwlock_destroy(rwlock_test),
+	catch(rwlock_create(_, [prefer(nobody)]),
+	      error(domain_error(prefer, nobody), _), true),
+	rwlock_create(L),
+	catch(with_read_lock(L, throw(x)), x, true),
+	\+ with_optimistic_read(L, fail),
+	with_write_lock(L, true),
+	rwlock_destroy(L),
+	catch(with_read_lock(L, true),
+	      error(existence_error(rwlock, L), _), true),
+	catch(with_write_lock(42, true),
+	      error(type_error(rwlock, 42), _), true).
+
+joined(Id) :-
+	thread_join(Id, Status),
+	Status == true.
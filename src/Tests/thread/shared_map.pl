@@ -0,0 +1,120 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(shared_map,
+	  [ shared_map/0
+	  ]).
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Test atomic counters and shared maps. Threads  concurrently count using
+atomic_add/3 and flag/3 and  replace,  read   and  delete  entries of a
+shared map. Values are structured terms whose  invariant must hold for
+every value read. Afterwards the map is   dropped  such that it must be
+reclaimed by atom garbage collection.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+shared_map :-
+	counters,
+	map_basics,
+	map_concurrent.
+
+counters :-
+	set_flag(shared_map_test, 0),
+	findall(Id, (between(1, 4, _), thread_create(count, Id, [])), Ids),
+	maplist(joined, Ids),
+	get_flag(shared_map_test, 8000),
+	atomic_cas(shared_map_test, 8000, 0, 8000),
+	atomic_cas(shared_map_test, 8000, 1, 0),
+	get_flag(shared_map_test, 0),
+	set_flag(shared_map_test, a),
+	catch(atomic_add(shared_map_test, 1, _),
+	      error(type_error(integer, a), _), true),
+	set_flag(shared_map_test, 9223372036854775807),
+	catch(atomic_add(shared_map_test, 1, _),
+	      error(evaluation_error(int_overflow), _), true).
+
+count :-
+	forall(between(1, 1000, _),
+	       ( atomic_add(shared_map_test, 1, _),
+		 flag(shared_map_test, N, N+1)
+	       )).
+
+map_basics :-
+	shared_map_create(M),
+	shared_map_put(M, a, f(X, _, X)),
+	shared_map_put(M, 1, "one"),
+	shared_map_put(M, p(x), [1,2,3]),
+	shared_map_size(M, 3),
+	shared_map_get(M, a, f(A, B, C)), A == C, A \== B,
+	shared_map_get(M, p(_), [1,2,3]),
+	findall(K, shared_map_get(M, K, _), Keys0),
+	msort(Keys0, Keys), Keys = [1, a, p(_)],
+	shared_map_put(M, a, new),
+	shared_map_get(M, a, new),
+	shared_map_delete(M, a),
+	shared_map_delete(M, a),
+	\+ shared_map_get(M, a, _),
+	shared_map_size(M, 2),
+	catch(shared_map_get(nomap, a, _),
+	      error(type_error(shared_map, nomap), _), true),
+	catch(shared_map_put(M, "str", x),
+	      error(type_error(key, "str"), _), true).
+
+map_concurrent :-
+	shared_map_create(M),
+	findall(Id, (between(1, 6, I), thread_create(worker(M, I), Id, [])), Ids),
+	maplist(joined, Ids),
+	forall(shared_map_get(M, _, V), valid(V)),
+	garbage_collect_atoms.
+
+worker(M, I) :-
+	forall(between(1, 5000, J),
+	       ( K is J mod 32,
+		 atom_concat(k, K, Key),
+		 (   J mod 3 =:= 0
+		 ->  length(L, K),
+		     shared_map_put(M, Key, v(I, J, L, K))
+		 ;   J mod 7 =:= 0
+		 ->  shared_map_delete(M, Key)
+		 ;   shared_map_get(M, Key, V)
+		 ->  valid(V)
+		 ;   true
+		 )
+	       )).
+
+valid(v(_, _, L, K)) :-
+	length(L, K).
+
+joined(Id) :-
+	thread_join(Id, Status),
+	Status == true.
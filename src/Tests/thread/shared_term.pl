@@ -0,0 +1,95 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(shared_term,
+	  [ shared_term/0
+	  ]).
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Test shared terms. A term holding atoms,   strings, floats and big integers
+is stored once and accessed by  several   threads  through handles passed
+using thread_create/3 and thread_send_message/2.   Each  thread navigates
+the term and copies parts of it. Afterwards the handles are dropped such
+that the store must be reclaimed by atom garbage collection.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+shared_term :-
+	basics,
+	threads,
+	garbage_collect_atoms.
+
+basics :-
+	T = cfg(name("test"), [a, b-1.5, c], big(12345678901234567890123)),
+	shared_term_create(T, H),
+	shared_term(H, T2), T2 == T,
+	shared_term_functor(H, cfg, 3),
+	shared_term_arg(1, H, N), blob(N, shared_term),
+	shared_term(N, name("test")),
+	shared_term_arg(1, N, S), S == "test",
+	shared_term_arg(2, H, L1), shared_term_arg(2, H, L2), L1 == L2,
+	shared_term_arg(1, L1, a),
+	shared_term_arg(3, H, B), shared_term_arg(1, B, 12345678901234567890123),
+	\+ shared_term_arg(4, H, _),
+	shared_term_create(atom, A),
+	shared_term(A, atom),
+	shared_term_functor(A, atom, 0),
+	catch(shared_term_arg(1, A, _),
+	      error(type_error(compound, A), _), true),
+	catch(shared_term_create(f(_), _),
+	      error(instantiation_error, _), true),
+	catch(shared_term(nohandle, _),
+	      error(type_error(shared_term, nohandle), _), true).
+
+threads :-
+	numlist(1, 10000, L),
+	sum_list(L, Sum),
+	shared_term_create(data(L, "text"), H),
+	message_queue_create(Q),
+	findall(Id,
+		( between(1, 4, _),
+		  thread_create(worker(Q, Sum), Id, [])
+		), Ids),
+	forall(member(_, Ids), thread_send_message(Q, H)),
+	maplist(joined, Ids),
+	message_queue_destroy(Q).
+
+worker(Q, Sum) :-
+	thread_get_message(Q, H),
+	shared_term_arg(1, H, LH),
+	shared_term(LH, L),
+	sum_list(L, Sum),
+	shared_term_arg(2, H, "text").
+
+joined(Id) :-
+	thread_join(Id, Status),
+	Status == true.
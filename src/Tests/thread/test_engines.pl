@@ -27,6 +27,22 @@ test(stack_limit, TheLimit =:= 1_000_000) :-
 		      [ stack_limit(1_000_000) ]),
 	engine_next(E, TheLimit),
 	engine_destroy(E).
+test(small_stacks, Len == 200000) :-
+	engine_create(Len, (numlist(1, 200000, L), length(L, Len)), E,
+		      [ small_stacks(true) ]),
+	engine_next(E, Len),
+	engine_destroy(E).
+test(recycle, Ls == [ok,ok,ok,ok,ok]) :-
+	findall(X,
+		( between(1, 5, _),
+		  engine_create(x, \+ nb_current(engine_key, _), E0),
+		  engine_next(E0, X0),
+		  engine_create(_, nb_setval(engine_key, 1), E1),
+		  engine_next(E1, _),
+		  engine_destroy(E1),
+		  engine_destroy(E0),
+		  ( X0 == x -> X = ok ; X = X0 )
+		), Ls).
 test(findall, L == [1,2,3,4,5]) :-
 	e_findall(X, between(1, 5, X), L).
 test(yield, L == [1,2,3,4,5]) :-
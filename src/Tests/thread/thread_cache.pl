@@ -0,0 +1,78 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(thread_cache,
+	  [ thread_cache/0
+	  ]).
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Test reuse of local data and stacks   of terminated threads (Prolog flag
+thread_cache_size).  Threads running on recycled   data must start with
+fresh stacks, thread local predicates and global variables.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+:- thread_local
+	seen/1.
+
+thread_cache :-
+	current_prolog_flag(thread_cache_size, Old),
+	setup_call_cleanup(
+	    set_prolog_flag(thread_cache_size, 2),
+	    cache_test,
+	    set_prolog_flag(thread_cache_size, Old)).
+
+cache_test :-
+	forall(between(1, 50, I), run(I)),
+	findall(Id, (between(1, 10, I), thread_create(run(I), Id, [])), Ids),
+	maplist(joined, Ids),
+	catch(set_prolog_flag(thread_cache_size, -1),
+	      error(domain_error(thread_cache_size, -1), _), true),
+	current_prolog_flag(thread_cache_size, 2),
+	set_prolog_flag(thread_cache_size, 0),
+	run(0).
+
+run(I) :-
+	thread_create(fresh(I), Id, []),
+	joined(Id).
+
+joined(Id) :-
+	thread_join(Id, Status),
+	Status == true.
+
+fresh(I) :-
+	\+ seen(_),
+	\+ nb_current(thread_cache_key, _),
+	assertz(seen(I)),
+	nb_setval(thread_cache_key, I),
+	numlist(1, 100000, L),		% grow the stacks
+	sum_list(L, _).
@@ -0,0 +1,72 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+:- module(thread_numa,
+	  [ thread_numa/0
+	  ]).
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Test binding threads to NUMA nodes.  Only runs if node 0 is known (i.e.,
+on Linux with sysfs).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+thread_numa :-
+	catch(thread_create(true, Id, [numa_node(0)]), _, fail), !,
+	thread_join(Id, true),
+	numa_property,
+	numa_cache,
+	catch(thread_create(true, _, [numa_node(100000)]),
+	      error(existence_error(numa_node, 100000), _), true).
+thread_numa.
+
+numa_property :-
+	thread_create(thread_self(_), Id, [numa_node(0)]),
+	thread_property(Id, numa_node(Node)),
+	thread_join(Id, true),
+	Node == 0,
+	thread_create(true, Id2, []),
+	\+ thread_property(Id2, numa_node(_)),
+	thread_join(Id2, true).
+
+numa_cache :-
+	forall(between(1, 20, I),
+	       ( Node is I mod 2 - 1,
+		 (   Node >= 0
+		 ->  Options = [numa_node(Node)]
+		 ;   Options = []
+		 ),
+		 thread_create(( numlist(1, 100000, L),
+				 sum_list(L, _)
+			       ), Id, Options),
+		 thread_join(Id, true)
+	       )).
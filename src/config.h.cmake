@@ -86,6 +86,8 @@
 #cmakedefine HAVE_LIBUNWIND @HAVE_LIBUNWIND@
 #cmakedefine HAVE_LIBWINMM @HAVE_LIBWINMM@
 #cmakedefine HAVE_LIBWSOCK32 @HAVE_LIBWSOCK32@
+#cmakedefine HAVE_LINUX_FUTEX_H @HAVE_LINUX_FUTEX_H@
+#cmakedefine HAVE_LINUX_MEMPOLICY_H @HAVE_LINUX_MEMPOLICY_H@
 #cmakedefine HAVE_LOCALECONV @HAVE_LOCALECONV@
 #cmakedefine HAVE_LOCALE_H @HAVE_LOCALE_H@
 #cmakedefine HAVE_LOCALTIME_R @HAVE_LOCALTIME_R@
@@ -140,6 +142,7 @@
 #cmakedefine HAVE_SC_NPROCESSORS_CONF @HAVE_SC_NPROCESSORS_CONF@
 #cmakedefine HAVE_SELECT @HAVE_SELECT@
 #cmakedefine HAVE_SEMA_INIT @HAVE_SEMA_INIT@
+#cmakedefine HAVE_SENDFILE @HAVE_SENDFILE@
 #cmakedefine HAVE_SEM_INIT @HAVE_SEM_INIT@
 #cmakedefine HAVE_SETENV @HAVE_SETENV@
 #cmakedefine HAVE_SETLOCALE @HAVE_SETLOCALE@
@@ -182,6 +185,7 @@
 #cmakedefine HAVE_SYS_PARAM_H @HAVE_SYS_PARAM_H@
 #cmakedefine HAVE_SYS_RESOURCE_H @HAVE_SYS_RESOURCE_H@
 #cmakedefine HAVE_SYS_SELECT_H @HAVE_SYS_SELECT_H@
+#cmakedefine HAVE_SYS_SENDFILE_H @HAVE_SYS_SENDFILE_H@
 #cmakedefine HAVE_SYS_STAT_H @HAVE_SYS_STAT_H@
 #cmakedefine HAVE_SYS_STROPTS_H @HAVE_SYS_STROPTS_H@
 #cmakedefine HAVE_SYS_SYSCALL_H @HAVE_SYS_SYSCALL_H@
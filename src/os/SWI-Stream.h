@@ -225,7 +225,9 @@ typedef struct io_stream
   void *		exception;	/* pending exception (record_t) */
   void *		context;	/* getStreamContext() */
   struct PL_locale *	locale;		/* Locale associated to stream */
-  intptr_t		reserved[4];	/* reserved for extension */
+  size_t		reads;		/* # calls to functions->read */
+  size_t		writes;		/* # calls to functions->write */
+  intptr_t		reserved[2];	/* reserved for extension */
 } IOSTREAM;
 
 
@@ -259,6 +261,7 @@ typedef struct io_stream
 #define SIO_ADVLOCK	SmakeFlag(26)	/* File locked with advisory lock */
 #define SIO_WARN	SmakeFlag(27)	/* Pending warning */
 #define SIO_CLEARERR	0	        /* Obsolete */
+#define SIO_ADAPTBUF	SmakeFlag(28)	/* Grow buffer for bulk I/O */
 #define SIO_REPXML	SmakeFlag(29)	/* Bad char --> XML entity */
 #define SIO_REPPL	SmakeFlag(30)	/* Bad char --> Prolog \hex\ */
 #define SIO_BOM		SmakeFlag(31)	/* BOM was detected/written */
@@ -389,6 +392,13 @@ PL_EXPORT(size_t)	Sfread(void *data, size_t size, size_t elems,
 			       IOSTREAM *s);
 PL_EXPORT(size_t)	Sfwrite(const void *data, size_t size, size_t elems,
 				IOSTREAM *s);
+PL_EXPORT(int)		Scopy_compatible(IOSTREAM *in, IOSTREAM *out,
+					 int bounded);
+PL_EXPORT(ssize_t)	Scopy_bytes(IOSTREAM *in, IOSTREAM *out, size_t len);
+PL_EXPORT(int)		Sput_latin1(const char *q, size_t len, IOSTREAM *s);
+PL_EXPORT(size_t)	Sget_ascii(IOSTREAM *s, char *buf, size_t len,
+				   const char *stops, size_t nstops);
+PL_EXPORT(ssize_t)	Ssendfile(IOSTREAM *in, IOSTREAM *out, size_t len);
 PL_EXPORT(int)		Sfeof(IOSTREAM *s);
 PL_EXPORT(int)		Sfpasteof(IOSTREAM *s);
 PL_EXPORT(int)		Sferror(IOSTREAM *s);
@@ -436,10 +446,14 @@ PL_EXPORT(SOCKET)	Swinsock(IOSTREAM *s);
 PL_EXPORT(IOSTREAM *)	Sopen_pipe(const char *command, const char *type);
 PL_EXPORT(IOSTREAM *)	Sopenmem(char **buffer, size_t *sizep, const char *mode);
 PL_EXPORT(IOSTREAM *)	Sopen_string(IOSTREAM *s, char *buf, size_t sz, const char *m);
+PL_EXPORT(IOSTREAM *)	Sopen_textbuf(void);
+PL_EXPORT(void *)	Stextbuf(IOSTREAM *s, size_t *lenp);
+PL_EXPORT(int)		Sreset_textbuf(IOSTREAM *s);
 PL_EXPORT(int)		Sclosehook(void (*hook)(IOSTREAM *s));
 PL_EXPORT(void)		Sfree(void *ptr);
 PL_EXPORT(int)		Sset_filter(IOSTREAM *parent, IOSTREAM *filter);
 PL_EXPORT(void)		Ssetbuffer(IOSTREAM *s, char *buf, size_t size);
+PL_EXPORT(size_t)	Sset_default_buffer_size(size_t size);
 
 PL_EXPORT(int64_t)	Stell64(IOSTREAM *s);
 PL_EXPORT(int)		Sseek64(IOSTREAM *s, int64_t pos, int whence);
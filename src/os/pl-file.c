@@ -1425,6 +1425,33 @@ popOutputContext(void)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Redirecting output to an atom, string  or   code  list writes to a text
+buffer (see Sopen_textbuf()). Each thread   keeps the last text buffer
+it used, such that the common case  of non-nested redirection reuses the
+stream and its buffer rather than allocating them for every call.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+releaseRedirectStream(IOSTREAM *s ARG_LD)
+{ if ( !LD->IO.redirect_stream && Sreset_textbuf(s) == 0 )
+    LD->IO.redirect_stream = s;
+  else
+    Sclose(s);
+}
+
+
+void
+freeRedirectStream(PL_local_data_t *ld)
+{ IOSTREAM *s;
+
+  if ( (s = ld->IO.redirect_stream) )
+  { ld->IO.redirect_stream = NULL;
+    Sclose(s);
+  }
+}
+
+
 int
 setupOutputRedirect(term_t to, redir_context *ctx, int redir)
 { GET_LD
@@ -1476,11 +1503,11 @@ setupOutputRedirect(term_t to, redir_context *ctx, int redir)
     }
 
     ctx->is_stream = FALSE;
-    ctx->data = ctx->buffer;
-    ctx->size = sizeof(ctx->buffer);
-    ctx->stream = Sopenmem(&ctx->data, &ctx->size, "w");
-    ctx->stream->encoding = ENC_WCHAR;
-    ctx->stream->newline  = SIO_NL_POSIX;
+    if ( (ctx->stream = LD->IO.redirect_stream) )
+      LD->IO.redirect_stream = NULL;
+    else if ( !(ctx->stream = Sopen_textbuf()) )
+      return PL_no_memory();
+    ctx->stream->newline = SIO_NL_POSIX;
   }
 
   ctx->magic = REDIR_MAGIC;
@@ -1509,11 +1536,16 @@ closeOutputRedirect(redir_context *ctx)
   { rval = streamStatus(ctx->stream);
   } else
   { GET_LD
+    IOSTREAM *s = ctx->stream;
     term_t out  = PL_new_term_ref();
     term_t diff, tail;
 
-    if ( Sclose(ctx->stream) == 0 )
-    { _PL_get_arg(1, ctx->term, out);
+    if ( (s->flags & (SIO_FERR|SIO_WARN)) && !reportStreamError(s) )
+    { rval = FALSE;
+    } else
+    { PL_chars_t text;
+
+      _PL_get_arg(1, ctx->term, out);
       if ( ctx->out_arity == 2 )
       { diff = PL_new_term_ref();
 	_PL_get_arg(2, ctx->term, diff);
@@ -1522,16 +1554,30 @@ closeOutputRedirect(redir_context *ctx)
       { diff = tail = 0;
       }
 
-      rval = PL_unify_wchars_diff(out, tail, ctx->out_format,
-				  ctx->size/sizeof(wchar_t),
-				  (wchar_t*)ctx->data);
+      text.text.t    = Stextbuf(s, &text.length);
+      text.encoding  = s->encoding;
+      text.storage   = PL_CHARS_HEAP;
+      text.canonical = FALSE;
+      switch(text.encoding)
+      { case ENC_OCTET:
+	case ENC_ASCII:
+	  text.encoding = ENC_ISO_LATIN_1;
+	  /*FALLTHROUGH*/
+	case ENC_ISO_LATIN_1:
+	  text.canonical = TRUE;
+	  break;
+	default:
+	  break;
+      }
+
+      rval = ( PL_canonicalise_text(&text) &&
+	       PL_unify_text(out, tail, &text, ctx->out_format) );
       if ( rval && tail )
 	rval = PL_unify(tail, diff);
-    } else
-      rval = FALSE;
+      PL_free_text(&text);
+    }
 
-    if ( ctx->data != ctx->buffer )
-      Sfree(ctx->data);
+    releaseRedirectStream(s PASS_LD);
   }
 
   return rval;
@@ -1557,9 +1603,9 @@ discardOutputRedirect(redir_context *ctx)
   if ( ctx->is_stream )
   { streamStatus(ctx->stream);
   } else
-  { closeStream(ctx->stream);
-    if ( ctx->data != ctx->buffer )
-      Sfree(ctx->data);
+  { GET_LD
+
+    releaseRedirectStream(ctx->stream PASS_LD);
   }
 }
 
@@ -1917,6 +1963,7 @@ set_stream(IOSTREAM *s, term_t stream, atom_t aname, term_t a ARG_LD)
     if ( size < 1 )
       return PL_error(NULL, 0, NULL, ERR_DOMAIN, ATOM_not_less_than_one, a);
     Ssetbuffer(s, NULL, size);
+    s->flags &= ~SIO_ADAPTBUF;
     return TRUE;
   } else if ( aname == ATOM_eof_action ) /* eof_action(Action) */
   { atom_t action;
@@ -2765,8 +2812,10 @@ read_pending_input(term_t input, term_t list, term_t tail, int chars ARG_LD)
 
 	while(us<es)
 	{ if ( !(us[0]&0x80) )
-	  { count++;
-	    us++;
+	  { const char *ea = utf8_skip_ascii(us, es);
+
+	    count += ea-us;
+	    us = ea;
 	  } else
 	  { int ex = UTF8_FBN(us[0]);
 
@@ -3658,6 +3707,7 @@ static const opt_spec open4_options[] =
   { ATOM_eof_action,     OPT_ATOM },
   { ATOM_close_on_abort, OPT_BOOL },
   { ATOM_buffer,	 OPT_ATOM },
+  { ATOM_buffer_size,	 OPT_INT },
   { ATOM_lock,		 OPT_ATOM },
   { ATOM_wait,		 OPT_BOOL },
   { ATOM_encoding,	 OPT_ATOM },
@@ -3666,6 +3716,7 @@ static const opt_spec open4_options[] =
 #ifdef O_LOCALE
   { ATOM_locale,	 OPT_LOCALE },
 #endif
+  { ATOM_mmap,		 OPT_BOOL },
   { NULL_ATOM,	         0 }
 };
 
@@ -3720,6 +3771,7 @@ openStream(term_t file, term_t mode, term_t options)
   atom_t alias	        = NULL_ATOM;
   atom_t eof_action     = ATOM_eof_code;
   atom_t buffer         = ATOM_full;
+  int	 buffer_size	= -1;
   atom_t lock		= ATOM_none;
   int	 wait		= TRUE;
   atom_t encoding	= NULL_ATOM;
@@ -3729,6 +3781,7 @@ openStream(term_t file, term_t mode, term_t options)
   int    close_on_abort = TRUE;
   int	 bom		= -1;
   term_t create		= 0;
+  int	 mapped		= FALSE;
   char   how[16];
   char  *h		= how;
   char *path;
@@ -3738,13 +3791,22 @@ openStream(term_t file, term_t mode, term_t options)
   if ( options )
   { if ( !scan_options(options, 0, ATOM_stream_option, open4_options,
 		       &type, &reposition, &alias, &eof_action,
-		       &close_on_abort, &buffer, &lock, &wait,
+		       &close_on_abort, &buffer, &buffer_size, &lock, &wait,
 		       &encoding, &bom, &create
 #ifdef O_LOCALE
 		       , &locale
 #endif
+		       , &mapped
 		      ) )
       return FALSE;
+    if ( buffer_size != -1 && buffer_size < 1 )
+    { term_t ex;
+
+      if ( (ex = PL_new_term_ref()) &&
+	   PL_put_integer(ex, buffer_size) )
+	PL_error(NULL, 0, NULL, ERR_DOMAIN, ATOM_not_less_than_one, ex);
+      return NULL;
+    }
   }
 
 					/* MODE */
@@ -3806,6 +3868,8 @@ openStream(term_t file, term_t mode, term_t options)
     bom = (mname == ATOM_read ? TRUE : FALSE);
   if ( type == ATOM_binary )
     *h++ = 'b';
+  if ( mapped && mname == ATOM_read )
+    *h++ = 'M';
 
 					/* File locking */
   if ( lock != ATOM_none )
@@ -3891,6 +3955,10 @@ openStream(term_t file, term_t mode, term_t options)
 #endif
   if ( !close_on_abort )
     s->flags |= SIO_NOCLOSE;
+  if ( buffer_size > 0 )
+  { Ssetbuffer(s, NULL, buffer_size);
+    s->flags &= ~SIO_ADAPTBUF;
+  }
 
   if ( how[0] == 'r' )
   { if ( !set_eof_action(s, eof_action) )
@@ -4617,12 +4685,21 @@ stream_buffer_size_prop(IOSTREAM *s, term_t prop ARG_LD)
     return FALSE;
 
   if ( (size = s->bufsize) == 0 )
-    size = SIO_BUFSIZE;
+    size = (int)Sset_default_buffer_size(0);
 
   return PL_unify_integer(prop, size);
 }
 
 
+static int
+stream_syscalls_prop(IOSTREAM *s, term_t prop ARG_LD)
+{ return PL_unify_term(prop,
+		       PL_FUNCTOR, FUNCTOR_minus2,
+			 PL_INT64, (int64_t)s->reads,
+			 PL_INT64, (int64_t)s->writes);
+}
+
+
 static int
 stream_timeout_prop(IOSTREAM *s, term_t prop ARG_LD)
 { if ( s->timeout == -1 )
@@ -4699,6 +4776,7 @@ static const sprop sprop_list [] =
   { FUNCTOR_file_no1,	    stream_file_no_prop },
   { FUNCTOR_buffer1,	    stream_buffer_prop },
   { FUNCTOR_buffer_size1,   stream_buffer_size_prop },
+  { FUNCTOR_syscalls1,	    stream_syscalls_prop },
   { FUNCTOR_close_on_abort1,stream_close_on_abort_prop },
   { FUNCTOR_tty1,	    stream_tty_prop },
   { FUNCTOR_encoding1,	    stream_encoding_prop },
@@ -5598,49 +5676,64 @@ PRED_IMPL("$size_stream", 2, size_stream, 0)
 copy_stream_data(+StreamIn, +StreamOut, [Len])
 	Copy all data from StreamIn to StreamOut.  Should be somewhere else,
 	and maybe we need something else to copy resources.
+
+If no transcoding is needed (see Scopy_compatible()),  we copy blocks of
+bytes, using sendfile(2) if possible. Otherwise   we copy the data code
+by code. Len is -1 to copy all data.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 static int
-copy_stream_data(term_t in, term_t out, term_t len ARG_LD)
-{ IOSTREAM *i, *o;
-  int c;
+copy_stream_codes(IOSTREAM *i, IOSTREAM *o, int64_t n)
+{ int c;
   int count = 0;
 
-  if ( !getInputStream(in, S_DONTCARE, &i) )
-    return FALSE;
-  if ( !getOutputStream(out, S_DONTCARE, &o) )
-  { releaseStream(i);
-    return FALSE;
+  while ( n-- != 0 && (c = Sgetcode(i)) != EOF )
+  { if ( (++count % 4096) == 0 && PL_handle_signals() < 0 )
+    { releaseStream(i);
+      releaseStream(o);
+      return FALSE;
+    }
+    if ( Sputcode(c, o) < 0 )
+    { releaseStream(i);
+      return streamStatus(o);
+    }
   }
 
-  if ( !len )
-  { while ( (c = Sgetcode(i)) != EOF )
-    { if ( (++count % 4096) == 0 && PL_handle_signals() < 0 )
-      { releaseStream(i);
-	releaseStream(o);
-	return FALSE;
-      }
-      if ( Sputcode(c, o) < 0 )
-      { releaseStream(i);
-	return streamStatus(o);
-      }
-    }
-  } else
-  { int64_t n;
+  releaseStream(o);
+  return streamStatus(i);
+}
 
-    if ( !PL_get_int64_ex(len, &n) )
-      return FALSE;
 
-    while ( n-- > 0 && (c = Sgetcode(i)) != EOF )
-    { if ( (++count % 4096) == 0 && PL_handle_signals() < 0 )
-      { releaseStream(i);
-	releaseStream(o);
-	return FALSE;
-      }
-      if ( Sputcode(c, o) < 0 )
+static int
+copy_stream_bytes(IOSTREAM *i, IOSTREAM *o, int64_t n)
+{ int sendfile = TRUE;
+
+  while ( n != 0 )
+  { size_t max = (n < 0 || (uint64_t)n > SIZE_MAX ? SIZE_MAX : (size_t)n);
+    ssize_t done;
+
+    if ( sendfile && (done = Ssendfile(i, o, max)) == -2 )
+    { sendfile = FALSE;
+      continue;
+    }
+    if ( !sendfile )
+      done = Scopy_bytes(i, o, max);
+
+    if ( done == 0 )
+      break;
+    if ( done < 0 )
+    { if ( Sferror(o) )
       { releaseStream(i);
 	return streamStatus(o);
       }
+      break;
+    }
+    if ( n > 0 )
+      n -= done;
+    if ( PL_handle_signals() < 0 )
+    { releaseStream(i);
+      releaseStream(o);
+      return FALSE;
     }
   }
 
@@ -5648,6 +5741,32 @@ copy_stream_data(term_t in, term_t out, term_t len ARG_LD)
   return streamStatus(i);
 }
 
+
+static int
+copy_stream_data(term_t in, term_t out, term_t len ARG_LD)
+{ IOSTREAM *i, *o;
+  int64_t n = -1;
+
+  if ( len )
+  { if ( !PL_get_int64_ex(len, &n) )
+      return FALSE;
+    if ( n < 0 )
+      n = 0;
+  }
+
+  if ( !getInputStream(in, S_DONTCARE, &i) )
+    return FALSE;
+  if ( !getOutputStream(out, S_DONTCARE, &o) )
+  { releaseStream(i);
+    return FALSE;
+  }
+
+  if ( Scopy_compatible(i, o, n >= 0) )
+    return copy_stream_bytes(i, o, n);
+  else
+    return copy_stream_codes(i, o, n);
+}
+
 static
 PRED_IMPL("copy_stream_data", 3, copy_stream_data3, 0)
 { PRED_LD
@@ -94,6 +94,7 @@ COMMON(int)		setupOutputRedirect(term_t to,
 					    int redir);
 COMMON(int)		closeOutputRedirect(redir_context *ctx);
 COMMON(void)		discardOutputRedirect(redir_context *ctx);
+COMMON(void)		freeRedirectStream(PL_local_data_t *ld);
 COMMON(int)		push_input_context(atom_t type);
 COMMON(int)		pop_input_context(void);
 COMMON(int)		stream_encoding_options(atom_t type, atom_t encoding,
@@ -818,6 +818,9 @@ set_prolog_flag_unlocked(term_t key, term_t value, int flags)
 
       if ( !PL_get_int64_ex(value, &i) )
 	return FALSE;
+      if ( k == ATOM_stream_buffer_size && (i < 1 || i > INT_MAX) )
+	return PL_error(NULL, 0, NULL, ERR_DOMAIN,
+			ATOM_not_less_than_one, value);
       f->value.i = i;
 
 #ifdef O_ATOMGC
@@ -827,10 +830,21 @@ set_prolog_flag_unlocked(term_t key, term_t value, int flags)
 #endif
       if ( k == ATOM_table_space )
 	LD->tabling.node_pool.limit = (size_t)i;
+      else if ( k == ATOM_stream_buffer_size )
+	Sset_default_buffer_size((size_t)i);
       else if ( k == ATOM_stack_limit )
       { if ( !set_stack_limit((size_t)i) )
 	  return FALSE;
       }
+#ifdef O_PLMT
+      else if ( k == ATOM_thread_cache_size )
+      { if ( !set_thread_cache_size(i) )
+	  return FALSE;
+      } else if ( k == ATOM_lock_profile )
+      { if ( !setLockProfile(i) )
+	  return FALSE;
+      }
+#endif
       break;
     }
     case FT_FLOAT:
@@ -1061,6 +1075,12 @@ unify_prolog_flag_value(Module m, atom_t key, prolog_flag *f, term_t val)
   { return PL_unify_atom(val, accessLevel());
   } else if ( key == ATOM_stack_limit )
   { return PL_unify_int64(val, LD->stacks.limit);
+#ifdef O_PLMT
+  } else if ( key == ATOM_thread_cache_size )
+  { return PL_unify_integer(val, GD->thread.cache.size);
+  } else if ( key == ATOM_lock_profile )
+  { return PL_unify_integer(val, _PL_lock_profile);
+#endif
   }
 
   switch(f->flags & FT_MASK)
@@ -1343,7 +1363,9 @@ initPrologFlags(void)
   setPrologFlag("agc_margin",FT_INTEGER,	       GD->atoms.margin);
 #endif
   setPrologFlag("table_space", FT_INTEGER, LD->tabling.node_pool.limit);
+  setPrologFlag("table_statistics", FT_BOOL, FALSE, PLFLAG_TABLE_STATISTICS);
   setPrologFlag("stack_limit", FT_INTEGER, LD->stacks.limit);
+  setPrologFlag("stream_buffer_size", FT_INTEGER, SIO_BUFSIZE);
 #if defined(HAVE_DLOPEN) || defined(HAVE_SHL_LOAD) || defined(EMULATE_DLOPEN)
   setPrologFlag("open_shared_object",	  FT_BOOL|FF_READONLY, TRUE, 0);
   setPrologFlag("shared_object_extension",	  FT_ATOM|FF_READONLY, SO_EXT);
@@ -1356,6 +1378,8 @@ initPrologFlags(void)
 #ifdef O_PLMT
   setPrologFlag("threads",	FT_BOOL, !GD->options.nothreads, 0);
   setPrologFlag("system_thread_id", FT_INTEGER|FF_READONLY, 0, 0);
+  setPrologFlag("thread_cache_size", FT_INTEGER, GD->thread.cache.size);
+  setPrologFlag("lock_profile", FT_INTEGER, 0);
   setPrologFlag("gc_thread",    FT_BOOL,
 		!GD->options.nothreads &&
 		truePrologFlag(PLFLAG_GCTHREAD), PLFLAG_GCTHREAD);
@@ -135,6 +135,17 @@ static int	S__seterror(IOSTREAM *s);
 
 static IOSTREAM *	Sopen_buffer(IOSTREAM *s, char *buf, size_t size);
 static void		Sclose_buffer(IOSTREAM *s);
+static IOSTREAM *	Sopen_mapped(int fd, int flags);
+#ifdef HAVE_MMAP
+static IOFUNCTIONS	Smappedfunctions;
+#define Sismapped(s) ((s)->functions == &Smappedfunctions && \
+		      ((s)->flags & SIO_USERBUF))
+#else
+#define Sismapped(s) FALSE
+#endif
+static IOFUNCTIONS	Stextbuffunctions;
+static int		S__textbuf_widen(IOSTREAM *s);
+#define Sistextbuf(s) ((s)->functions == &Stextbuffunctions)
 
 #ifdef O_PLMT
 #define SLOCK(s)    if ( s->mutex ) recursiveMutexLock(s->mutex)
@@ -176,15 +187,40 @@ UNDO_SIZE before s->buffer, so we can always push-back a wide
 character into a multibyte stream. We do not do this for SIO_USERBUF
 case, but this is only used by the output stream Svfprintf() where it is
 not needed.
+
+Buffers are allocated lazily using S__default_bufsize bytes, unless the
+size is set explicitly using Ssetbuffer().  Streams with SIO_ADAPTBUF
+(regular files) double their buffer each time a transfer uses the entire
+buffer, up to SIO_ADAPT_MAXBUFSIZE.  This reduces the number of system
+calls for sequential bulk I/O without wasting memory on small files.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
+#define SIO_ADAPT_MAXBUFSIZE (256*1024)
+
+static size_t S__default_bufsize = SIO_BUFSIZE;
+
+/* Set the default buffer size and return the old one.  If size is 0,
+   only return the current default.
+*/
+
+size_t
+Sset_default_buffer_size(size_t size)
+{ size_t old = S__default_bufsize;
+
+  if ( size > 0 && size <= INT_MAX )
+    S__default_bufsize = size;
+
+  return old;
+}
+
+
 static size_t
 S__setbuf(IOSTREAM *s, char *buffer, size_t size)
 { char *newbuf, *newunbuf;
   int newflags = s->flags;
 
   if ( size == 0 )
-    size = SIO_BUFSIZE;
+    size = S__default_bufsize;
 
   if ( (s->flags & SIO_OUTPUT) )
   { if ( S__removebuf(s) < 0 )
@@ -258,6 +294,30 @@ Ssetbuffer(IOSTREAM *s, char *buffer, size_t size)
 }
 
 
+/* Grow the buffer of an SIO_ADAPTBUF stream.  Must be called with an
+   empty buffer, i.e., after the input is consumed or the output is
+   flushed.  If the buffer cannot grow, adaptation is disabled.
+*/
+
+static void
+S__growbuf(IOSTREAM *s)
+{ size_t size = (size_t)s->bufsize*2;
+  char *newunbuf;
+
+  if ( size > SIO_ADAPT_MAXBUFSIZE || (s->flags & SIO_USERBUF) ||
+       !(newunbuf = malloc(size+UNDO_SIZE)) )
+  { s->flags &= ~SIO_ADAPTBUF;
+    return;
+  }
+
+  free(s->unbuffer);
+  s->unbuffer = newunbuf;
+  s->bufp = s->buffer = newunbuf + UNDO_SIZE;
+  s->limitp = (s->flags & SIO_INPUT) ? s->buffer : &s->buffer[size];
+  s->bufsize = (int)size;
+}
+
+
 static int
 S__removebuf(IOSTREAM *s)
 { if ( s->buffer && s->unbuffer )
@@ -494,7 +554,7 @@ Sset_timeout(IOSTREAM *s, int tmo)
 
 static ssize_t
 S__flushbuf(IOSTREAM *s)
-{ char *from, *to;
+{ char *start, *from, *to;
   ssize_t rc;
 
   if ( s->magic != SIO_MAGIC )
@@ -502,8 +562,8 @@ S__flushbuf(IOSTREAM *s)
     return -1;
   }
   SLOCK(s);
-  from = s->buffer;
-  to   = s->bufp;
+  start = from = s->buffer;		/* text buffers move s->buffer */
+  to    = s->bufp;
 
   while ( from < to )
   { size_t size = (size_t)(to - from);
@@ -519,6 +579,7 @@ S__flushbuf(IOSTREAM *s)
 #endif
 
   retry:
+    s->writes++;
     n = (*s->functions->write)(s->handle, from, size);
 
     if ( n > 0 )			/* wrote some */
@@ -543,8 +604,10 @@ S__flushbuf(IOSTREAM *s)
 partial:
 #endif
   if ( to == from )			/* full flush */
-  { rc = s->bufp - s->buffer;
+  { rc = to - start;
     s->bufp = s->buffer;
+    if ( (s->flags & SIO_ADAPTBUF) && rc == s->bufsize )
+      S__growbuf(s);
   } else				/* partial flush */
   { size_t left = to - from;
 
@@ -570,6 +633,7 @@ S__flushbufc(int c, IOSTREAM *s)
   { if ( s->flags & SIO_NBUF )
     { char chr = (char)c;
 
+      s->writes++;
       if ( (*s->functions->write)(s->handle, &chr, 1) != 1 )
       { S__seterror(s);
 	c = -1;
@@ -623,6 +687,7 @@ S__fillbuf(IOSTREAM *s)
   { char chr;
     ssize_t n;
 
+    s->reads++;
     n = (*s->functions->read)(s->handle, &chr, 1);
     if ( n == 1 )
     { c = char_to_int(chr);
@@ -646,7 +711,7 @@ S__fillbuf(IOSTREAM *s)
       len = s->bufsize;
     } else if ( s->bufp < s->limitp )
     { len = s->limitp - s->bufp;
-      if ( len == s->bufsize )
+      if ( len == s->bufsize || Sismapped(s) )
       { c = char_to_int(*s->bufp++);
 	return c;
       }
@@ -655,10 +720,14 @@ S__fillbuf(IOSTREAM *s)
       s->limitp = &s->bufp[len];
       len = s->bufsize - len;
     } else
-    { s->bufp = s->limitp = s->buffer;
+    { if ( (s->flags & SIO_ADAPTBUF) &&
+	   s->limitp == s->buffer + s->bufsize )
+	S__growbuf(s);			/* last read filled the buffer */
+      s->bufp = s->limitp = s->buffer;
       len = s->bufsize;
     }
 
+    s->reads++;
     n = (*s->functions->read)(s->handle, s->limitp, len);
     if ( n > 0 )
     { s->limitp += n;
@@ -864,7 +933,12 @@ put_code(int c, IOSTREAM *s)
   { case ENC_OCTET:
     case ENC_ISO_LATIN_1:
       if ( c >= 256 )
-      { if ( reperror(c, s) < 0 )
+      { if ( Sistextbuf(s) && s->encoding == ENC_ISO_LATIN_1 )
+	{ if ( S__textbuf_widen(s) < 0 )
+	    return -1;
+	  return put_code(c, s);
+	}
+	if ( reperror(c, s) < 0 )
 	  return -1;
 	break;
       }
@@ -983,7 +1057,7 @@ Scanrepresent(int c, IOSTREAM *s)
 { switch(s->encoding)
   { case ENC_OCTET:
     case ENC_ISO_LATIN_1:
-      if ( c <= 0xff )
+      if ( c <= 0xff || Sistextbuf(s) )
 	return 0;
       return -1;
     case ENC_ASCII:
@@ -1187,6 +1261,7 @@ int
 Speekcode(IOSTREAM *s)
 { int c;
   char *start;
+  int adapt;
   size_t safe = (size_t)-1;
 
   if ( !s->buffer )
@@ -1207,6 +1282,8 @@ Speekcode(IOSTREAM *s)
   }
 
   start = s->bufp;
+  adapt = (s->flags & SIO_ADAPTBUF);	/* do not reallocate the buffer */
+  s->flags &= ~SIO_ADAPTBUF;
   if ( s->position )
   { IOPOS *psave = s->position;
     s->position = NULL;
@@ -1215,6 +1292,7 @@ Speekcode(IOSTREAM *s)
   } else
   { c = Sgetcode(s);
   }
+  s->flags |= adapt;
   if ( Sferror(s) )
     return -1;
 
@@ -1328,6 +1406,405 @@ Sfwrite(const void *data, size_t size, size_t elms, IOSTREAM *s)
   return (size*elms - chars)/size;
 }
 
+		 /*******************************
+		 *	     BLOCK COPY		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+The functions below copy bytes  between  two   streams  if  copying the
+bytes has the same result as copying  the characters using Sgetcode() and
+Sputcode(), i.e., no transcoding or  newline   conversion  is needed. This
+is used by copy_stream_data/2,3.
+
+Scopy_compatible() tests whether this  is   possible.  If  `bounded` is
+TRUE, the input must use a single  byte   encoding  such  that a count in
+characters is a count in bytes.
+
+Scopy_bytes() copies the content of  the   input  buffer, filling it if
+needed.  Ssendfile()  lets  the  kernel  copy  between  two  files using
+sendfile(2). Both copy at most `len` bytes and return the number of bytes
+copied, 0 at end of file or -1 on  error. Ssendfile() returns -2 if the
+kernel cannot do the copy, after which the caller must use Scopy_bytes().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+single_byte_encoding(IOENC enc)
+{ return ( enc == ENC_OCTET ||
+	   enc == ENC_ASCII ||
+	   enc == ENC_ISO_LATIN_1 );
+}
+
+
+int
+Scopy_compatible(IOSTREAM *in, IOSTREAM *out, int bounded)
+{ if ( in->tee || out->tee ||
+       (in->flags & SIO_NBUF) || (out->flags & SIO_NBUF) )
+    return FALSE;
+  if ( (in->flags & SIO_TEXT) && in->newline != SIO_NL_POSIX )
+    return FALSE;
+  if ( (out->flags & SIO_TEXT) && out->newline == SIO_NL_DOS )
+    return FALSE;
+  if ( bounded && !single_byte_encoding(in->encoding) )
+    return FALSE;
+
+  switch(in->encoding)
+  { case ENC_OCTET:
+    case ENC_ISO_LATIN_1:
+      return out->encoding == ENC_OCTET || out->encoding == ENC_ISO_LATIN_1;
+    case ENC_UTF8:
+      return out->encoding == ENC_UTF8;
+    default:
+      return FALSE;
+  }
+}
+
+
+/* Update the position of s after copying the bytes in buf.  The stream
+   encoding is a single byte encoding or UTF-8.
+*/
+
+static void
+S__update_block_pos(IOSTREAM *s, const char *buf, size_t len)
+{ IOPOS *p;
+
+  if ( (p=s->position) )
+  { const unsigned char *b = (const unsigned char *)buf;
+    const unsigned char *e = b+len;
+    int utf8 = (s->encoding == ENC_UTF8);
+
+    p->byteno += len;
+    for(; b < e; b++)
+    { if ( utf8 && (*b & 0xc0) == 0x80 )
+	continue;			/* UTF-8 continuation byte */
+      update_linepos(s, *b);
+      p->charno++;
+    }
+  }
+}
+
+
+static int
+S__write_block(IOSTREAM *s, const char *buf, size_t len)
+{ int flush = ( (s->flags & SIO_LBUF) && memchr(buf, '\n', len) );
+
+  if ( !s->buffer )
+  { if ( S__setbuf(s, NULL, 0) == (size_t)-1 )
+      return -1;
+  }
+
+  while(len > 0)
+  { size_t avail = s->limitp - s->bufp;
+
+    if ( avail == 0 )
+    { if ( S__flushbuf(s) <= 0 )
+	return -1;
+      continue;
+    }
+    if ( avail > len )
+      avail = len;
+    memcpy(s->bufp, buf, avail);
+    s->bufp += avail;
+    buf     += avail;
+    len     -= avail;
+    s->lastc = buf[-1]&0xff;
+  }
+
+  if ( flush && S__flushbuf(s) < 0 )
+    return -1;
+
+  return 0;
+}
+
+
+ssize_t
+Scopy_bytes(IOSTREAM *in, IOSTREAM *out, size_t len)
+{ size_t n;
+
+  if ( in->bufp >= in->limitp )
+  { if ( S__fillbuf(in) == -1 )
+      return Sferror(in) ? -1 : 0;
+    in->bufp--;				/* S__fillbuf() returns the first */
+  }
+
+  n = in->limitp - in->bufp;
+  if ( n > len )
+    n = len;
+  if ( S__write_block(out, in->bufp, n) < 0 )
+    return -1;
+  S__update_block_pos(in, in->bufp, n);
+  S__update_block_pos(out, in->bufp, n);
+  in->bufp += n;
+
+  return n;
+}
+
+
+		 /*******************************
+		 *	   BULK TEXT I/O	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Most text is ASCII.  For the common  encodings an ASCII character maps to
+a single identical byte, so runs  of  ASCII   can  be  moved between the
+stream buffer and the caller using memcpy() rather than Sputcode() and
+Sgetcode() for each character.  S__text_run() returns the end of the run
+starting at `q` that can be transferred this  way. If `ascii` is TRUE the
+run is limited to ASCII, also for single  byte encodings. A run never
+contains the character `nl` that needs newline translation.
+
+Sput_latin1() writes ISO Latin-1 text as  Sputcode() would. This includes
+ENC_WCHAR streams, which  are  used   by  with_output_to/2  and friends.
+Sget_ascii() copies a run of at  most   `len`  ASCII characters from the
+buffer, stopping before any of the `nstops`  characters in `stops`. The
+stop set has an explicit length, so it can contain the NUL character. It
+returns 0 if the next character  must   be  read using Sgetcode(), which
+notably applies to an empty buffer.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static const char *
+S__text_run(IOSTREAM *s, const char *q, const char *e, int ascii, int nl)
+{ const char *r;
+
+  if ( s->tee || (s->flags & SIO_NBUF) )
+    return q;
+  if ( nl )
+  { const char *p = memchr(q, nl, e-q);
+
+    if ( p )
+      e = p;
+  }
+
+  switch(s->encoding)
+  { case ENC_WCHAR:
+      if ( ascii )
+	return q;
+      r = e;
+      break;
+    case ENC_OCTET:
+    case ENC_ISO_LATIN_1:
+      if ( !ascii )
+      { r = e;
+	break;
+      }
+      /*FALLTHROUGH*/
+    case ENC_ASCII:
+    case ENC_UTF8:
+      r = utf8_skip_ascii(q, e);
+      break;
+    default:
+      return q;
+  }
+
+  return r;
+}
+
+
+/* Write Latin-1 text to an ENC_WCHAR stream.  S__update_block_pos()
+   counts one byte per character, so we add the remaining bytes here.
+*/
+
+static int
+S__write_wchars(IOSTREAM *s, const char *q, size_t len)
+{ const unsigned char *b = (const unsigned char *)q;
+  const unsigned char *e = b+len;
+  int flush = ( (s->flags & SIO_LBUF) && memchr(q, '\n', len) );
+
+  if ( !s->buffer )
+  { if ( S__setbuf(s, NULL, 0) == (size_t)-1 )
+      return -1;
+  }
+
+  while(b < e)
+  { size_t avail = (s->limitp - s->bufp)/sizeof(pl_wchar_t);
+
+    if ( avail == 0 )
+    { if ( S__flushbuf(s) <= 0 )
+	return -1;
+      continue;
+    }
+    if ( avail > (size_t)(e-b) )
+      avail = e-b;
+    for( ; avail > 0; avail-- )
+    { pl_wchar_t c = *b++;
+
+      memcpy(s->bufp, &c, sizeof(c));
+      s->bufp += sizeof(c);
+    }
+  }
+  s->lastc = e[-1];
+  if ( s->position )
+    s->position->byteno += len*(sizeof(pl_wchar_t)-1);
+
+  if ( flush && S__flushbuf(s) < 0 )
+    return -1;
+
+  return 0;
+}
+
+
+int
+Sput_latin1(const char *q, size_t len, IOSTREAM *s)
+{ const char *e = q+len;
+  int nl = ( (s->flags&SIO_TEXT) && s->newline == SIO_NL_DOS ? '\n' : 0 );
+
+  if ( s->encoding == ENC_ANSI || s->encoding == ENC_UNICODE_BE ||
+       s->encoding == ENC_UNICODE_LE )
+  { for( ; q < e; q++ )
+    { if ( Sputcode(*q&0xff, s) < 0 )
+	return -1;
+    }
+
+    return 0;
+  }
+
+  while( q < e )
+  { const char *r = S__text_run(s, q, e, FALSE, nl);
+
+    if ( r > q )
+    { int rc = ( s->encoding == ENC_WCHAR ? S__write_wchars(s, q, r-q)
+					  : S__write_block(s, q, r-q) );
+
+      if ( rc < 0 )
+	return -1;
+      S__update_block_pos(s, q, r-q);
+      q = r;
+    } else
+    { if ( Sputcode(*q&0xff, s) < 0 )
+	return -1;
+      q++;
+    }
+  }
+
+  return 0;
+}
+
+
+size_t
+Sget_ascii(IOSTREAM *s, char *buf, size_t len,
+	   const char *stops, size_t nstops)
+{ const char *q = s->bufp;
+  const char *e = s->limitp;
+  const char *r;
+  int nl = ( (s->flags&SIO_TEXT) && s->newline != SIO_NL_POSIX ? '\r' : 0 );
+  size_t n;
+
+  if ( q >= e || (s->flags & (SIO_FEOF|SIO_FERR)) )
+    return 0;
+  if ( (size_t)(e-q) > len )
+    e = q+len;
+  if ( nstops == 1 )
+  { const char *p = memchr(q, stops[0], e-q);
+
+    if ( p )
+      e = p;
+  }
+  r = S__text_run(s, q, e, TRUE, nl);
+
+  if ( nstops > 1 )
+  { const char *p;
+
+    for(p=q; p<r && !memchr(stops, *p, nstops); p++)
+      ;
+    r = p;
+  }
+
+  n = r-q;
+  memcpy(buf, q, n);
+  S__update_block_pos(s, q, n);
+  s->bufp += n;
+
+  return n;
+}
+
+
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+#include <sys/sendfile.h>
+#define SENDFILE_CHUNK (1<<20)		/* max bytes per call */
+
+static void
+S__update_sendfile_pos(IOSTREAM *s, size_t len)
+{ IOPOS *p;
+
+  if ( (p=s->position) )
+  { p->byteno += len;
+    p->charno += len;
+    s->flags |= SIO_NOLINEPOS;
+  }
+}
+
+/* Only plain files can use sendfile(2) as filter streams may report the
+   file descriptor of the stream they wrap.  If the stream records its
+   position we must see the data, unless the data is binary, in which
+   case we only update the byte and character counts.
+*/
+
+ssize_t
+Ssendfile(IOSTREAM *in, IOSTREAM *out, size_t len)
+{ int fdin, fdout;
+  ssize_t n;
+
+  if ( !(in->flags & SIO_FILE) || !(out->flags & SIO_FILE) ||
+       in->bufp < in->limitp || in->timeout >= 0 || out->timeout >= 0 )
+    return -2;
+  if ( (in->position || out->position) &&
+       !(in->encoding == ENC_OCTET && out->encoding == ENC_OCTET) )
+    return -2;
+  if ( (fdin=Sfileno(in)) < 0 || (fdout=Sfileno(out)) < 0 )
+    return -2;
+  if ( out->buffer && out->bufp > out->buffer && S__flushbuf(out) < 0 )
+    return -1;
+
+  if ( len > SENDFILE_CHUNK )
+    len = SENDFILE_CHUNK;
+
+retry:
+  in->reads++;
+  out->writes++;
+  if ( (n=sendfile(fdout, fdin, NULL, len)) > 0 )
+  { S__update_sendfile_pos(in, n);
+    S__update_sendfile_pos(out, n);
+    return n;
+  } else if ( n == 0 )
+  { if ( !(in->flags & SIO_NOFEOF) )
+      in->flags |= SIO_FEOF;
+    return 0;
+  }
+
+  switch(errno)
+  { case EINTR:
+      if ( PL_handle_signals() < 0 )
+      { Sset_exception(out, PL_exception(0));
+	errno = EPLEXCEPTION;
+	return -1;
+      }
+      goto retry;
+    case EINVAL:			/* in is not a regular file, ... */
+    case ENOSYS:
+    case EAGAIN:
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+    case EWOULDBLOCK:
+#endif
+      return -2;
+    default:
+      S__seterror(out);
+      return -1;
+  }
+}
+
+#else /*HAVE_SENDFILE && HAVE_SYS_SENDFILE_H*/
+
+ssize_t
+Ssendfile(IOSTREAM *in, IOSTREAM *out, size_t len)
+{ (void)in;
+  (void)out;
+  (void)len;
+
+  return -2;
+}
+
+#endif /*HAVE_SENDFILE && HAVE_SYS_SENDFILE_H*/
+
+
 
 		 /*******************************
 		 *	       PENDING		*
@@ -2026,10 +2503,8 @@ Sgets(char *buf)
 
 int
 Sfputs(const char *q, IOSTREAM *s)
-{ for( ; *q; q++)
-  { if ( Sputcode(*q&0xff, s) < 0 )
-      return EOF;
-  }
+{ if ( Sput_latin1(q, strlen(q), s) < 0 )
+    return EOF;
 
   return 0;
 }
@@ -3097,6 +3572,7 @@ after the [rw] argument:
   - "L[rw]" -- use a read or write lock and raise an exception if we
 	       must wait
   - mOOO -- when creating the file, use 0OOO as mode.
+  - "M" -- map a file opened for reading into memory (see Sopen_mapped())
 
 Note that the low-level open  is  always   binary  as  O_TEXT open files
 result in lost and corrupted data in   some  encodings (UTF-16 is one of
@@ -3116,6 +3592,7 @@ Sopen_file(const char *path, const char *how)
   IOENC enc = ENC_UNKNOWN;
   int wait = TRUE;
   int mode = 0666;
+  int mapped = FALSE;
 
   for( ; *how; how++)
   { switch(*how)
@@ -3126,6 +3603,9 @@ Sopen_file(const char *path, const char *how)
       case 'r':				/* no record */
 	flags &= ~SIO_RECORDPOS;
         break;
+      case 'M':				/* memory mapped */
+	mapped = TRUE;
+        break;
       case 'L':				/* lock r: read, w: write */
 	wait = FALSE;
         /*FALLTHROUGH*/
@@ -3236,8 +3716,18 @@ Sopen_file(const char *path, const char *how)
 #endif
   }
 
-  lfd = (intptr_t)fd;
-  s = Snew((void *)lfd, flags, &Sfilefunctions);
+#ifdef S_ISREG
+  { struct stat buf;
+
+    if ( fstat(fd, &buf) == 0 && S_ISREG(buf.st_mode) )
+      flags |= SIO_ADAPTBUF;
+  }
+#endif
+
+  if ( !(mapped && op == 'r' && (s=Sopen_mapped(fd, flags))) )
+  { lfd = (intptr_t)fd;
+    s = Snew((void *)lfd, flags, &Sfilefunctions);
+  }
   if ( enc != ENC_UNKNOWN )
     s->encoding = enc;
   if ( lock )
@@ -3247,6 +3737,184 @@ Sopen_file(const char *path, const char *how)
 }
 
 
+		 /*******************************
+		 *	   MAPPED FILES		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Sopen_mapped() maps a regular file into memory   and uses the mapping as
+the buffer of an input stream. The   data is available without copying
+it from the kernel and S__fillbuf() only   detects  end-of-file. Seeking
+outside the buffer sets `here`, after which Sread_mapped() moves the
+(empty) buffer to `here`.  If the buffer is replaced using Ssetbuffer(),
+Sread_mapped() copies the data into the new buffer.
+
+The mapping is private and writable  because Sungetc() writes into the
+buffer. The descriptor is kept open to  preserve advisory locks. If the
+file cannot be mapped we return NULL and the caller uses normal I/O.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void *)-1)
+#endif
+
+typedef struct mapped_stream
+{ IOSTREAM     *stream;			/* The stream */
+  char	       *base;			/* Start of the mapping */
+  size_t	size;			/* Size of the mapping */
+  size_t	here;			/* Offset of data passed to stream */
+  int		fd;			/* File descriptor */
+} mapped_stream;
+
+
+static ssize_t
+Sread_mapped(void *handle, char *buf, size_t size)
+{ mapped_stream *ms = handle;
+  IOSTREAM *s = ms->stream;
+  size_t left = ms->size - ms->here;
+
+  if ( size > left )
+    size = left;
+
+  if ( (s->flags & SIO_USERBUF) && buf == s->buffer && s->bufp == buf )
+  { s->buffer = s->bufp = s->limitp = ms->base + ms->here;
+    ms->here += left;
+    return left;
+  }
+
+  memcpy(buf, ms->base + ms->here, size);
+  ms->here += size;
+
+  return size;
+}
+
+
+static int64_t
+Sseek_mapped64(void *handle, int64_t pos, int whence)
+{ mapped_stream *ms = handle;
+
+  switch(whence)
+  { case SIO_SEEK_SET:
+      break;
+    case SIO_SEEK_CUR:
+      pos += ms->here;
+      break;
+    case SIO_SEEK_END:
+      pos += ms->size;
+      break;
+    default:
+      errno = EINVAL;
+      return -1;
+  }
+
+  if ( pos < 0 || pos > (int64_t)ms->size )
+  { errno = EINVAL;
+    return -1;
+  }
+  ms->here = (size_t)pos;
+
+  return pos;
+}
+
+
+static long
+Sseek_mapped(void *handle, long pos, int whence)
+{ int64_t rc = Sseek_mapped64(handle, pos, whence);
+
+  if ( rc > LONG_MAX )
+  { errno = EINVAL;
+    return -1;
+  }
+
+  return (long)rc;
+}
+
+
+static int
+Sclose_mapped(void *handle)
+{ mapped_stream *ms = handle;
+  int rc = 0;
+
+  if ( munmap(ms->base, ms->size) != 0 )
+    rc = -1;
+  if ( close(ms->fd) != 0 )
+    rc = -1;
+  free(ms);
+
+  return rc;
+}
+
+
+static IOFUNCTIONS Smappedfunctions =
+{ Sread_mapped,
+  (Swrite_function)0,
+  Sseek_mapped,
+  Sclose_mapped,
+  (Scontrol_function)0,
+  Sseek_mapped64
+};
+
+
+static IOSTREAM *
+Sopen_mapped(int fd, int flags)
+{ struct stat buf;
+  mapped_stream *ms;
+  IOSTREAM *s;
+  void *base;
+
+  if ( fstat(fd, &buf) != 0 || !S_ISREG(buf.st_mode) ||
+       buf.st_size == 0 || (uint64_t)buf.st_size > (uint64_t)SIZE_MAX )
+    return NULL;
+  if ( (base = mmap(NULL, (size_t)buf.st_size, PROT_READ|PROT_WRITE,
+		    MAP_PRIVATE, fd, 0)) == MAP_FAILED )
+    return NULL;
+  if ( !(ms = malloc(sizeof(*ms))) )
+  { munmap(base, (size_t)buf.st_size);
+    return NULL;
+  }
+#ifdef MADV_SEQUENTIAL
+  madvise(base, (size_t)buf.st_size, MADV_SEQUENTIAL);
+#endif
+
+  ms->base = base;
+  ms->size = (size_t)buf.st_size;
+  ms->here = ms->size;
+  ms->fd   = fd;
+
+  flags &= ~(SIO_FILE|SIO_ADAPTBUF);
+  if ( !(s = Snew(ms, flags|SIO_USERBUF, &Smappedfunctions)) )
+  { munmap(base, ms->size);
+    free(ms);
+    return NULL;
+  }
+  ms->stream  = s;
+  s->unbuffer = s->buffer = s->bufp = ms->base;
+  s->limitp   = ms->base + ms->size;
+  if ( ms->size > INT_MAX )		/* peek/1 rejects tiny buffers */
+    s->bufsize = INT_MAX;
+  else if ( ms->size < SIO_BUFSIZE )
+    s->bufsize = SIO_BUFSIZE;
+  else
+    s->bufsize = (int)ms->size;
+
+  return s;
+}
+
+#else /*HAVE_MMAP*/
+
+static IOSTREAM *
+Sopen_mapped(int fd, int flags)
+{ (void)fd;
+  (void)flags;
+
+  return NULL;
+}
+
+#endif /*HAVE_MMAP*/
+
+
 IOSTREAM *
 Sfdopen(int fd, const char *type)
 { intptr_t lfd;
@@ -3691,6 +4359,339 @@ Sopenmem(char **bufp, size_t *sizep, const char *mode)
   return Snew(mf, flags, &Smemfunctions);
 }
 
+		 /*******************************
+		 *	   TEXT BUFFERS		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A text buffer is an output stream that collects text for creating an
+atom, string or code list, as used by with_output_to/2 and format/3.
+Unlike a memory stream, the stream buffer is a window at the end of the
+growing text, so flushing merely extends the text and the final text is
+available without copying it.
+
+The text is kept as ISO Latin-1 until a  wider character is written, at
+which point put_code() calls S__textbuf_widen() to convert the text and
+switch the stream to ENC_WCHAR. This way the text is normally in the
+representation used for atoms and strings.
+
+Changing the encoding  using  Ssetenc()   converts  the  text written so
+far. Text in ENC_OCTET and ENC_ASCII  is   ISO  Latin-1. Text can be
+converted between ISO Latin-1,  ENC_UTF8   and  ENC_WCHAR.  The change is
+refused if the text cannot be represented  in the new encoding or the
+new encoding is another encoding and the buffer is not empty.
+
+Sopen_textbuf() creates the stream. Stextbuf() returns the text written
+so far and its length, in characters for ENC_WCHAR and in bytes for the
+other encodings; the encoding is the encoding of the stream.
+Sreset_textbuf() prepares the stream for reuse, keeping the
+buffer. It returns -1 if the stream is not in a state that allows for
+reuse, after which it must be closed using Sclose().
+
+MT: text buffers are not passed between threads.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define TEXTBUF_INITIAL	1024		/* initial buffer size */
+#define TEXTBUF_MINFREE	256		/* grow if less is free */
+#define TEXTBUF_KEEP	(64*1024)	/* max size kept on reset */
+
+typedef struct textbuf
+{ IOSTREAM     *stream;			/* stream I belong to */
+  char	       *base;			/* start of the text */
+  size_t	committed;		/* bytes before the stream buffer */
+  size_t	allocated;		/* allocated bytes */
+} textbuf;
+
+
+static void
+S__textbuf_window(textbuf *tb)
+{ IOSTREAM *s = tb->stream;
+  size_t free = tb->allocated - tb->committed;
+
+  if ( free > INT_MAX )
+    free = INT_MAX;
+
+  s->buffer = s->unbuffer = s->bufp = tb->base + tb->committed;
+  s->limitp = s->buffer + free;
+  s->bufsize = (int)free;
+}
+
+
+static int
+S__textbuf_room(textbuf *tb, size_t needed)
+{ size_t size = tb->allocated;
+
+  while ( size < needed + TEXTBUF_MINFREE )
+    size *= 2;
+
+  if ( size != tb->allocated )
+  { char *nb;
+
+    if ( !(nb = realloc(tb->base, size)) )
+    { errno = ENOMEM;
+      return -1;
+    }
+    tb->base = nb;
+    tb->allocated = size;
+  }
+
+  return 0;
+}
+
+
+static ssize_t
+Swrite_textbuf(void *handle, char *buf, size_t size)
+{ textbuf *tb = handle;
+
+  (void)buf;				/* == tb->base + tb->committed */
+  if ( S__textbuf_room(tb, tb->committed + size) < 0 )
+    return -1;
+  tb->committed += size;
+  S__textbuf_window(tb);
+
+  return size;
+}
+
+
+static int
+Sclose_textbuf(void *handle)
+{ textbuf *tb = handle;
+
+  free(tb->base);
+  free(tb);
+
+  return 0;
+}
+
+
+static IOENC
+S__textbuf_rep(IOENC enc)
+{ switch(enc)
+  { case ENC_OCTET:
+    case ENC_ASCII:
+      return ENC_ISO_LATIN_1;
+    default:
+      return enc;
+  }
+}
+
+
+static int
+S__textbuf_getcode(IOENC enc, const char **in)
+{ int c;
+
+  switch(enc)
+  { case ENC_ISO_LATIN_1:
+      c = *(const unsigned char*)*in;
+      *in += 1;
+      break;
+    case ENC_WCHAR:
+      c = *(const pl_wchar_t*)*in;
+      *in += sizeof(pl_wchar_t);
+      break;
+    default:				/* ENC_UTF8 */
+      *in = utf8_get_char(*in, &c);
+  }
+
+  return c;
+}
+
+
+static size_t				/* 0: cannot represent */
+S__textbuf_codesize(IOENC enc, int c)
+{ switch(enc)
+  { case ENC_ISO_LATIN_1:
+      return c > 0xff ? 0 : 1;
+    case ENC_WCHAR:
+      return sizeof(pl_wchar_t);
+    default:				/* ENC_UTF8 */
+      return utf8_code_bytes(c);
+  }
+}
+
+
+static char *
+S__textbuf_putcode(IOENC enc, char *out, int c)
+{ switch(enc)
+  { case ENC_ISO_LATIN_1:
+      *out++ = (char)c;
+      return out;
+    case ENC_WCHAR:
+      *(pl_wchar_t*)out = c;
+      return out + sizeof(pl_wchar_t);
+    default:				/* ENC_UTF8 */
+      return utf8_put_char(out, c);
+  }
+}
+
+
+#define TEXTBUF_REP(enc) ((enc) == ENC_ISO_LATIN_1 || \
+			  (enc) == ENC_UTF8 || \
+			  (enc) == ENC_WCHAR)
+
+/* Convert the text written to s to enc.  Does not change s->encoding */
+
+static int
+S__textbuf_convert(IOSTREAM *s, IOENC enc)
+{ textbuf *tb = s->handle;
+  IOENC from = S__textbuf_rep(s->encoding);
+  IOENC to = S__textbuf_rep(enc);
+  size_t len = tb->committed + (s->bufp - s->buffer);
+  size_t size = 0;
+  const char *in, *end = tb->base + len;
+  char *nb, *out;
+
+  if ( from == to || len == 0 )
+    return 0;
+  if ( !TEXTBUF_REP(from) || !TEXTBUF_REP(to) )
+  { errno = EINVAL;
+    return -1;
+  }
+
+  for(in = tb->base; in < end; )
+  { size_t bytes = S__textbuf_codesize(to, S__textbuf_getcode(from, &in));
+
+    if ( bytes == 0 )
+    { errno = EINVAL;
+      return -1;
+    }
+    size += bytes;
+  }
+
+  if ( !(nb = malloc(size + TEXTBUF_MINFREE)) )
+  { errno = ENOMEM;
+    return -1;
+  }
+  for(in = tb->base, out = nb; in < end; )
+    out = S__textbuf_putcode(to, out, S__textbuf_getcode(from, &in));
+
+  free(tb->base);
+  tb->base = nb;
+  tb->allocated = size + TEXTBUF_MINFREE;
+  tb->committed = size;
+  S__textbuf_window(tb);
+
+  return 0;
+}
+
+
+static int
+Scontrol_textbuf(void *handle, int action, void *arg)
+{ textbuf *tb = handle;
+
+  switch(action)
+  { case SIO_SETENCODING:
+      return S__textbuf_convert(tb->stream, *(IOENC*)arg);
+    case SIO_FLUSHOUTPUT:
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+
+static IOFUNCTIONS Stextbuffunctions =
+{ NULL,
+  Swrite_textbuf,
+  NULL,
+  Sclose_textbuf,
+  Scontrol_textbuf
+};
+
+
+static int
+S__textbuf_widen(IOSTREAM *s)
+{ if ( S__textbuf_convert(s, ENC_WCHAR) < 0 )
+  { S__seterror(s);
+    return -1;
+  }
+  s->encoding = ENC_WCHAR;
+
+  return 0;
+}
+
+
+#define TEXTBUF_FLAGS (SIO_FBUF|SIO_RECORDPOS|SIO_NOMUTEX|SIO_TEXT|\
+		       SIO_OUTPUT|SIO_USERBUF)
+
+IOSTREAM *
+Sopen_textbuf(void)
+{ textbuf *tb;
+  IOSTREAM *s;
+
+  if ( !(tb = malloc(sizeof(*tb))) )
+  { errno = ENOMEM;
+    return NULL;
+  }
+  if ( !(tb->base = malloc(TEXTBUF_INITIAL)) )
+  { free(tb);
+    errno = ENOMEM;
+    return NULL;
+  }
+  tb->committed = 0;
+  tb->allocated = TEXTBUF_INITIAL;
+
+  if ( !(s = Snew(tb, TEXTBUF_FLAGS, &Stextbuffunctions)) )
+  { Sclose_textbuf(tb);
+    return NULL;
+  }
+  tb->stream = s;
+  s->encoding = ENC_ISO_LATIN_1;
+  S__textbuf_window(tb);
+
+  return s;
+}
+
+
+void *
+Stextbuf(IOSTREAM *s, size_t *lenp)
+{ textbuf *tb = s->handle;
+  size_t len = tb->committed + (s->bufp - s->buffer);
+
+  if ( s->encoding == ENC_WCHAR )
+    len /= sizeof(pl_wchar_t);
+  *lenp = len;
+
+  return tb->base;
+}
+
+
+int
+Sreset_textbuf(IOSTREAM *s)
+{ textbuf *tb = s->handle;
+
+  if ( !Sistextbuf(s) || s->magic != SIO_MAGIC ||
+       s->context || s->tee || s->locks || s->references ||
+       s->message || s->exception || s->close_hook ||
+       (s->flags & (SIO_FERR|SIO_WARN|SIO_CLOSING)) )
+    return -1;
+
+  if ( tb->allocated > TEXTBUF_KEEP )
+  { char *nb;
+
+    if ( !(nb = realloc(tb->base, TEXTBUF_INITIAL)) )
+      return -1;
+    tb->base = nb;
+    tb->allocated = TEXTBUF_INITIAL;
+  }
+  tb->committed = 0;
+  S__textbuf_window(tb);
+
+  s->flags    = TEXTBUF_FLAGS;
+  s->encoding = ENC_ISO_LATIN_1;
+  s->lastc    = EOF;
+  s->timeout  = -1;
+  s->io_errno = 0;
+  s->reads    = 0;
+  s->writes   = 0;
+  memset(&s->posbuf, 0, sizeof(s->posbuf));
+  s->posbuf.lineno = 1;
+  s->position = &s->posbuf;
+
+  return 0;
+}
+
+
 		 /*******************************
 		 *	      STRINGS		*
 		 *******************************/
@@ -105,6 +105,7 @@ static void *	htable_put(Table ht, KVS kvs, void *name, void *value, int flags);
 #define HTABLE_NORMAL   0x1
 #define HTABLE_RESIZE   0x2
 #define HTABLE_PRESERVE 0x4
+#define HTABLE_OLD      0x8		/* return old value (or NULL) */
 
 #define HTABLE_TOMBSTONE ((void*)-1)
 #define HTABLE_SENTINEL  ((void*)-2)
@@ -424,6 +425,9 @@ redo:
     }
   }
 
+  if ( (flags & HTABLE_OLD) )
+    return (v == HTABLE_TOMBSTONE ? NULL : v);
+
   return (value == HTABLE_TOMBSTONE ? v : value);
 }
 
@@ -579,6 +583,29 @@ updateHTable(Table ht, void *name, void *value)
 }
 
 
+/* replaceHTable() is as updateHTable(), but returns the value it
+   replaced or NULL if name was not in the table.  This allows the
+   caller to reclaim the old value.
+*/
+
+void*
+replaceHTable(Table ht, void *name, void *value)
+{ GET_LD
+  KVS kvs;
+  void *v;
+
+  acquire_kvs(ht, kvs);
+
+  DEBUG(MSG_HASH_TABLE_API,
+        Sdprintf("replaceHTable(). ht: %p, kvs: %p, name: %p, value: %p\n", ht, kvs, name, value));
+
+  v = htable_put(ht, kvs, name, value, HTABLE_NORMAL|HTABLE_OLD);
+  release_kvs();
+
+  return v;
+}
+
+
 void*
 deleteHTable(Table ht, void *name)
 { GET_LD
@@ -76,6 +76,7 @@ COMMON(void*)		lookupHTable__LD(Table ht, void *name ARG_LD);
 COMMON(void*)		addHTable(Table ht, void *name, void *value);
 COMMON(void)		addNewHTable(Table ht, void *name, void *value);
 COMMON(void*)		updateHTable(Table ht, void *name, void *value);
+COMMON(void*)		replaceHTable(Table ht, void *name, void *value);
 COMMON(void*)		deleteHTable(Table ht, void *name);
 COMMON(void)		clearHTable(Table ht);
 COMMON(Table)		copyHTable(Table org);
@@ -106,12 +106,12 @@ text_chr(const PL_chars_t *t, int chr)
 { assert(t->canonical);
   if ( t->encoding == ENC_ISO_LATIN_1 )
   { if ( chr <= 0xff )
-    { char *e = strchr(t->text.t, chr);
+    { char *e = memchr(t->text.t, chr, t->length);
       if ( e )
 	return e-t->text.t;
     }
   } else
-  { wchar_t *e = wcschr(t->text.w, chr);
+  { wchar_t *e = wmemchr(t->text.w, chr, t->length);
     if ( e )
       return(e-t->text.w);
   }
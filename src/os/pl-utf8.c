@@ -34,6 +34,11 @@
 */
 
 #include <string.h>			/* get size_t */
+#include <stddef.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "pl-utf8.h"
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -98,6 +103,7 @@ _PL__utf8_type(const char *in, size_t len)
 { const char *end = &in[len];
   int type = S_ASCII;
 
+  in = utf8_skip_ascii(in, end);
   while ( in < end )
   { int chr;
     in = utf8_get_char(in, &chr);
@@ -148,17 +154,60 @@ _PL__utf8_put_char(char *out, int chr)
 size_t
 utf8_strlen(const char *s, size_t len)
 { const char *e = &s[len];
-  unsigned int l = 0;
+  size_t l = 0;
 
   while(s<e)
-  { s = utf8_skip_char_e(s, e);
-    l++;
+  { const char *a = utf8_skip_ascii(s, e);
+
+    l += a-s;
+    if ( (s=a) < e )
+    { s = utf8_skip_char_e(s, e);
+      l++;
+    }
   }
 
   return l;
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+utf8_skip_ascii() returns a pointer to the first  byte in [in,end) that
+is not ASCII or `end`. Most text is ASCII, so this is the fast path for
+bulk decoding and validation.  We test 16 bytes at a time using SSE2 if
+available and a machine word at a time otherwise.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define ASCII_WORD_MASK ((uintptr_t)0x8080808080808080ULL)
+
+const char *
+utf8_skip_ascii(const char *in, const char *end)
+{
+#ifdef __SSE2__
+  while ( end-in >= 16 )
+  { __m128i v = _mm_loadu_si128((const __m128i*)in);
+
+    if ( _mm_movemask_epi8(v) )
+      break;
+    in += 16;
+  }
+#else
+  while ( end-in >= (ptrdiff_t)sizeof(uintptr_t) )
+  { uintptr_t w;
+
+    memcpy(&w, in, sizeof(w));
+    if ( (w & ASCII_WORD_MASK) )
+      break;
+    in += sizeof(w);
+  }
+#endif
+
+  while ( in < end && !(*in & 0x80) )
+    in++;
+
+  return in;
+}
+
+
 size_t
 utf8_strlen1(const char *s)
 { unsigned int l = 0;
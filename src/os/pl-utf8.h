@@ -71,6 +71,7 @@ extern char *_PL__utf8_skip_char(const char *out);
 extern size_t utf8_strlen(const char *s, size_t len);
 extern size_t utf8_strlen1(const char *s);
 extern const char *utf8_skip(const char *s, size_t n);
+extern const char *utf8_skip_ascii(const char *in, const char *end);
 extern int    utf8_strncmp(const char *s1, const char *s2, size_t n);
 
 typedef enum {
@@ -773,6 +773,360 @@ put_fastheap(fastheap_term *fht, term_t t ARG_LD)
 }
 
 
+		 /*******************************
+		 *	   SHARED TERMS		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Shared terms are ground terms that are stored once as a fastheap_term and
+can be used by all threads without copying the  term. A handle is a blob
+that refers to a cell of the stored term,   where  the handle created by
+shared_term_create/2 refers to cell 0. shared_term_arg/3  creates handles
+for compound arguments, such that large terms can be navigated and only
+the parts that are needed are copied to the stack using shared_term/2.
+
+All handles keep a reference to the   store. As handles are atoms, they
+can be passed to other threads using thread_create/3, thread_send_message/2,
+etc. at the cost of an atom and  the   store  is reclaimed by atom garbage
+collection after the last handle has gone.
+
+Pointers in the fastheap data are relative   to  the data, offset by the
+difference between gBase and base_addresses[STG_GLOBAL]  at the moment the
+term was stored (see term_to_fastheap()).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct shared_term_store
+{ fastheap_term *fht;			/* The stored term */
+  size_t	 go;			/* gBase-base when stored */
+  unsigned int	 references;		/* # handles */
+} shared_term_store;
+
+typedef struct shared_term_ref
+{ shared_term_store *store;		/* The store */
+  size_t	     offset;		/* Cell in store->fht->data */
+} shared_term_ref;
+
+typedef struct shared_term_copy
+{ size_t	     from;		/* Cell in the store */
+  Word		     to;		/* Cell on the global stack */
+} shared_term_copy;
+
+#define ST_INDEX(st, w) ((size_t)((w)>>PTR_SHIFT) - (st)->go)
+
+
+static int
+write_shared_term_ref(IOSTREAM *s, atom_t aref, int flags)
+{ shared_term_ref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)flags;
+
+  Sfprintf(s, "<shared_term>(%p,%zd)", ref->store, ref->offset);
+  return TRUE;
+}
+
+
+static int
+release_shared_term_ref(atom_t aref)
+{ shared_term_ref *ref = PL_blob_data(aref, NULL, NULL);
+  shared_term_store *st = ref->store;
+
+  if ( ATOMIC_DEC(&st->references) == 0 )
+  { free_fastheap(st->fht);
+    freeHeap(st, sizeof(*st));
+  }
+
+  return TRUE;
+}
+
+
+static int
+save_shared_term_ref(atom_t aref, IOSTREAM *fd)
+{ shared_term_ref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)fd;
+
+  return PL_warning("Cannot save reference to <shared_term>(%p,%zd)",
+		    ref->store, ref->offset);
+}
+
+
+static atom_t
+load_shared_term_ref(IOSTREAM *fd)
+{ (void)fd;
+
+  return PL_new_atom("<saved-shared_term-ref>");
+}
+
+
+static PL_blob_t shared_term_blob =
+{ PL_BLOB_MAGIC,
+  PL_BLOB_UNIQUE,
+  "shared_term",
+  release_shared_term_ref,
+  NULL,
+  write_shared_term_ref,
+  NULL,
+  save_shared_term_ref,
+  load_shared_term_ref
+};
+
+
+static int
+get_shared_term(term_t t, shared_term_ref **refp)
+{ void *data;
+  PL_blob_t *type;
+
+  if ( PL_get_blob(t, &data, NULL, &type) && type == &shared_term_blob )
+  { *refp = data;
+    return TRUE;
+  }
+
+  return PL_type_error("shared_term", t);
+}
+
+
+static int
+unify_shared_term(term_t t, shared_term_store *st, size_t offset)
+{ GET_LD
+  shared_term_ref ref;
+  atom_t a;
+  int new, rc;
+
+  memset(&ref, 0, sizeof(ref));		/* blob compares the bytes */
+  ref.store  = st;
+  ref.offset = offset;
+  a = lookupBlob((void*)&ref, sizeof(ref), &shared_term_blob, &new);
+  if ( new )
+    ATOMIC_INC(&st->references);
+  rc = PL_unify_atom(t, a);
+  PL_unregister_atom(a);		/* reclaim on GC */
+
+  return rc;
+}
+
+
+static size_t
+shared_term_deref(shared_term_store *st, size_t i)
+{ Word data = st->fht->data;
+
+  while( isRef(data[i]) )
+    i = ST_INDEX(st, data[i]);
+
+  return i;
+}
+
+
+/* shared_term_cells() computes the number of global stack cells needed
+   to copy the sub term at cell i.
+*/
+
+static size_t
+shared_term_cells(shared_term_store *st, size_t i)
+{ Word data = st->fht->data;
+  tmp_buffer agenda;
+  size_t cells = 0;
+
+  initBuffer(&agenda);
+  for(;;)
+  { word w;
+
+    i = shared_term_deref(st, i);
+    w = data[i];
+    if ( isTerm(w) )
+    { size_t f = ST_INDEX(st, w);
+      size_t arity = arityFunctor(data[f]);
+
+      cells += arity+1;
+      for(; arity > 0; arity--)
+	addBuffer(&agenda, f+arity, size_t);
+    } else if ( isIndirect(w) )
+    { cells += wsizeofInd(data[ST_INDEX(st, w)])+2;
+    }
+
+    if ( isEmptyBuffer(&agenda) )
+      break;
+    i = popBuffer(&agenda, size_t);
+  }
+  discardBuffer(&agenda);
+
+  return cells;
+}
+
+
+/* shared_term_word() creates the word for cell i on the global stack.
+   Arguments of compounds are added to the agenda.  The caller must
+   have ensured there is enough space on the global stack.
+*/
+
+static word
+shared_term_word(shared_term_store *st, size_t i, Buffer agenda ARG_LD)
+{ Word data = st->fht->data;
+  word w;
+
+  i = shared_term_deref(st, i);
+  w = data[i];
+  if ( isTerm(w) )
+  { size_t f = ST_INDEX(st, w);
+    size_t arity = arityFunctor(data[f]);
+    Word p = gTop;
+
+    gTop += arity+1;
+    p[0] = data[f];
+    for(; arity > 0; arity--)
+    { shared_term_copy c;
+
+      c.from = f+arity;
+      c.to   = p+arity;
+      addBuffer(agenda, c, shared_term_copy);
+    }
+
+    return consPtr(p, TAG_COMPOUND|STG_GLOBAL);
+  } else if ( isIndirect(w) )
+  { Word ip = &data[ST_INDEX(st, w)];
+    size_t n = wsizeofInd(*ip)+2;
+    Word p = gTop;
+
+    gTop += n;
+    memcpy(p, ip, n*sizeof(word));
+
+    return consPtr(p, tag(w)|STG_GLOBAL);
+  }
+
+  return w;				/* atom or small integer */
+}
+
+
+static int
+put_shared_term(term_t t, shared_term_store *st, size_t offset ARG_LD)
+{ size_t cells;
+  tmp_buffer agenda;
+  word w;
+
+  if ( offset == 0 )
+    return put_fastheap(st->fht, t PASS_LD);
+
+  cells = shared_term_cells(st, offset);
+  if ( !hasGlobalSpace(cells) )
+  { int rc;
+
+    if ( (rc=ensureGlobalSpace(cells, ALLOW_GC|ALLOW_SHIFT)) != TRUE )
+      return raiseStackOverflow(rc);
+  }
+
+  initBuffer(&agenda);
+  w = shared_term_word(st, offset, (Buffer)&agenda PASS_LD);
+  while( !isEmptyBuffer(&agenda) )
+  { shared_term_copy c = popBuffer(&agenda, shared_term_copy);
+
+    *c.to = shared_term_word(st, c.from, (Buffer)&agenda PASS_LD);
+  }
+  discardBuffer(&agenda);
+
+  *valTermRef(t) = w;
+  return TRUE;
+}
+
+
+static
+PRED_IMPL("shared_term_create", 2, shared_term_create, 0)
+{ PRED_LD
+  shared_term_store *st;
+  fastheap_term *fht;
+
+  if ( !PL_is_ground(A1) )
+    return PL_error(NULL, 0, NULL, ERR_INSTANTIATION);
+  if ( !PL_is_acyclic(A1) )
+    return PL_type_error("acyclic_term", A1);
+  if ( !(fht = term_to_fastheap(A1 PASS_LD)) )
+    return FALSE;
+
+  st = allocHeapOrHalt(sizeof(*st));
+  st->fht        = fht;
+  st->go         = gBase - (Word)base_addresses[STG_GLOBAL];
+  st->references = 0;
+
+  return unify_shared_term(A2, st, 0);
+}
+
+
+static
+PRED_IMPL("shared_term", 2, shared_term, 0)
+{ PRED_LD
+  shared_term_ref *ref = NULL;
+  term_t t;
+
+  if ( !get_shared_term(A1, &ref) )
+    return FALSE;
+
+  return ( (t = PL_new_term_ref()) &&
+	   put_shared_term(t, ref->store, ref->offset PASS_LD) &&
+	   PL_unify(A2, t) );
+}
+
+
+static
+PRED_IMPL("shared_term_arg", 3, shared_term_arg, 0)
+{ PRED_LD
+  shared_term_ref *ref = NULL;
+  shared_term_store *st;
+  size_t i, f, a;
+  word w;
+  int n;
+
+  if ( !PL_get_integer_ex(A1, &n) ||
+       !get_shared_term(A2, &ref) )
+    return FALSE;
+
+  st = ref->store;
+  i  = shared_term_deref(st, ref->offset);
+  w  = st->fht->data[i];
+  if ( !isTerm(w) )
+    return PL_type_error("compound", A2);
+  f = ST_INDEX(st, w);
+  if ( n < 1 || (size_t)n > arityFunctor(st->fht->data[f]) )
+    return FALSE;
+
+  a = shared_term_deref(st, f+n);
+  if ( isTerm(st->fht->data[a]) )
+  { return unify_shared_term(A3, st, a);
+  } else
+  { term_t t;
+
+    return ( (t = PL_new_term_ref()) &&
+	     put_shared_term(t, st, a PASS_LD) &&
+	     PL_unify(A3, t) );
+  }
+}
+
+
+static
+PRED_IMPL("shared_term_functor", 3, shared_term_functor, 0)
+{ PRED_LD
+  shared_term_ref *ref = NULL;
+  shared_term_store *st;
+  size_t i;
+  word w;
+
+  if ( !get_shared_term(A1, &ref) )
+    return FALSE;
+
+  st = ref->store;
+  i  = shared_term_deref(st, ref->offset);
+  w  = st->fht->data[i];
+  if ( isTerm(w) )
+  { functor_t fd = st->fht->data[ST_INDEX(st, w)];
+
+    return ( PL_unify_atom(A2, nameFunctor(fd)) &&
+	     PL_unify_integer(A3, arityFunctor(fd)) );
+  } else
+  { term_t t;
+
+    return ( (t = PL_new_term_ref()) &&
+	     put_shared_term(t, st, i PASS_LD) &&
+	     PL_unify(A2, t) &&
+	     PL_unify_integer(A3, 0) );
+  }
+}
+
+
 		 /*******************************
 		 *	  PROLOG BINDING	*
 		 *******************************/
@@ -831,4 +1185,8 @@ BeginPredDefs(copyterm)
   PRED_DEF("copy_term", 2, copy_term, PL_FA_ISO)
   PRED_DEF("duplicate_term", 2, duplicate_term, 0)
   PRED_DEF("copy_term_nat", 2, copy_term_nat, 0)
+  PRED_DEF("shared_term_create", 2, shared_term_create, 0)
+  PRED_DEF("shared_term", 2, shared_term, 0)
+  PRED_DEF("shared_term_arg", 3, shared_term_arg, 0)
+  PRED_DEF("shared_term_functor", 3, shared_term_functor, 0)
 EndPredDefs
@@ -182,6 +182,7 @@ const debug_topic debug_topics[] =
   DEBUG_TOPIC(MSG_TABLING_WORK),
   DEBUG_TOPIC(MSG_TABLING_MODED),
   DEBUG_TOPIC(MSG_TABLING_NEG),
+  DEBUG_TOPIC(MSG_TABLING_EVICT),
 
   DEBUG_TOPIC(CHK_SECURE),
   DEBUG_TOPIC(CHK_HIGH_ARITY),
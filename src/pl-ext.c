@@ -347,6 +347,7 @@ DECL_PLIST(arith);
 DECL_PLIST(bag);
 DECL_PLIST(comp);
 DECL_PLIST(flag);
+DECL_PLIST(shmap);
 DECL_PLIST(index);
 DECL_PLIST(list);
 DECL_PLIST(module);
@@ -406,6 +407,7 @@ initBuildIns(void)
   REG_PLIST(bag);
   REG_PLIST(comp);
   REG_PLIST(flag);
+  REG_PLIST(shmap);
   REG_PLIST(index);
   REG_PLIST(list);
   REG_PLIST(module);
@@ -511,6 +513,9 @@ initBuildIns(void)
 
   PL_meta_predicate(PL_predicate("notrace",          1, "system"), "0");
   PL_meta_predicate(PL_predicate("with_mutex",       2, "system"), "+0");
+  PL_meta_predicate(PL_predicate("with_read_lock",   2, "system"), "+0");
+  PL_meta_predicate(PL_predicate("with_write_lock",  2, "system"), "+0");
+  PL_meta_predicate(PL_predicate("with_optimistic_read", 2, "system"), "+0");
   PL_meta_predicate(PL_predicate("with_output_to",   2, "system"), "+0");
 #ifdef O_PLMT
   PL_meta_predicate(PL_predicate("thread_create",    3, "system"), "0?+");
@@ -41,12 +41,17 @@ typedef enum flag_type
   FLG_FLOAT
 } flag_type;
 
+/* The integer value is not part of the union, such that atomic_add/3
+   and atomic_cas/4 can update it without locking while set_flag/2
+   concurrently changes the type of the flag.
+*/
+
 typedef struct flag
 { word	key;				/* key to the flag */
   int	type;				/* type (atom, int, float */
+  int64_t i;				/* integer value (FLG_INTEGER) */
   union
   { atom_t  a;				/* atom */
-    int64_t i;				/* integer */
     double  f;				/* float */
   } value;				/* value of the flag */
 } *Flag;
@@ -98,7 +103,7 @@ lookupFlag(word key)
   if ( isAtom(key) )
     PL_register_atom(key);
   f->type = FLG_INTEGER;
-  f->value.i = 0;
+  f->i = 0;
   if ( (of=addHTable(flagTable, (void *)key, f)) != f )
   { freeHeap(f, sizeof(*f));
     f = of;
@@ -115,27 +120,17 @@ freeFlagValue(Flag f)
 }
 
 
-static
-PRED_IMPL("get_flag", 2, get_flag, 0)
-{ PRED_LD
-  Flag f;
-  word key;
-  int rc;
-
-  term_t name  = A1;
-  term_t value = A2;
-
-  if ( !getKeyEx(name, &key PASS_LD) )
-    return FALSE;
+static int
+unify_flag_value(Flag f, term_t value ARG_LD)
+{ int rc;
 
-  f = lookupFlag(key);
   PL_LOCK(L_FLAG);
   switch(f->type)
   { case FLG_ATOM:
       rc = PL_unify_atom(value, f->value.a);
       break;
     case FLG_INTEGER:
-      rc = PL_unify_int64(value, f->value.i);
+      rc = PL_unify_int64(value, f->i);
       break;
     case FLG_FLOAT:
       rc = PL_unify_float(value, f->value.f);
@@ -150,6 +145,23 @@ PRED_IMPL("get_flag", 2, get_flag, 0)
 }
 
 
+static
+PRED_IMPL("get_flag", 2, get_flag, 0)
+{ PRED_LD
+  Flag f;
+  word key;
+
+  term_t name  = A1;
+  term_t value = A2;
+
+  if ( !getKeyEx(name, &key PASS_LD) )
+    return FALSE;
+
+  f = lookupFlag(key);
+  return unify_flag_value(f, value PASS_LD);
+}
+
+
 static
 PRED_IMPL("set_flag", 2, set_flag, 0)
 { PRED_LD
@@ -179,7 +191,7 @@ PRED_IMPL("set_flag", 2, set_flag, 0)
       { PL_LOCK(L_FLAG);
 	freeFlagValue(f);
 	f->type = FLG_INTEGER;
-	f->value.i = n.value.i;
+	f->i = n.value.i;
 	PL_UNLOCK(L_FLAG);
 	return TRUE;
       }
@@ -208,6 +220,76 @@ PRED_IMPL("set_flag", 2, set_flag, 0)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+atomic_add/3 and atomic_cas/4 provide  lock-free   updates  of integer
+flags. They are atomic with respect to  each other, set_flag/2 and
+flag/3. The flag must hold an integer.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+get_integer_flag(term_t name, Flag *fp ARG_LD)
+{ word key;
+  Flag f;
+
+  if ( !getKeyEx(name, &key PASS_LD) )
+    return FALSE;
+  f = lookupFlag(key);
+
+  if ( f->type != FLG_INTEGER )
+  { term_t v;
+
+    return ( (v=PL_new_term_ref()) &&
+	     unify_flag_value(f, v PASS_LD) &&
+	     PL_type_error("integer", v) );
+  }
+
+  *fp = f;
+  return TRUE;
+}
+
+
+static
+PRED_IMPL("atomic_add", 3, atomic_add, 0)
+{ PRED_LD
+  Flag f;
+  int64_t delta, old, new;
+
+  if ( !PL_get_int64_ex(A2, &delta) ||
+       !get_integer_flag(A1, &f PASS_LD) )
+    return FALSE;
+
+  do
+  { old = f->i;
+    if ( (delta > 0 && old > INT64_MAX-delta) ||
+	 (delta < 0 && old < INT64_MIN-delta) )
+      return PL_error(NULL, 0, NULL, ERR_EVALUATION, ATOM_int_overflow);
+    new = old+delta;
+  } while( !COMPARE_AND_SWAP(&f->i, old, new) );
+
+  return PL_unify_int64(A3, new);
+}
+
+
+static
+PRED_IMPL("atomic_cas", 4, atomic_cas, 0)
+{ PRED_LD
+  Flag f;
+  int64_t expected, new, old;
+
+  if ( !PL_get_int64_ex(A2, &expected) ||
+       !PL_get_int64_ex(A3, &new) ||
+       !get_integer_flag(A1, &f PASS_LD) )
+    return FALSE;
+
+  do
+  { if ( (old = f->i) != expected )
+      break;
+  } while( !COMPARE_AND_SWAP(&f->i, old, new) );
+
+  return PL_unify_int64(A4, old);
+}
+
+
 word
 pl_current_flag(term_t k, control_t h)
 { GET_LD
@@ -256,4 +338,6 @@ pl_current_flag(term_t k, control_t h)
 BeginPredDefs(flag)
   PRED_DEF("get_flag", 2, get_flag, 0)
   PRED_DEF("set_flag", 2, set_flag, 0)
+  PRED_DEF("atomic_add", 3, atomic_add, 0)
+  PRED_DEF("atomic_cas", 4, atomic_cas, 0)
 EndPredDefs
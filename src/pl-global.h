@@ -178,6 +178,10 @@ struct PL_global_data
   { Table	record_lists;		/* Available record lists */
   } recorded_db;
 
+  struct
+  { Table	space_limits;		/* Definition --> table space budget */
+  } tabling;
+
   struct
   { ArithF     *functions;		/* index --> function */
     size_t	functions_allocated;	/* Size of above array */
@@ -341,6 +345,7 @@ struct PL_global_data
   { struct _at_exit_goal *exit_goals;	/* Global thread_at_exit/1 goals */
     int			enabled;	/* threads are enabled */
     Table		mutexTable;	/* Name --> mutex table */
+    Table		rwlockTable;	/* Alias --> rwlock table */
     int			mutex_next_id;	/* next id for anonymous mutexes */
 #ifdef __WINDOWS__
     HINSTANCE		instance;	/* Win32 process instance */
@@ -348,9 +353,17 @@ struct PL_global_data
     counting_mutex     *mutexes;	/* Registered mutexes */
     PL_thread_info_t   *free;		/* Free threads */
     int			highest_allocated; /* Highest with info struct */
+    int			ldata_access;	/* # threads using acquire_ldata() */
     int			thread_max;	/* Size of threads array */
     PL_thread_info_t  **threads;	/* Pointers to thread-info */
     struct
+    { int		size;		/* Max cached items (thread_cache_size) */
+      int		ld_count;	/* # cached local data blocks */
+      int		stack_count;	/* # cached stack sets */
+      PL_local_data_t  *local_data;	/* Cached local data blocks */
+      struct stack_set *stacks;		/* Cached initial stacks */
+    } cache;
+    struct
     { pthread_mutex_t	mutex;
       pthread_cond_t	cond;
       unsigned int	requests;
@@ -559,6 +572,14 @@ struct PL_local_data
     struct trie *variant_table;		/* Variant --> table */
     trie_allocation_pool node_pool;	/* Node allocation pool for tries */
     int	has_scheduling_component;	/* A leader was created */
+    struct
+    { struct trie *head;		/* Most recently used completed table */
+      struct trie *tail;		/* Least recently used completed table */
+      size_t	count;			/* # completed tables */
+      size_t	bytes;			/* Bytes in completed tables */
+      size_t	evictions;		/* # evicted tables */
+      Table	predicates;		/* Definition --> bytes in completed tables */
+    } lru;
   } tabling;
 
   struct
@@ -609,6 +630,7 @@ struct PL_local_data
 					/* do not copy from parent */
     struct input_context *input_stack;	/* maintain input stream info */
     struct output_context *output_stack; /* maintain output stream info */
+    IOSTREAM *redirect_stream;		/* cached Sopen_textbuf() stream */
     int	portray_nesting;		/* depth of portray nesting */
   } IO;
 
@@ -2191,9 +2191,6 @@ typedef struct redir_context
   term_t	term;			/* redirect target */
   int		out_format;		/* output type */
   int		out_arity;		/* 2 for difference-list versions */
-  size_t	size;			/* size of I/O buffer */
-  char	       *data;			/* data written */
-  char		buffer[1024];		/* fast temporary buffer */
 } redir_context;
 
 
@@ -2381,6 +2378,7 @@ typedef struct debuginfo
 #define PLFLAG_ERROR_AMBIGUOUS_STREAM_PAIR 0x04000000
 #define PLFLAG_GCTHREAD		    0x08000000 /* Do atom/clause GC in a thread */
 #define PLFLAG_MITIGATE_SPECTRE	    0x10000000 /* Mitigate spectre attacks */
+#define PLFLAG_TABLE_STATISTICS	    0x20000000 /* Maintain tabling statistics */
 
 typedef struct
 { unsigned int flags;		/* Fast access to some boolean Prolog flags */
@@ -609,15 +609,32 @@ popArgvArithStack(int n ARG_LD)
 		 *******************************/
 
 #ifdef O_PLMT
+/* GD->thread.ldata_access counts the threads with access.ldata set,
+   allowing ldata_in_use() to avoid scanning all threads
+*/
+
 static inline PL_local_data_t *
 acquire_ldata__LD(PL_thread_info_t *info ARG_LD)
 { PL_local_data_t *ld = info->thread_data;
+  if ( !LD->thread.info->access.ldata )
+    ATOMIC_INC(&GD->thread.ldata_access);
   LD->thread.info->access.ldata = ld;
   if ( ld && ld->magic == LD_MAGIC )
     return ld;
   LD->thread.info->access.ldata = NULL;
+  ATOMIC_DEC(&GD->thread.ldata_access);
   return NULL;
 }
+
+static inline void
+release_ldata__LD(PL_local_data_t *ld ARG_LD)
+{ (void)ld;
+
+  if ( LD->thread.info->access.ldata )
+  { LD->thread.info->access.ldata = NULL;
+    ATOMIC_DEC(&GD->thread.ldata_access);
+  }
+}
 #endif
 
 
@@ -343,26 +343,40 @@ PL_mutex_lock(struct pl_mutex *m)
   { m->count++;
   } else
   { int rc;
-#ifdef HAVE_PTHREAD_MUTEX_TIMEDLOCK
-    for(;;)
-    { struct timespec deadline;
+    int every = _PL_lock_profile;
+    uint64_t t0 = 0;
+    int contended = FALSE;
 
-      get_current_timespec(&deadline);
-      deadline.tv_nsec += 250000000;
-      carry_timespec_nanos(&deadline);
+    if ( unlikely(every) && lockProfileSample(&m->profile, every) )
+      t0 = lockProfileClock();
 
-      if ( (rc=pthread_mutex_timedlock(&m->mutex, &deadline)) == ETIMEDOUT )
-      { if ( PL_handle_signals() < 0 )
-	  return FALSE;
-      } else
-	break;
-    }
+    if ( t0 && pthread_mutex_trylock(&m->mutex) == 0 )
+    { rc = 0;
+    } else
+    { contended = TRUE;
+#ifdef HAVE_PTHREAD_MUTEX_TIMEDLOCK
+      for(;;)
+      { struct timespec deadline;
+
+	get_current_timespec(&deadline);
+	deadline.tv_nsec += 250000000;
+	carry_timespec_nanos(&deadline);
+
+	if ( (rc=pthread_mutex_timedlock(&m->mutex, &deadline)) == ETIMEDOUT )
+	{ if ( PL_handle_signals() < 0 )
+	    return FALSE;
+	} else
+	  break;
+      }
 #else
-    rc = pthread_mutex_lock(&m->mutex);
+      rc = pthread_mutex_lock(&m->mutex);
 #endif
+    }
     assert(rc == 0);
     m->count = 1;
     m->owner = self;
+    if ( unlikely(every) )
+      lockProfileAcquired(&m->profile, t0, contended);
   }
 
   return TRUE;
@@ -417,6 +431,8 @@ PL_mutex_unlock(struct pl_mutex *m)
   if ( self == m->owner )
   { if ( --m->count == 0 )
     { m->owner = 0;
+      if ( unlikely(m->profile.hold_start) )
+	lockProfileReleased(&m->profile);
 
       pthread_mutex_unlock(&m->mutex);
     }
@@ -470,6 +486,8 @@ PRED_IMPL("mutex_unlock_all", 0, mutex_unlock_all, 0)
   { if ( m->owner == tid )
     { m->count = 0;
       m->owner = 0;
+      if ( m->profile.hold_start )
+	lockProfileReleased(&m->profile);
       pthread_mutex_unlock(&m->mutex);
     }
   }
@@ -708,6 +726,608 @@ enumerate:
   }
 }
 
+		 /*******************************
+		 *	  READ/WRITE LOCKS	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Read/write locks for Prolog (with_read_lock/2, with_write_lock/2). These
+are implemented using a mutex and two condition variables rather than a
+pthread_rwlock_t because we must handle  signals while waiting, we want
+a portable writer preference and the  thread   holding  the  write lock
+must be able to acquire a read lock.
+
+Each acquisition and release of the   write lock increments `seq`, which
+is thus odd while a writer holds the lock. with_optimistic_read/2 runs
+its goal without locking and verifies  afterwards   that  `seq` did not
+change. If it did, the bindings are undone   and the goal is executed
+again while holding the read lock.
+
+Aliased rwlocks live in GD->thread.rwlockTable   and  are reference
+counted, such that rwlock_destroy/1 may  be   called  while  the lock is
+in use. Anonymous rwlocks are blobs   that are reclaimed by atom garbage
+collection, as for mutexes.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct pl_rwlock
+{ pthread_mutex_t mutex;		/* Protects the fields below */
+  pthread_cond_t  rcond;		/* Readers wait here */
+  pthread_cond_t  wcond;		/* Writers wait here */
+  atom_t	  id;			/* Alias or <rwlock> blob */
+  int		  readers;		/* # active readers */
+  int		  writer;		/* Thread holding the write lock */
+  int		  write_count;		/* Recursion count of writer */
+  int		  waiting_writers;	/* # writers waiting */
+  unsigned int	  references;		/* # active users (+1 for table) */
+  size_t	  seq;			/* Odd while a writer is active */
+  unsigned	  anonymous     : 1;	/* <rwlock>(0x...) */
+  unsigned	  prefer_writer : 1;	/* Block readers if writers wait */
+  unsigned	  destroyed     : 1;	/* rwlock_destroy/1 was called */
+} pl_rwlock;
+
+typedef struct rwlockref
+{ pl_rwlock	*rwlock;
+} rwlockref;
+
+
+static void
+free_rwlock(pl_rwlock *rw)
+{ pthread_cond_destroy(&rw->rcond);
+  pthread_cond_destroy(&rw->wcond);
+  pthread_mutex_destroy(&rw->mutex);
+  if ( !rw->anonymous )
+    PL_unregister_atom(rw->id);
+  freeHeap(rw, sizeof(*rw));
+}
+
+
+static void
+release_rwlock(pl_rwlock *rw)
+{ if ( ATOMIC_DEC(&rw->references) == 0 && !rw->anonymous )
+    free_rwlock(rw);
+}
+
+
+static int
+write_rwlockref(IOSTREAM *s, atom_t aref, int flags)
+{ rwlockref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)flags;
+
+  Sfprintf(s, "<rwlock>(%p)", ref->rwlock);
+  return TRUE;
+}
+
+
+static int
+release_rwlockref(atom_t aref)
+{ rwlockref *ref = PL_blob_data(aref, NULL, NULL);
+
+  if ( ref->rwlock )
+    free_rwlock(ref->rwlock);
+
+  return TRUE;
+}
+
+
+static int
+save_rwlockref(atom_t aref, IOSTREAM *fd)
+{ rwlockref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)fd;
+
+  return PL_warning("Cannot save reference to <rwlock>(%p)", ref->rwlock);
+}
+
+
+static atom_t
+load_rwlockref(IOSTREAM *fd)
+{ (void)fd;
+
+  return PL_new_atom("<saved-rwlock-ref>");
+}
+
+
+static PL_blob_t rwlock_blob =
+{ PL_BLOB_MAGIC,
+  PL_BLOB_UNIQUE,
+  "rwlock",
+  release_rwlockref,
+  NULL,
+  write_rwlockref,
+  NULL,
+  save_rwlockref,
+  load_rwlockref
+};
+
+
+static const opt_spec rwlock_options[] =
+{ { ATOM_alias,		OPT_ATOM },
+  { ATOM_prefer,	OPT_ATOM },
+  { NULL_ATOM,		0 }
+};
+
+
+/* new_rwlock() creates a new rwlock.  If alias is given, the caller
+   must hold L_UMUTEX.  Anonymous rwlocks are returned with a reference
+   to their blob that must be released after it has been unified.
+*/
+
+static pl_rwlock *
+new_rwlock(atom_t alias, int prefer_writer)
+{ pl_rwlock *rw;
+
+  if ( !(rw=allocHeap(sizeof(*rw))) )
+  { PL_no_memory();
+    return NULL;
+  }
+
+  memset(rw, 0, sizeof(*rw));
+  pthread_mutex_init(&rw->mutex, NULL);
+  pthread_cond_init(&rw->rcond, NULL);
+  pthread_cond_init(&rw->wcond, NULL);
+  rw->prefer_writer = prefer_writer;
+
+  if ( alias )
+  { rw->id = alias;
+    rw->references = 1;			/* the table */
+    PL_register_atom(alias);
+    addNewHTable(GD->thread.rwlockTable, (void *)alias, rw);
+  } else
+  { rwlockref ref;
+    int new;
+
+    ref.rwlock = rw;
+    rw->id = lookupBlob((void*)&ref, sizeof(ref), &rwlock_blob, &new);
+    rw->anonymous = TRUE;
+  }
+
+  return rw;
+}
+
+
+static int
+create_rwlock(term_t lock, term_t options)
+{ GET_LD
+  atom_t alias = 0;
+  atom_t prefer = ATOM_reader;
+  pl_rwlock *rw = NULL;
+
+  if ( options &&
+       !scan_options(options, 0,
+		     ATOM_rwlock_option, rwlock_options,
+		     &alias, &prefer) )
+    return FALSE;
+  if ( prefer != ATOM_reader && prefer != ATOM_writer )
+  { term_t ex;
+
+    return ( (ex=PL_new_term_ref()) &&
+	     PL_put_atom(ex, prefer) &&
+	     PL_domain_error("prefer", ex) );
+  }
+
+  if ( alias )
+  { int exists;
+
+    if ( !PL_unify_atom(lock, alias) )
+      return PL_error(NULL, 0, NULL, ERR_UNINSTANTIATION, 1, lock);
+
+    PL_LOCK(L_UMUTEX);
+    if ( !(exists = (lookupHTable(GD->thread.rwlockTable,
+				  (void *)alias) != NULL)) )
+      rw = new_rwlock(alias, prefer == ATOM_writer);
+    PL_UNLOCK(L_UMUTEX);
+
+    if ( exists )
+      return PL_error(NULL, 0, NULL, ERR_PERMISSION,
+		      ATOM_create, ATOM_rwlock, lock);
+    return rw != NULL;
+  } else if ( PL_is_variable(lock) )
+  { int rc;
+
+    if ( !(rw = new_rwlock(0, prefer == ATOM_writer)) )
+      return FALSE;
+    rc = PL_unify_atom(lock, rw->id);
+    PL_unregister_atom(rw->id);		/* reclaim on GC */
+
+    return rc;
+  } else
+  { return PL_error(NULL, 0, NULL, ERR_UNINSTANTIATION, 1, lock);
+  }
+}
+
+
+/* get_rwlock() finds the rwlock from its alias or blob and adds a
+   reference that must be released using release_rwlock().  If create
+   is TRUE, an unknown alias creates a new rwlock, as with_mutex/2 does
+   for mutexes.
+*/
+
+static int
+get_rwlock(term_t t, pl_rwlock **rwp, int create)
+{ GET_LD
+  atom_t name;
+  pl_rwlock *rw;
+  PL_blob_t *type;
+  rwlockref *ref;
+
+  if ( !PL_get_atom(t, &name) )
+    return PL_type_error("rwlock", t);
+
+  ref = PL_blob_data(name, NULL, &type);
+  if ( type == &rwlock_blob )
+  { rw = ref->rwlock;
+
+    if ( rw->destroyed )
+      return PL_existence_error("rwlock", t);
+    ATOMIC_INC(&rw->references);
+    *rwp = rw;
+    return TRUE;
+  } else if ( !isTextAtom(name) )
+  { return PL_type_error("rwlock", t);
+  }
+
+  PL_LOCK(L_UMUTEX);
+  if ( !(rw = lookupHTable(GD->thread.rwlockTable, (void *)name)) && create )
+    rw = new_rwlock(name, FALSE);
+  if ( rw )
+    ATOMIC_INC(&rw->references);
+  PL_UNLOCK(L_UMUTEX);
+
+  if ( rw )
+  { *rwp = rw;
+    return TRUE;
+  }
+
+  return create ? FALSE : PL_existence_error("rwlock", t);
+}
+
+
+/* Wait on cond while allowing for signal handling.  Must be called
+   with rw->mutex locked.  Returns FALSE if a signal handler raised
+   an exception.
+*/
+
+static int
+rwlock_wait(pl_rwlock *rw, pthread_cond_t *cond)
+{ struct timespec deadline;
+
+  get_current_timespec(&deadline);
+  deadline.tv_nsec += 250000000;
+  carry_timespec_nanos(&deadline);
+
+  if ( pthread_cond_timedwait(cond, &rw->mutex, &deadline) == ETIMEDOUT )
+  { int rc;
+
+    pthread_mutex_unlock(&rw->mutex);
+    rc = PL_handle_signals();
+    pthread_mutex_lock(&rw->mutex);
+
+    return rc >= 0;
+  }
+
+  return TRUE;
+}
+
+
+static int
+rwlock_read_lock(pl_rwlock *rw, int self)
+{ int rc = TRUE;
+
+  pthread_mutex_lock(&rw->mutex);
+  if ( rw->writer == self )
+  { rw->write_count++;			/* read inside write */
+  } else
+  { while( rw->writer || (rw->prefer_writer && rw->waiting_writers) )
+    { if ( !(rc=rwlock_wait(rw, &rw->rcond)) )
+	break;
+    }
+    if ( rc )
+      rw->readers++;
+  }
+  pthread_mutex_unlock(&rw->mutex);
+
+  return rc;
+}
+
+
+static void
+rwlock_read_unlock(pl_rwlock *rw, int self)
+{ pthread_mutex_lock(&rw->mutex);
+  if ( rw->writer == self )
+  { rw->write_count--;
+  } else if ( --rw->readers == 0 && rw->waiting_writers )
+  { pthread_cond_signal(&rw->wcond);
+  }
+  pthread_mutex_unlock(&rw->mutex);
+}
+
+
+static int
+rwlock_write_lock(pl_rwlock *rw, int self)
+{ int rc = TRUE;
+
+  pthread_mutex_lock(&rw->mutex);
+  if ( rw->writer == self )
+  { rw->write_count++;
+  } else
+  { rw->waiting_writers++;
+    while( rw->writer || rw->readers > 0 )
+    { if ( !(rc=rwlock_wait(rw, &rw->wcond)) )
+	break;
+    }
+    rw->waiting_writers--;
+
+    if ( rc )
+    { rw->writer = self;
+      rw->write_count = 1;
+      ATOMIC_INC(&rw->seq);		/* odd: writer active */
+    } else if ( rw->prefer_writer && !rw->waiting_writers )
+    { pthread_cond_broadcast(&rw->rcond);
+    }
+  }
+  pthread_mutex_unlock(&rw->mutex);
+
+  return rc;
+}
+
+
+static void
+rwlock_write_unlock(pl_rwlock *rw)
+{ pthread_mutex_lock(&rw->mutex);
+  if ( --rw->write_count == 0 )
+  { ATOMIC_INC(&rw->seq);		/* even: no writer */
+    rw->writer = 0;
+    if ( rw->waiting_writers )
+      pthread_cond_signal(&rw->wcond);
+    pthread_cond_broadcast(&rw->rcond);
+  }
+  pthread_mutex_unlock(&rw->mutex);
+}
+
+
+static
+PRED_IMPL("rwlock_create", 1, rwlock_create1, 0)
+{ return create_rwlock(A1, 0);
+}
+
+
+static
+PRED_IMPL("rwlock_create", 2, rwlock_create2, 0)
+{ return create_rwlock(A1, A2);
+}
+
+
+static
+PRED_IMPL("rwlock_destroy", 1, rwlock_destroy, 0)
+{ pl_rwlock *rw;
+
+  if ( !get_rwlock(A1, &rw, FALSE) )
+    return FALSE;
+
+  PL_LOCK(L_UMUTEX);
+  if ( !rw->destroyed )
+  { rw->destroyed = TRUE;
+    if ( !rw->anonymous )
+    { deleteHTable(GD->thread.rwlockTable, (void *)rw->id);
+      ATOMIC_DEC(&rw->references);	/* our reference remains */
+    }
+  }
+  PL_UNLOCK(L_UMUTEX);
+  release_rwlock(rw);
+
+  return TRUE;
+}
+
+
+		 /*******************************
+		 *	  LOCK PROFILING	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Profiling of  the  internal  counting  mutexes   (L_*,  module  and file
+locks) and the Prolog mutexes used  by   with_mutex/2  and friends. This
+is controlled by the flag lock_profile. If  this   is  N  > 0, each Nth
+acquisition of a lock is  timed:  the  wait   time  is  the time between
+requesting and obtaining the lock and the   hold  time the time until it
+is released. The data is kept in the  lock_profile struct of the mutex
+(see pl-mutex.h) and is only modified by the thread that holds the lock.
+Enabling profiling clears all profile data.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+uint64_t
+lockProfileClock(void)
+{ struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+  get_current_timespec(&ts);
+#endif
+
+  return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+
+static int
+lock_hist_bucket(uint64_t nsec)
+{ size_t usec = (size_t)(nsec/1000);
+  int b;
+
+  if ( usec == 0 )
+    return 0;
+  b = MSB(usec)+1;
+
+  return b < LOCK_HIST_SIZE ? b : LOCK_HIST_SIZE-1;
+}
+
+
+void
+lockProfileAcquired(lock_profile *p, uint64_t t0, int contended)
+{ p->acquired++;
+
+  if ( t0 )
+  { uint64_t now = lockProfileClock();
+    uint64_t wait = now-t0;
+
+    p->sampled++;
+    if ( contended )
+      p->contended++;
+    p->wait += wait;
+    p->wait_hist[lock_hist_bucket(wait)]++;
+    p->hold_start = now;
+  }
+}
+
+
+void
+lockProfileReleased(lock_profile *p)
+{ uint64_t hold = lockProfileClock() - p->hold_start;
+
+  p->hold += hold;
+  p->hold_hist[lock_hist_bucket(hold)]++;
+  p->hold_start = 0;
+}
+
+
+static void
+reset_lock_profiles(void)
+{ TableEnum e;
+  pl_mutex *m;
+
+#ifdef O_CONTENTION_STATISTICS
+  counting_mutex *cm;
+
+  PL_LOCK(L_MUTEX);
+  for(cm = GD->thread.mutexes; cm; cm = cm->next)
+  { if ( cm != &_PL_mutexes[L_MUTEX] )
+      memset(&cm->profile, 0, sizeof(cm->profile));
+  }
+  PL_UNLOCK(L_MUTEX);
+#endif
+
+  PL_LOCK(L_UMUTEX);
+  e = newTableEnum(GD->thread.mutexTable);
+  while( advanceTableEnum(e, NULL, (void**)&m) )
+    memset(&m->profile, 0, sizeof(m->profile));
+  freeTableEnum(e);
+  PL_UNLOCK(L_UMUTEX);
+}
+
+
+int
+setLockProfile(int64_t every)
+{ if ( every < 0 || every > INT_MAX )
+  { GET_LD
+    term_t t;
+
+    return ( (t=PL_new_term_ref()) &&
+	     PL_put_int64(t, every) &&
+	     PL_domain_error("lock_profile", t) );
+  }
+
+  if ( every > 0 && _PL_lock_profile == 0 )
+    reset_lock_profiles();
+  _PL_lock_profile = (int)every;
+
+  return TRUE;
+}
+
+
+static int
+unify_lock_histogram(term_t t, const unsigned int *hist)
+{ GET_LD
+  term_t tail = PL_copy_term_ref(t);
+  term_t head = PL_new_term_ref();
+  int n = LOCK_HIST_SIZE;
+
+  while( n > 0 && hist[n-1] == 0 )	/* strip empty tail */
+    n--;
+
+  for(int i=0; i<n; i++)
+  { if ( !PL_unify_list(tail, head, tail) ||
+	 !PL_unify_integer(head, hist[i]) )
+      return FALSE;
+  }
+
+  return PL_unify_nil(tail);
+}
+
+
+static int
+add_lock_profile(term_t tail, term_t name, const lock_profile *p)
+{ GET_LD
+  term_t head = PL_new_term_ref();
+  term_t av = PL_new_term_refs(2);
+
+  return ( head && av &&
+	   unify_lock_histogram(av+0, p->wait_hist) &&
+	   unify_lock_histogram(av+1, p->hold_hist) &&
+	   PL_unify_list(tail, head, tail) &&
+	   PL_unify_term(head,
+			 PL_FUNCTOR, FUNCTOR_lock7,
+			   PL_TERM, name,
+			   PL_INT64, (int64_t)p->sampled,
+			   PL_INT64, (int64_t)p->contended,
+			   PL_FLOAT, (double)p->wait/1e9,
+			   PL_FLOAT, (double)p->hold/1e9,
+			   PL_TERM, av+0,
+			   PL_TERM, av+1) );
+}
+
+
+/** lock_statistics(-Locks) is det.
+
+Locks is a list lock(Name, Sampled, Contended, Wait, Hold, WaitHist,
+HoldHist) for each internal lock and Prolog mutex for which there is
+profile data.  Internal locks are named by an atom, Prolog mutexes as
+mutex(Id).  The data is copied without locking the profiled locks and
+may thus be slightly inconsistent.
+*/
+
+static
+PRED_IMPL("lock_statistics", 1, lock_statistics, 0)
+{ PRED_LD
+  term_t tail = PL_copy_term_ref(A1);
+  term_t name = PL_new_term_ref();
+  term_t id = PL_new_term_ref();
+  lock_profile p;
+  int rc = TRUE;
+  TableEnum e;
+  pl_mutex *m;
+
+#ifdef O_CONTENTION_STATISTICS
+  counting_mutex *cm;
+
+  PL_LOCK(L_MUTEX);
+  for(cm = GD->thread.mutexes; cm && rc; cm = cm->next)
+  { p = cm->profile;
+    if ( p.sampled == 0 )
+      continue;
+    PL_put_variable(name);
+    rc = ( PL_unify_chars(name, PL_ATOM|REP_UTF8, (size_t)-1,
+			  cm->name ? cm->name : "<anonymous>") &&
+	   add_lock_profile(tail, name, &p) );
+  }
+  PL_UNLOCK(L_MUTEX);
+#endif
+
+  PL_LOCK(L_UMUTEX);
+  e = newTableEnum(GD->thread.mutexTable);
+  while( rc && advanceTableEnum(e, NULL, (void**)&m) )
+  { p = m->profile;
+    if ( p.sampled == 0 )
+      continue;
+    PL_put_variable(id);
+    rc = ( unify_mutex(id, m) &&
+	   PL_cons_functor(name, FUNCTOR_mutex1, id) &&
+	   add_lock_profile(tail, name, &p) );
+  }
+  freeTableEnum(e);
+  PL_UNLOCK(L_UMUTEX);
+
+  return rc && PL_unify_nil(tail);
+}
+
+
 		 /*******************************
 		 *	  INITIALIZATION	*
 		 *******************************/
@@ -717,11 +1337,20 @@ unalloc_mutex_symbol(void *name, void *value)
 { unalloc_mutex(value);
 }
 
+static void
+free_rwlock_symbol(void *name, void *value)
+{ free_rwlock(value);
+}
+
 void
 initMutexes(void)
 { GD->thread.mutexTable = newHTable(16);
   GD->thread.mutexTable->free_symbol = unalloc_mutex_symbol;
+  GD->thread.rwlockTable = newHTable(16);
+  GD->thread.rwlockTable->free_symbol = free_rwlock_symbol;
   initMutexRef();
+  rwlock_blob.atom_name = ATOM_rwlock;
+  PL_register_blob_type(&rwlock_blob);
 }
 
 #endif /*O_PLMT*/
@@ -750,6 +1379,97 @@ pl_with_mutex(term_t mutex, term_t goal)
 }
 
 
+#define RW_READ  0
+#define RW_WRITE 1
+
+static int
+with_rwlock(term_t lock, term_t goal, int mode)
+{ int rval;
+
+#ifdef O_PLMT
+  pl_rwlock *rw;
+  int self = PL_thread_self();
+
+  if ( !get_rwlock(lock, &rw, TRUE) )
+    return FALSE;
+
+  if ( mode == RW_WRITE ? rwlock_write_lock(rw, self)
+		        : rwlock_read_lock(rw, self) )
+  { rval = callProlog(NULL, goal, PL_Q_PASS_EXCEPTION, NULL);
+    if ( mode == RW_WRITE )
+      rwlock_write_unlock(rw);
+    else
+      rwlock_read_unlock(rw, self);
+  } else
+    rval = FALSE;
+  release_rwlock(rw);
+#else
+  rval = callProlog(NULL, goal, PL_Q_PASS_EXCEPTION, NULL);
+#endif
+
+  return rval;
+}
+
+
+static
+PRED_IMPL("with_read_lock", 2, with_read_lock, PL_FA_TRANSPARENT)
+{ return with_rwlock(A1, A2, RW_READ);
+}
+
+
+static
+PRED_IMPL("with_write_lock", 2, with_write_lock, PL_FA_TRANSPARENT)
+{ return with_rwlock(A1, A2, RW_WRITE);
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+with_optimistic_read(+RWLock, :Goal) runs Goal  without locking if no
+writer is active. If a writer acquired the   lock  while Goal was running,
+the bindings (and possible exception) are discarded and Goal is executed
+again as with_read_lock/2. Goal must  thus   be  free of side effects.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static
+PRED_IMPL("with_optimistic_read", 2, with_optimistic_read, PL_FA_TRANSPARENT)
+{
+#ifdef O_PLMT
+  PRED_LD
+  pl_rwlock *rw;
+  size_t seq;
+
+  if ( !get_rwlock(A1, &rw, TRUE) )
+    return FALSE;
+
+  seq = rw->seq;
+  MemoryBarrier();
+  if ( !(seq&1) )
+  { fid_t fid;
+    term_t ex;
+    int rc;
+
+    if ( !(fid = PL_open_foreign_frame()) )
+    { release_rwlock(rw);
+      return FALSE;
+    }
+    rc = callProlog(NULL, A2, PL_Q_CATCH_EXCEPTION, &ex);
+    MemoryBarrier();
+    if ( rw->seq == seq )
+    { if ( !rc && ex )
+	PL_raise_exception(ex);
+      PL_close_foreign_frame(fid);
+      release_rwlock(rw);
+      return rc;
+    }
+    PL_discard_foreign_frame(fid);
+  }
+  release_rwlock(rw);
+#endif
+
+  return with_rwlock(A1, A2, RW_READ);
+}
+
+
 		 /*******************************
 		 *      PUBLISH PREDICATES	*
 		 *******************************/
@@ -766,5 +1486,12 @@ BeginPredDefs(mutex)
   PRED_DEF("mutex_unlock",	     1,	mutex_unlock,	       PL_FA_ISO)
   PRED_DEF("mutex_unlock_all",	     0,	mutex_unlock_all,      0)
   PRED_DEF("mutex_property",	     2,	mutex_property,	       NDET|PL_FA_ISO)
+  PRED_DEF("lock_statistics",	     1,	lock_statistics,       0)
+  PRED_DEF("rwlock_create",	     1,	rwlock_create1,	       0)
+  PRED_DEF("rwlock_create",	     2,	rwlock_create2,	       0)
+  PRED_DEF("rwlock_destroy",	     1,	rwlock_destroy,	       0)
 #endif
+  PRED_DEF("with_read_lock",	     2,	with_read_lock,	       PL_FA_TRANSPARENT)
+  PRED_DEF("with_write_lock",	     2,	with_write_lock,       PL_FA_TRANSPARENT)
+  PRED_DEF("with_optimistic_read",   2,	with_optimistic_read,  PL_FA_TRANSPARENT)
 EndPredDefs
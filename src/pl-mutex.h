@@ -139,6 +139,27 @@ extern int recursiveMutexUnlock(recursiveMutex *m);
 #endif
 #endif
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Lock profiling (flag lock_profile). If  the   flag  is  N > 0, every Nth
+acquisition of a lock is timed. The profile   is  only updated while the
+lock is held, so no additional synchronization is needed. Histograms use
+log2 buckets: bucket 0 is < 1us, bucket I holds [2^(I-1),2^I) us and the
+last bucket collects everything above.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define LOCK_HIST_SIZE 24		/* # log2(usec) histogram buckets */
+
+typedef struct lock_profile
+{ uint64_t	acquired;		/* # acquisitions while profiling */
+  uint64_t	sampled;		/* # timed acquisitions */
+  uint64_t	contended;		/* # timed that had to wait */
+  uint64_t	wait;			/* Total timed wait time (nsec) */
+  uint64_t	hold;			/* Total timed hold time (nsec) */
+  uint64_t	hold_start;		/* Start of timed hold (0: none) */
+  unsigned int	wait_hist[LOCK_HIST_SIZE]; /* Wait time histogram */
+  unsigned int	hold_hist[LOCK_HIST_SIZE]; /* Hold time histogram */
+} lock_profile;
+
 typedef struct counting_mutex
 { simpleMutex mutex;			/* mutex itself */
   const char  *name;			/* name of the mutex */
@@ -146,6 +167,7 @@ typedef struct counting_mutex
   unsigned int lock_count;		/* # times unlocked */
 #ifdef O_CONTENTION_STATISTICS
   unsigned int collisions;		/* # contentions */
+  lock_profile profile;			/* Timing (flag lock_profile) */
 #endif
   struct counting_mutex *next;		/* next of allocated chain */
   struct counting_mutex *prev;		/* prvious in allocated chain */
@@ -5380,7 +5380,9 @@ swi_statistics__LD(atom_t key, Number v, PL_local_data_t *ld)
   }
 #endif
   else if (key == ATOM_table_space_used)
-    v->value.i = LD->tabling.node_pool.size*sizeof(trie_node);
+    v->value.i = LD->tabling.node_pool.size;
+  else if (key == ATOM_table_space_evictions)
+    v->value.i = LD->tabling.lru.evictions;
   else if (key == ATOM_indexes_created)
     v->value.i = GD->statistics.indexes.created;
   else if (key == ATOM_indexes_destroyed)
@@ -1384,25 +1384,214 @@ init_stack(Stack s, char *name, size_t size, size_t spare, int gc)
 }
 
 
-static int
-allocStacks(void)
-{ GET_LD
-  size_t minglobal = 8*SIZEOF_VOIDP K;
+typedef struct initial_stacks
+{ size_t global;
+  size_t local;
+  size_t trail;
+  size_t argument;
+} initial_stacks;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Initial stack sizes. Small stacks are   used  for engines created with
+PL_THREAD_SMALL_STACKS. The global and   trail stacks are then below
+SMALLSTACK and thus not taken from  nextStackSizeAbove(). They grow on
+demand like normal stacks. The local stack   is not reduced as it needs
+LOCAL_MARGIN twice (spare and min_free) and would be expanded immediately.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+initial_stack_sizes(initial_stacks *is, int small)
+{ size_t minglobal = 8*SIZEOF_VOIDP K;
   size_t minlocal  = 4*SIZEOF_VOIDP K;
   size_t mintrail  = 4*SIZEOF_VOIDP K;
   size_t minarg    = 1*SIZEOF_VOIDP K;
 
-  size_t itrail  = nextStackSizeAbove(mintrail-1);
-  size_t iglobal = nextStackSizeAbove(minglobal-1);
-  size_t ilocal  = nextStackSizeAbove(minlocal-1);
+  if ( small )
+  { is->trail    = 1*SIZEOF_VOIDP K;
+    is->global   = 2*SIZEOF_VOIDP K;
+  } else
+  { is->trail    = nextStackSizeAbove(mintrail-1);
+    is->global   = nextStackSizeAbove(minglobal-1);
+  }
+  is->local    = nextStackSizeAbove(minlocal-1);
+  is->argument = minarg;
+}
+
+
+#ifdef O_PLMT
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+The stacks of terminated threads are  kept   in  GD->thread.cache  for
+reuse by new threads, up to the  Prolog   flag  thread_cache_size. Stacks
+that have grown are shrunk to their  initial   size  first, such that a
+cached set is identical to what  allocStacks()   creates.  The cache is
+linked through the (unused) combined global/local area. Cached stacks do
+not count for statistics(stack, X).  Stacks are only reused by a thread
+bound to the same NUMA node as the thread that released them.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct stack_set
+{ struct stack_set *next;		/* next in cache */
+  TrailEntry	    trail;		/* trail stack */
+  Word *	    argument;		/* argument stack */
+  int		    numa_node;		/* NUMA node of the owner (-1: none) */
+} stack_set;
+
+#define stack_size(mem) (((size_t*)(mem))[-1])
+
+static int
+resize_cached_stack(void **mem, size_t size)
+{ if ( stack_size(*mem) != size )
+  { void *nmem;
+
+    if ( !(nmem = stack_realloc(*mem, size)) )
+      return FALSE;
+    *mem = nmem;
+  }
+
+  return TRUE;
+}
+
+
+int
+cacheStacks(ARG1_LD)
+{ initial_stacks is;
+  void *g, *t, *a;
+  stack_set *set;
+
+  if ( !gBase || !tBase || !aBase ||
+       LD->thread.info->small_stacks ||
+       GD->thread.cache.stack_count >= GD->thread.cache.size )
+    return FALSE;
+
+  initial_stack_sizes(&is, FALSE);
+  g = gBase-1;
+  t = tBase;
+  a = aBase;
+  if ( !resize_cached_stack(&g, is.global+is.local) )
+    return FALSE;
+  gBase = (Word)g+1;
+  if ( !resize_cached_stack(&t, is.trail) )
+    return FALSE;
+  tBase = t;
+  if ( !resize_cached_stack(&a, is.argument) )
+    return FALSE;
+  aBase = a;
+
+  set = g;
+  set->trail     = t;
+  set->argument  = a;
+  set->numa_node = LD->thread.info->numa_node;
+
+  PL_LOCK(L_THREAD);
+  if ( GD->thread.cache.stack_count < GD->thread.cache.size )
+  { set->next = GD->thread.cache.stacks;
+    GD->thread.cache.stacks = set;
+    GD->thread.cache.stack_count++;
+    set = NULL;
+  }
+  PL_UNLOCK(L_THREAD);
+
+  if ( set )
+    return FALSE;
+
+  ATOMIC_SUB(&GD->statistics.stack_space,
+	     is.global+is.local+is.trail+is.argument);
+  gTop = NULL; gBase = NULL;
+  lTop = NULL; lBase = NULL;
+  tTop = NULL; tBase = NULL;
+  aTop = NULL; aBase = NULL;
+
+  return TRUE;
+}
+
+
+static stack_set *
+reuseStacks(const initial_stacks *is, int numa_node)
+{ stack_set *set = NULL;
+
+  if ( GD->thread.cache.stacks )
+  { stack_set **sp;
+
+    PL_LOCK(L_THREAD);
+    for(sp = &GD->thread.cache.stacks; (set=*sp); sp = &set->next)
+    { if ( set->numa_node == numa_node )
+      { *sp = set->next;
+	GD->thread.cache.stack_count--;
+	break;
+      }
+    }
+    PL_UNLOCK(L_THREAD);
+
+    if ( set )
+      ATOMIC_ADD(&GD->statistics.stack_space,
+		 is->global+is->local+is->trail+is->argument);
+  }
+
+  return set;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+trimStackCache() frees cached stacks  until   there  are  at most `size`
+left. Used if the flag thread_cache_size   is  reduced and from cleanup.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+void
+trimStackCache(int size)
+{ stack_set *set, *next;
+
+  PL_LOCK(L_THREAD);
+  for(set=NULL; GD->thread.cache.stack_count > size; set=next)
+  { next = GD->thread.cache.stacks;
+    GD->thread.cache.stacks = next->next;
+    GD->thread.cache.stack_count--;
+    next->next = set;
+  }
+  PL_UNLOCK(L_THREAD);
+
+  for(; set; set=next)
+  { next = set->next;
+    free((size_t*)set->argument-1);
+    free((size_t*)set->trail-1);
+    free((size_t*)set-1);
+  }
+}
+#endif /*O_PLMT*/
+
+
+static int
+allocStacks(void)
+{ GET_LD
+  initial_stacks is;
+  size_t iglobal, ilocal, itrail, minarg;
+#ifdef O_PLMT
+  int small = (LD->thread.info && LD->thread.info->small_stacks);
+  stack_set *set = NULL;
+#else
+  int small = FALSE;
+#endif
+
+  initial_stack_sizes(&is, small);
+  iglobal = is.global;
+  ilocal  = is.local;
+  itrail  = is.trail;
+  minarg  = is.argument;
 
   gBase = NULL;
   tBase = NULL;
   aBase = NULL;
 
-  gBase = (Word)       stack_malloc(iglobal + ilocal);
-  tBase = (TrailEntry) stack_malloc(itrail);
-  aBase = (Word *)     stack_malloc(minarg);
+#ifdef O_PLMT
+  if ( !small && (set = reuseStacks(&is, LD->thread.info->numa_node)) )
+  { tBase = set->trail;
+    aBase = set->argument;
+    gBase = (Word)set;
+  } else
+#endif
+  { gBase = (Word)       stack_malloc(iglobal + ilocal);
+    tBase = (TrailEntry) stack_malloc(itrail);
+    aBase = (Word *)     stack_malloc(minarg);
+  }
 
   if ( !gBase || !tBase || !aBase )
   { if ( gBase )
@@ -1637,6 +1826,7 @@ freePrologLocalData(PL_local_data_t *ld)
 #endif
 
   freeArithLocalData(ld);
+  freeRedirectStream(ld);
 #ifdef O_PLMT
   if ( ld->prolog_flag.table )
   { PL_LOCK(L_PLFLAG);
@@ -0,0 +1,434 @@
+/*  Part of SWI-Prolog
+
+    Author:        Jan Wielemaker
+    E-mail:        J.Wielemaker@vu.nl
+    WWW:           http://www.swi-prolog.org
+    Copyright (c)  2019, VU University Amsterdam
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+
+    1. Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright
+       notice, this list of conditions and the following disclaimer in
+       the documentation and/or other materials provided with the
+       distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+    LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+    ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "pl-incl.h"
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Shared maps are key->term hash maps that are  shared between threads. The
+map is a blob that is  reclaimed  by   atom  garbage  collection.  Keys are
+the same as for recorded/3 and flag/3: atoms, small integers or compound
+terms, where only the name and arity of a compound is used.
+
+The map is a lock-free Table (see  os/pl-table.c)   that maps the key to a
+record holding a copy of the value. Reading  copies the record to the stack
+without locking. This requires  us  to   know  when  a replaced or deleted
+record can be freed. We use a hazard pointer  for that: a reader publishes
+the record it is copying  in   its  PL_thread_info_t->access.record and
+re-validates that the record is still  in   the  map.  A writer frees the
+record it removed unless some thread  is   copying  it,  in which case the
+record is added to the `deferred` list of the map and freed by a later
+write.
+
+Atom keys are registered once for each  record  in the map. As the record
+is put into the map after registering the key and the key is unregistered
+after removing a record, the key count never drops below the number of
+records in the map.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct deferred_record
+{ struct deferred_record *next;		/* Next in list */
+  Record		  record;	/* Record that may be in use */
+} deferred_record;
+
+typedef struct shared_map
+{ atom_t		symbol;		/* <shared_map>(0x...) */
+  Table			table;		/* key --> Record */
+#ifdef O_PLMT
+  simpleMutex		mutex;		/* Protects deferred */
+#endif
+  deferred_record      *deferred;	/* Records to free later */
+} shared_map;
+
+typedef struct shared_map_ref
+{ shared_map *map;
+} shared_map_ref;
+
+#undef LD
+#define LD LOCAL_LD
+
+
+		 /*******************************
+		 *	      RECORDS		*
+		 *******************************/
+
+static void
+free_shared_map_symbol(void *name, void *value)
+{ word key = (word)name;
+
+  freeRecord(value);
+  if ( isAtom(key) )
+    PL_unregister_atom(key);
+}
+
+
+/* acquire_value() returns the record for key and registers it as being
+   accessed by this thread.  The access must be terminated using
+   release_value().
+*/
+
+static Record
+acquire_value(shared_map *map, word key ARG_LD)
+{
+#ifdef O_PLMT
+  PL_thread_info_t *info = LD->thread.info;
+  Record r, r2;
+
+  for(r = lookupHTable(map->table, (void*)key); r; r = r2)
+  { info->access.record = r;
+    MemoryBarrier();
+    if ( (r2=lookupHTable(map->table, (void*)key)) == r )
+      return r;
+  }
+
+  info->access.record = NULL;
+  return NULL;
+#else
+  return lookupHTable(map->table, (void*)key);
+#endif
+}
+
+#ifdef O_PLMT
+#define release_value() (LD->thread.info->access.record = NULL)
+#else
+#define release_value() (void)0
+#endif
+
+
+#ifdef O_PLMT
+static void
+free_deferred_records(shared_map *map)
+{ deferred_record **pp, *c;
+
+  for(pp = &map->deferred; (c=*pp); )
+  { if ( !pl_record_in_use(c->record) )
+    { *pp = c->next;
+      freeRecord(c->record);
+      freeHeap(c, sizeof(*c));
+    } else
+    { pp = &c->next;
+    }
+  }
+}
+#endif
+
+
+/* reclaim_value() is called after `old` was removed from the map
+*/
+
+static void
+reclaim_value(shared_map *map, Record old)
+{
+#ifdef O_PLMT
+  if ( !map->deferred && !pl_record_in_use(old) )
+  { freeRecord(old);
+  } else
+  { deferred_record *c = allocHeapOrHalt(sizeof(*c));
+
+    c->record = old;
+    simpleMutexLock(&map->mutex);
+    c->next = map->deferred;
+    map->deferred = c;
+    free_deferred_records(map);
+    simpleMutexUnlock(&map->mutex);
+  }
+#else
+  freeRecord(old);
+#endif
+}
+
+
+static int
+unify_value(term_t t, shared_map *map, word key ARG_LD)
+{ Record r;
+  term_t copy;
+  int rc;
+
+  if ( !(copy = PL_new_term_ref()) )
+    return FALSE;
+
+  if ( (r=acquire_value(map, key PASS_LD)) )
+  { rc = copyRecordToGlobal(copy, r, ALLOW_GC PASS_LD);
+    release_value();
+    if ( rc < 0 )
+      return raiseStackOverflow(rc);
+
+    return PL_unify(t, copy);
+  }
+
+  return FALSE;
+}
+
+
+		 /*******************************
+		 *	       BLOB		*
+		 *******************************/
+
+static int
+write_shared_map_ref(IOSTREAM *s, atom_t aref, int flags)
+{ shared_map_ref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)flags;
+
+  Sfprintf(s, "<shared_map>(%p)", ref->map);
+  return TRUE;
+}
+
+
+static int
+release_shared_map_ref(atom_t aref)
+{ shared_map_ref *ref = PL_blob_data(aref, NULL, NULL);
+  shared_map *map = NULL;
+
+  if ( (map=ref->map) )
+  { deferred_record *c, *next;
+
+    destroyHTable(map->table);
+    for(c=map->deferred; c; c=next)
+    { next = c->next;
+      freeRecord(c->record);
+      freeHeap(c, sizeof(*c));
+    }
+#ifdef O_PLMT
+    simpleMutexDelete(&map->mutex);
+#endif
+    freeHeap(map, sizeof(*map));
+  }
+
+  return TRUE;
+}
+
+
+static int
+save_shared_map_ref(atom_t aref, IOSTREAM *fd)
+{ shared_map_ref *ref = PL_blob_data(aref, NULL, NULL);
+  (void)fd;
+
+  return PL_warning("Cannot save reference to <shared_map>(%p)", ref->map);
+}
+
+
+static atom_t
+load_shared_map_ref(IOSTREAM *fd)
+{ (void)fd;
+
+  return PL_new_atom("<saved-shared_map-ref>");
+}
+
+
+static PL_blob_t shared_map_blob =
+{ PL_BLOB_MAGIC,
+  PL_BLOB_UNIQUE,
+  "shared_map",
+  release_shared_map_ref,
+  NULL,
+  write_shared_map_ref,
+  NULL,
+  save_shared_map_ref,
+  load_shared_map_ref
+};
+
+
+static int
+get_shared_map(term_t t, shared_map **mapp)
+{ void *data;
+  PL_blob_t *type;
+
+  if ( PL_get_blob(t, &data, NULL, &type) && type == &shared_map_blob )
+  { shared_map_ref *ref = data;
+
+    *mapp = ref->map;
+    return TRUE;
+  }
+
+  return PL_type_error("shared_map", t);
+}
+
+
+		 /*******************************
+		 *	   PREDICATES		*
+		 *******************************/
+
+static
+PRED_IMPL("shared_map_create", 1, shared_map_create, 0)
+{ PRED_LD
+  shared_map *map;
+  shared_map_ref ref;
+  int new;
+
+  if ( !PL_is_variable(A1) )
+    return PL_error(NULL, 0, NULL, ERR_UNINSTANTIATION, 1, A1);
+
+  map = allocHeapOrHalt(sizeof(*map));
+  memset(map, 0, sizeof(*map));
+  map->table = newHTable(16);
+  map->table->free_symbol = free_shared_map_symbol;
+#ifdef O_PLMT
+  simpleMutexInit(&map->mutex);
+#endif
+  ref.map = map;
+  map->symbol = lookupBlob((void*)&ref, sizeof(ref), &shared_map_blob, &new);
+
+  return PL_unify_atom(A1, map->symbol);
+}
+
+
+static
+PRED_IMPL("shared_map_put", 3, shared_map_put, 0)
+{ PRED_LD
+  shared_map *map = NULL;
+  word key;
+  Record r, old;
+
+  if ( !get_shared_map(A1, &map) ||
+       !getKeyEx(A2, &key PASS_LD) )
+    return FALSE;
+
+  if ( !(r = compileTermToHeap(A3, 0)) )
+    return PL_no_memory();
+  if ( isAtom(key) )
+    PL_register_atom(key);
+  if ( (old = replaceHTable(map->table, (void*)key, r)) )
+  { if ( isAtom(key) )
+      PL_unregister_atom(key);
+    reclaim_value(map, old);
+  }
+
+  return TRUE;
+}
+
+
+static
+PRED_IMPL("shared_map_get", 3, shared_map_get, PL_FA_NONDETERMINISTIC)
+{ PRED_LD
+  shared_map *map = NULL;
+  TableEnum e;
+  word key;
+  void *k;
+  fid_t fid;
+
+  switch( CTX_CNTRL )
+  { case FRG_FIRST_CALL:
+    { if ( !get_shared_map(A1, &map) )
+	return FALSE;
+
+      if ( PL_is_variable(A2) )
+      { e = newTableEnum(map->table);
+	break;
+      }
+      if ( !getKeyEx(A2, &key PASS_LD) )
+	return FALSE;
+
+      return unify_value(A3, map, key PASS_LD);
+    }
+    case FRG_REDO:
+      e = CTX_PTR;
+      if ( !get_shared_map(A1, &map) )
+	return FALSE;
+      break;
+    case FRG_CUTTED:
+      e = CTX_PTR;
+      freeTableEnum(e);
+      return TRUE;
+    default:
+      assert(0);
+      return FALSE;
+  }
+
+  if ( !(fid = PL_open_foreign_frame()) )
+  { freeTableEnum(e);
+    return FALSE;
+  }
+
+  while( advanceTableEnum(e, &k, NULL) )
+  { key = (word)k;
+
+    if ( unifyKey(A2, key) &&
+	 unify_value(A3, map, key PASS_LD) )
+    { PL_close_foreign_frame(fid);
+      ForeignRedoPtr(e);
+    }
+    if ( PL_exception(0) )
+      break;
+    PL_rewind_foreign_frame(fid);
+  }
+
+  PL_close_foreign_frame(fid);
+  freeTableEnum(e);
+  return FALSE;
+}
+
+
+static
+PRED_IMPL("shared_map_delete", 2, shared_map_delete, 0)
+{ PRED_LD
+  shared_map *map = NULL;
+  word key;
+  Record old;
+
+  if ( !get_shared_map(A1, &map) ||
+       !getKeyEx(A2, &key PASS_LD) )
+    return FALSE;
+
+  if ( (old = deleteHTable(map->table, (void*)key)) )
+  { if ( isAtom(key) )
+      PL_unregister_atom(key);
+    reclaim_value(map, old);
+  }
+
+  return TRUE;
+}
+
+
+static
+PRED_IMPL("shared_map_size", 2, shared_map_size, 0)
+{ PRED_LD
+  shared_map *map = NULL;
+
+  if ( !get_shared_map(A1, &map) )
+    return FALSE;
+
+  return PL_unify_int64(A2, map->table->size);
+}
+
+
+		 /*******************************
+		 *      PUBLISH PREDICATES	*
+		 *******************************/
+
+BeginPredDefs(shmap)
+  PRED_DEF("shared_map_create", 1, shared_map_create, 0)
+  PRED_DEF("shared_map_put",    3, shared_map_put,    0)
+  PRED_DEF("shared_map_get",    3, shared_map_get,    PL_FA_NONDETERMINISTIC)
+  PRED_DEF("shared_map_delete", 2, shared_map_delete, 0)
+  PRED_DEF("shared_map_size",   2, shared_map_size,   0)
+EndPredDefs
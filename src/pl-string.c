@@ -370,6 +370,81 @@ backSkipPadding(const char *in, size_t len, PL_chars_t *pad)
 }
 
 
+/* Add a run of at most `max` ASCII characters that are available in the
+   buffer of `s` to `b`.  See Sget_ascii().  Returns the number of
+   characters added.
+*/
+
+static size_t
+add_ascii_run(IOSTREAM *s, Buffer b, size_t max,
+	      const char *stops, size_t nstops)
+{ size_t avail = s->limitp - s->bufp;
+  size_t n;
+
+  if ( avail == 0 )
+    return 0;
+  if ( avail > max )
+    avail = max;
+  if ( !growBuffer(b, avail) )
+    return 0;				/* use the slow path */
+
+  n = Sget_ascii(s, b->top, avail, stops, nstops);
+  b->top += n;
+
+  return n;
+}
+
+
+/* Collect the ASCII characters of `sep` in `stops` for add_ascii_run()
+   and return their number.  This includes NUL.
+*/
+
+static size_t
+ascii_stops(PL_chars_t *sep, char stops[128])
+{ size_t i, ns = 0;
+
+  for(i=0; i<sep->length; i++)
+  { int c = text_get_char(sep, i);
+
+    if ( c >= 0 && c < 128 && !memchr(stops, c, ns) )
+      stops[ns++] = (char)c;
+  }
+
+  return ns;
+}
+
+
+/* Read a record as UTF-8 into `b`, skipping leading and removing
+   trailing padding.  Returns the separator that ended the record, EOF,
+   or -2 on an I/O error.
+*/
+
+static int
+read_record(IOSTREAM *s, PL_chars_t *sep, PL_chars_t *pad,
+	    const char *stops, size_t nstops, Buffer b)
+{ int chr;
+
+  do
+  { chr = Sgetcode(s);
+  } while(chr != EOF && text_chr(pad, chr) != (size_t)-1);
+
+  for(;;)
+  { if ( chr == EOF && Sferror(s) )
+      return -2;
+    if ( chr == EOF || text_chr(sep, chr) != (size_t)-1 )
+      break;
+    addUTF8Buffer(b, chr);
+    add_ascii_run(s, b, (size_t)-1, stops, nstops);
+    chr = Sgetcode(s);
+  }
+
+  b->top = backSkipPadding(baseBuffer(b, char),
+			   entriesBuffer(b, char),
+			   pad);
+  return chr;
+}
+
+
 /** read_string(+Stream, +Delimiters, +Padding, -Delimiter, -String)
 */
 
@@ -390,23 +465,13 @@ PRED_IMPL("read_string", 5, read_string, 0)
        PL_get_text(A2, &sep, flags) &&
        PL_get_text(A3, &pad, flags) )
   { int chr;
+    char stops[128];
+    size_t nstops = ascii_stops(&sep, stops);
 
-    do
-    { chr = Sgetcode(s);
-    } while(chr != EOF && text_chr(&pad, chr) != (size_t)-1);
+    if ( (chr = read_record(s, &sep, &pad, stops, nstops,
+			    (Buffer)&tmpbuf)) == -2 )
+      goto out;
 
-    for(;;)
-    { if ( chr == EOF && Sferror(s) )
-	goto out;
-      if ( chr == EOF || text_chr(&sep, chr) != (size_t)-1 )
-	break;
-      addUTF8Buffer((Buffer)&tmpbuf, chr);
-      chr = Sgetcode(s);
-    }
-
-    tmpbuf.top = backSkipPadding(baseBuffer(&tmpbuf,char),
-				 entriesBuffer(&tmpbuf, char),
-				 &pad);
     rc = ( PL_unify_chars(A5, PL_STRING|REP_UTF8,
 			  entriesBuffer(&tmpbuf, char),
 			  baseBuffer(&tmpbuf, char)) &&
@@ -429,6 +494,78 @@ out:
 }
 
 
+/** '$read_strings'(+Stream, +Max, +Delimiters, +Padding, -Strings)
+
+Read at most Max records as  read_string/5   does  and  unify Strings
+with the list of records. Reading stops  early   at  the  end of the
+input. A last record that is empty and  ended by the end of the input
+is not included, which implies Strings is [] iff the input is at its
+end, provided Max > 0. Used by read_lines_to_strings/3,4 from
+library(readutil).
+*/
+
+static
+PRED_IMPL("$read_strings", 5, read_strings, 0)
+{ PRED_LD
+  IOSTREAM *s = NULL;
+  PL_chars_t sep, pad;
+  int flags = CVT_ATOM|CVT_STRING|CVT_LIST|CVT_EXCEPTION;
+  int rc = FALSE;
+  size_t max;
+  tmp_buffer tmpbuf;
+
+  sep.storage = PL_CHARS_VIRGIN;
+  pad.storage = PL_CHARS_VIRGIN;
+  initBuffer(&tmpbuf);
+
+  if ( PL_get_size_ex(A2, &max) &&
+       getTextInputStream(A1, &s) &&
+       PL_get_text(A3, &sep, flags) &&
+       PL_get_text(A4, &pad, flags) )
+  { term_t tail = PL_copy_term_ref(A5);
+    term_t head = PL_new_term_ref();
+    char stops[128];
+    size_t nstops = ascii_stops(&sep, stops);
+    size_t n;
+
+    for(n=0; n<max; n++)
+    { int chr;
+
+      emptyBuffer(&tmpbuf);
+      if ( (chr = read_record(s, &sep, &pad, stops, nstops,
+			      (Buffer)&tmpbuf)) == -2 )
+	goto out;
+      if ( chr == EOF && entriesBuffer(&tmpbuf, char) == 0 )
+	break;
+      if ( !PL_unify_list(tail, head, tail) ||
+	   !PL_unify_chars(head, PL_STRING|REP_UTF8,
+			   entriesBuffer(&tmpbuf, char),
+			   baseBuffer(&tmpbuf, char)) )
+	goto out;
+      if ( chr == EOF )
+	break;
+      if ( (n+1) % 256 == 0 && PL_handle_signals() < 0 )
+	goto out;
+    }
+
+    rc = PL_unify_nil(tail);
+  }
+
+out:
+  discardBuffer(&tmpbuf);
+  if ( s )
+  { if ( rc )
+      rc = PL_release_stream(s);
+    else
+      PL_release_stream(s);
+  }
+  PL_free_text(&sep);
+  PL_free_text(&pad);
+
+  return rc;
+}
+
+
 /** read_string(+Stream, ?Length, -String)
 */
 
@@ -456,6 +593,7 @@ PRED_IMPL("read_string", 3, read_string, 0)
 	break;
       }
       addUTF8Buffer((Buffer)&tmpbuf, chr);
+      count += add_ascii_run(s, (Buffer)&tmpbuf, len-count-1, NULL, 0);
     }
 
     rc = ( PL_unify_chars(A3, PL_STRING|REP_UTF8,
@@ -526,5 +664,6 @@ BeginPredDefs(strings)
   PRED_DEF("get_string_code", 3, get_string_code, 0)
   PRED_DEF("read_string",     5, read_string,     0)
   PRED_DEF("read_string",     3, read_string,     0)
+  PRED_DEF("$read_strings",   5, read_strings,    0)
   PRED_DEF("open_string",     2, open_string,     0)
 EndPredDefs
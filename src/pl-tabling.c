@@ -372,6 +372,9 @@ free_worklist_set(worklist_set *wls, int freewl)
 		 *******************************/
 
 static void release_variant_table_node(trie *trie, trie_node *node);
+static void lru_unlink(trie *t ARG_LD);
+static void reset_table_lru(PL_local_data_t *ld);
+static Definition variant_predicate(Word v ARG_LD);
 
 static trie *
 thread_variant_table(ARG1_LD)
@@ -393,6 +396,10 @@ release_variant_table_node(trie *variant_table, trie_node *node)
   { trie *vtrie = symbol_trie(node->value);
 
     assert(vtrie->data.variant == node);
+    if ( vtrie->data.space )
+    { GET_LD
+      lru_unlink(vtrie PASS_LD);
+    }
     vtrie->data.variant = NULL;
     vtrie->data.worklist = NULL;
     trie_empty(vtrie);
@@ -402,7 +409,9 @@ release_variant_table_node(trie *variant_table, trie_node *node)
 
 static void
 clear_variant_table(PL_local_data_t *ld)
-{ if ( ld->tabling.variant_table )
+{ reset_table_lru(ld);
+
+  if ( ld->tabling.variant_table )
   { trie_empty(ld->tabling.variant_table);
     PL_unregister_atom(ld->tabling.variant_table->symbol);
     ld->tabling.variant_table = NULL;
@@ -424,6 +433,7 @@ get_variant_table(term_t t, int create ARG_LD)
     { trie *vt = trie_create();
       node->value = trie_symbol(vt);
       vt->data.variant = node;
+      vt->data.predicate = variant_predicate(v PASS_LD);
       vt->alloc_pool = &LD->tabling.node_pool;
       return vt;
     } else
@@ -435,6 +445,259 @@ get_variant_table(term_t t, int create ARG_LD)
 }
 
 
+		 /*******************************
+		 *	     TABLE SPACE	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Completed tables are kept in a  per-thread   LRU  list.  A table enters
+the list at the head when it is completed and is moved to the head each
+time a call reuses it. The size of  a table is computed by stat_trie()
+when it is completed and stored in `data.space`, which is non-zero iff
+the table is in the list.
+
+There are two budgets:
+
+  - The `table_space` flag limits the answer trie nodes of the thread.
+    If adding a node would exceed it, new_trie_node() calls
+    tbl_reclaim_space(), which evicts completed tables from the tail.
+  - set_table_space_limit/2 limits the bytes of completed tables for
+    a single predicate.  This is verified after completing an SCC.
+
+Tables that are being consumed are never evicted: trie_gen/3 holds a
+reference on the answer trie and we skip referenced tables.  Evicting a
+table removes it from the variant table, so the next call recomputes it.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static Definition
+variant_predicate(Word v ARG_LD)
+{ Module m = NULL;
+  functor_t f;
+  Procedure proc;
+
+  if ( !(v = stripModule(v, &m, SM_NOCREATE PASS_LD)) )
+    return NULL;
+
+  if ( isTerm(*v) )
+    f = functorTerm(*v);
+  else if ( isTextAtom(*v) )
+    f = lookupFunctorDef(*v, 0);
+  else
+    return NULL;
+
+  if ( (proc = isCurrentProcedure(f, m)) )
+    return proc->definition;
+
+  return NULL;
+}
+
+
+static size_t
+predicate_space_limit(Definition def ARG_LD)
+{ Table limits = GD->tabling.space_limits;
+
+  if ( def && limits )
+    return (size_t)lookupHTable(limits, def);
+
+  return 0;
+}
+
+
+static size_t
+predicate_space(Definition def ARG_LD)
+{ Table used = LD->tabling.lru.predicates;
+
+  if ( def && used )
+    return (size_t)lookupHTable(used, def);
+
+  return 0;
+}
+
+
+static void
+update_predicate_space(Definition def, size_t bytes, int add ARG_LD)
+{ size_t used;
+
+  if ( !def )
+    return;
+  if ( !LD->tabling.lru.predicates )
+    LD->tabling.lru.predicates = newHTable(4);
+
+  used = predicate_space(def PASS_LD);
+  if ( add )
+    used += bytes;
+  else
+    used = (used > bytes ? used - bytes : 0);
+
+  if ( used )
+    updateHTable(LD->tabling.lru.predicates, def, (void*)used);
+  else
+    deleteHTable(LD->tabling.lru.predicates, def);
+}
+
+
+static void
+lru_link(trie *t ARG_LD)
+{ trie_stats stats;
+
+  stat_trie(t, &stats);
+  t->data.space    = stats.bytes;
+  t->data.lru_prev = NULL;
+  t->data.lru_next = LD->tabling.lru.head;
+  if ( LD->tabling.lru.head )
+    LD->tabling.lru.head->data.lru_prev = t;
+  else
+    LD->tabling.lru.tail = t;
+  LD->tabling.lru.head = t;
+
+  LD->tabling.lru.count++;
+  LD->tabling.lru.bytes += t->data.space;
+  update_predicate_space(t->data.predicate, t->data.space, TRUE PASS_LD);
+}
+
+
+static void
+lru_unlink(trie *t ARG_LD)
+{ if ( t->data.lru_prev )
+    t->data.lru_prev->data.lru_next = t->data.lru_next;
+  else
+    LD->tabling.lru.head = t->data.lru_next;
+  if ( t->data.lru_next )
+    t->data.lru_next->data.lru_prev = t->data.lru_prev;
+  else
+    LD->tabling.lru.tail = t->data.lru_prev;
+
+  LD->tabling.lru.count--;
+  LD->tabling.lru.bytes -= t->data.space;
+  update_predicate_space(t->data.predicate, t->data.space, FALSE PASS_LD);
+
+  t->data.lru_prev = t->data.lru_next = NULL;
+  t->data.space = 0;
+}
+
+
+static void
+lru_touch(trie *t ARG_LD)
+{ if ( LD->tabling.lru.head != t )
+  { if ( t->data.lru_prev )
+      t->data.lru_prev->data.lru_next = t->data.lru_next;
+    if ( t->data.lru_next )
+      t->data.lru_next->data.lru_prev = t->data.lru_prev;
+    else
+      LD->tabling.lru.tail = t->data.lru_prev;
+
+    t->data.lru_prev = NULL;
+    t->data.lru_next = LD->tabling.lru.head;
+    LD->tabling.lru.head->data.lru_prev = t;
+    LD->tabling.lru.head = t;
+  }
+}
+
+
+/* reset_table_lru() is called before destroying the variant table.  As
+   this may be called for another thread, we do not touch the tables
+   in the list through LD.
+*/
+
+static void
+reset_table_lru(PL_local_data_t *ld)
+{ trie *t, *next;
+
+  for(t=ld->tabling.lru.head; t; t=next)
+  { next = t->data.lru_next;
+    t->data.lru_prev = t->data.lru_next = NULL;
+    t->data.space = 0;
+  }
+  ld->tabling.lru.head  = ld->tabling.lru.tail = NULL;
+  ld->tabling.lru.count = 0;
+  ld->tabling.lru.bytes = 0;
+  if ( ld->tabling.lru.predicates )
+  { destroyHTable(ld->tabling.lru.predicates);
+    ld->tabling.lru.predicates = NULL;
+  }
+}
+
+
+static int
+evictable_table(trie *t)
+{ return !t->references && t->data.variant;
+}
+
+
+static void
+evict_table(trie *t ARG_LD)
+{ DEBUG(MSG_TABLING_EVICT,
+	Sdprintf("Evicting table %p (%zu bytes)\n", t, t->data.space));
+
+  LD->tabling.lru.evictions++;
+  prune_node(LD->tabling.variant_table, t->data.variant);
+}
+
+
+/* tbl_reclaim_space() is called by new_trie_node() if adding a node
+   to `into` would exceed the node pool limit.  It evicts completed
+   tables from the tail of the LRU list and returns TRUE if there is
+   enough space after eviction.
+*/
+
+int
+tbl_reclaim_space(trie *into, size_t needed)
+{ GET_LD
+  trie_allocation_pool *pool = into->alloc_pool;
+  trie *t, *prev;
+
+  if ( pool != &LD->tabling.node_pool )
+    return FALSE;
+
+  for(t=LD->tabling.lru.tail;
+      t && pool->size+needed > pool->limit;
+      t=prev)
+  { prev = t->data.lru_prev;
+
+    if ( t != into && evictable_table(t) )
+      evict_table(t PASS_LD);
+  }
+
+  return pool->size+needed <= pool->limit;
+}
+
+
+/* enforce_predicate_limits() is called after the tables from wls have
+   been added to the head of the LRU list.  It evicts older tables of
+   the predicates of these tables that exceed their budget.  The new
+   tables are not considered as they are about to be consumed.
+*/
+
+static void
+enforce_predicate_limits(worklist **wls, size_t ntables ARG_LD)
+{ size_t i;
+
+  if ( !GD->tabling.space_limits || ntables == 0 )
+    return;
+
+  for(i=0; i<ntables; i++)
+  { Definition def = wls[i]->table->data.predicate;
+    size_t limit;
+
+    if ( (limit=predicate_space_limit(def PASS_LD)) &&
+	 predicate_space(def PASS_LD) > limit )
+    { trie *stop = wls[0]->table;
+      trie *t, *prev;
+
+      for(t=LD->tabling.lru.tail;
+	  t && t != stop && predicate_space(def PASS_LD) > limit;
+	  t=prev)
+      { prev = t->data.lru_prev;
+
+	if ( t->data.predicate == def && evictable_table(t) )
+	  evict_table(t PASS_LD);
+      }
+    }
+  }
+}
+
+
+
 void
 clearThreadTablingData(PL_local_data_t *ld)
 { reset_global_worklist(ld->tabling.component);
@@ -558,6 +821,11 @@ new_worklist(trie *trie)
   wl->table = trie;
   trie->data.worklist = wl;
 
+  { GET_LD
+    if ( truePrologFlag(PLFLAG_TABLE_STATISTICS) )
+      trie->data.stats.started = WallTime();
+  }
+
   return wl;
 }
 
@@ -696,7 +964,10 @@ wkl_add_answer(worklist *wl, trie_node *node ARG_LD)
 
 static int
 wkl_add_suspension(worklist *wl, term_t suspension ARG_LD)
-{ potentially_add_to_global_worklist(wl PASS_LD);
+{ if ( truePrologFlag(PLFLAG_TABLE_STATISTICS) )
+    wl->table->data.stats.suspensions++;
+
+  potentially_add_to_global_worklist(wl PASS_LD);
   if ( wl->tail && wl->tail->type == CLUSTER_SUSPENSIONS )
   { if ( !add_to_suspension_cluster(wl->tail, suspension PASS_LD) )
       return FALSE;
@@ -893,6 +1164,66 @@ PRED_IMPL("$tbl_destroy_table", 1, tbl_destroy_table, 0)
 }
 
 
+/** '$tbl_set_space_limit'(:PI, +Limit) is det.
+ *
+ * Set the table space budget for the completed tables of PI.  Limit is
+ * a size in bytes or `infinite` to remove the budget.
+ */
+
+static
+PRED_IMPL("$tbl_set_space_limit", 2, tbl_set_space_limit, 0)
+{ PRED_LD
+  Procedure proc;
+  atom_t a;
+  size_t limit;
+
+  if ( !get_procedure(A1, &proc, 0, GP_NAMEARITY|GP_CREATE) )
+    return FALSE;
+
+  if ( PL_get_atom(A2, &a) && a == ATOM_infinite )
+  { if ( GD->tabling.space_limits )
+      deleteHTable(GD->tabling.space_limits, proc->definition);
+    return TRUE;
+  }
+  if ( !PL_get_size_ex(A2, &limit) )
+    return FALSE;
+  if ( limit == 0 )
+    return PL_domain_error("table_space_limit", A2);
+
+  if ( !GD->tabling.space_limits )
+  { Table t = newHTable(4);
+
+    if ( !COMPARE_AND_SWAP(&GD->tabling.space_limits, NULL, t) )
+      destroyHTable(t);
+  }
+  updateHTable(GD->tabling.space_limits, proc->definition, (void*)limit);
+
+  return TRUE;
+}
+
+
+/** '$tbl_space_limit'(:PI, -Limit, -Used) is semidet.
+ *
+ * Limit is the table space budget for PI and Used the number of bytes
+ * in completed tables of PI for the calling thread.  Fails if PI has no
+ * budget.
+ */
+
+static
+PRED_IMPL("$tbl_space_limit", 3, tbl_space_limit, 0)
+{ PRED_LD
+  Procedure proc;
+  size_t limit;
+
+  if ( get_procedure(A1, &proc, 0, GP_NAMEARITY|GP_FIND) &&
+       (limit = predicate_space_limit(proc->definition PASS_LD)) )
+    return ( PL_unify_int64(A2, limit) &&
+	     PL_unify_int64(A3, predicate_space(proc->definition PASS_LD)) );
+
+  return FALSE;
+}
+
+
 /** '$tbl_pop_worklist'(+SCC, -Worklist) is semidet.
  *
  * Pop next worklist from the component.
@@ -949,6 +1280,202 @@ PRED_IMPL("$tbl_wkl_add_answer", 2, tbl_wkl_add_answer, 0)
   return FALSE;
 }
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Mode directed tabling combines a new answer  for the moded arguments with
+the aggregated value so far. The  modes   of  the  table are fetched once
+from '$tabling':update_modes/2 and cached in `trie->data.update`.  If all
+modes are one of first, last, min, max,  sum or count, the update is done
+here. Otherwise, or if the values are not suitable (e.g., sum/3 on a
+non-number), we call '$tabling':update/4.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+update_mode(atom_t name)
+{ if ( name == ATOM_first ) return TBL_UPDATE_FIRST;
+  if ( name == ATOM_last )  return TBL_UPDATE_LAST;
+  if ( name == ATOM_min )   return TBL_UPDATE_MIN;
+  if ( name == ATOM_max )   return TBL_UPDATE_MAX;
+  if ( name == ATOM_sum )   return TBL_UPDATE_SUM;
+  if ( name == ATOM_count ) return TBL_UPDATE_COUNT;
+
+  return TBL_UPDATE_PROLOG;
+}
+
+
+static int
+table_update_modes(trie *table, term_t wrapper ARG_LD)
+{ static predicate_t PRED_update_modes2 = 0;
+  fid_t fid;
+  term_t av;
+  int count = 0;
+  int native = TRUE;
+
+  if ( table->data.update.count )
+    return TRUE;
+
+  if ( !PRED_update_modes2 )
+    PRED_update_modes2 = PL_predicate("update_modes", 2, "$tabling");
+
+  if ( !(fid = PL_open_foreign_frame()) )
+    return FALSE;
+
+  if ( (av=PL_new_term_refs(2)) &&
+       PL_put_term(av+0, wrapper) &&
+       PL_call_predicate(NULL, PL_Q_PASS_EXCEPTION, PRED_update_modes2, av) )
+  { term_t tail = PL_copy_term_ref(av+1);
+    term_t head = PL_new_term_ref();
+    atom_t name;
+
+    while( PL_get_list(tail, head, tail) )
+    { int mode = PL_get_atom(head, &name) ? update_mode(name)
+					    : TBL_UPDATE_PROLOG;
+
+      if ( mode == TBL_UPDATE_PROLOG )
+	native = FALSE;
+      if ( count < TBL_MAX_NATIVE_MODES )
+	table->data.update.mode[count] = mode;
+      count++;
+    }
+  } else if ( PL_exception(0) )
+  { PL_close_foreign_frame(fid);
+    return FALSE;
+  }
+  PL_close_foreign_frame(fid);
+
+  if ( count == 0 || count > TBL_MAX_NATIVE_MODES )
+  { count = 1;
+    table->data.update.mode[0] = TBL_UPDATE_PROLOG;
+    native = FALSE;
+  }
+  table->data.update.native = native;
+  table->data.update.count  = count;
+
+  return TRUE;
+}
+
+
+/* first_moded_value() puts the value for the first answer in `r`.  This
+   is the answer itself, except that arguments with mode `count` start
+   at 1.
+*/
+
+static int
+first_moded_value(trie *table, term_t answer, term_t r ARG_LD)
+{ int i, count = table->data.update.count;
+  int has_count = FALSE;
+
+  for(i=0; i<count; i++)
+  { if ( table->data.update.mode[i] == TBL_UPDATE_COUNT )
+      has_count = TRUE;
+  }
+
+  if ( !has_count )
+    return PL_put_term(r, answer);
+  if ( count == 1 )
+    return PL_put_integer(r, 1);
+  else
+  { term_t av = PL_new_term_refs(count);
+    functor_t f;
+
+    if ( !av || !PL_get_functor(answer, &f) || arityFunctor(f) != count )
+      return PL_type_error("moded_answer", answer);
+
+    for(i=0; i<count; i++)
+    { if ( table->data.update.mode[i] == TBL_UPDATE_COUNT )
+      { if ( !PL_put_integer(av+i, 1) )
+	  return FALSE;
+      } else
+      { _PL_get_arg(i+1, answer, av+i);
+      }
+    }
+
+    return PL_cons_functor_v(r, f, av);
+  }
+}
+
+
+/* update_moded_value() combines the aggregated value `old` with the
+   new answer `new` according to `mode`.  Returns TRUE if `r` holds the
+   new aggregated value, FALSE if the values are not suited for native
+   aggregation and -1 on an error.
+*/
+
+static int
+update_moded_value(int mode, term_t old, term_t new, term_t r ARG_LD)
+{ switch(mode)
+  { case TBL_UPDATE_FIRST:
+      return PL_put_term(r, old) ? TRUE : -1;
+    case TBL_UPDATE_LAST:
+      return PL_put_term(r, new) ? TRUE : -1;
+    case TBL_UPDATE_MIN:
+      return PL_put_term(r, PL_compare(new, old) < 0 ? new : old) ? TRUE : -1;
+    case TBL_UPDATE_MAX:
+      return PL_put_term(r, PL_compare(new, old) > 0 ? new : old) ? TRUE : -1;
+    case TBL_UPDATE_SUM:
+    case TBL_UPDATE_COUNT:
+    { number n1, n2, sum;
+      int rc;
+
+      if ( !PL_get_number(old, &n1) )
+	return FALSE;
+      if ( mode == TBL_UPDATE_COUNT )
+      { n2.type = V_INTEGER;
+	n2.value.i = 1;
+      } else if ( !PL_get_number(new, &n2) )
+      { return FALSE;
+      }
+
+      rc = ( pl_ar_add(&n1, &n2, &sum) &&
+	     PL_put_number(r, &sum) ) ? TRUE : -1;
+      clearNumber(&sum);
+
+      return rc;
+    }
+    default:
+      return FALSE;
+  }
+}
+
+
+/* native_moded_update() computes the new aggregated value in `r`.
+   Returns TRUE on success, FALSE if Prolog must be used and -1 on an
+   error.
+*/
+
+static int
+native_moded_update(trie *table, term_t old, term_t new, term_t r ARG_LD)
+{ int count = table->data.update.count;
+
+  if ( count == 1 )
+  { return update_moded_value(table->data.update.mode[0], old, new, r
+			      PASS_LD);
+  } else
+  { term_t av = PL_new_term_refs(count*3);
+    functor_t f;
+    int i;
+
+    if ( !av )
+      return -1;
+    if ( !PL_get_functor(old, &f) || arityFunctor(f) != count ||
+	 !PL_is_functor(new, f) )
+      return FALSE;
+
+    for(i=0; i<count; i++)
+    { int rc;
+
+      _PL_get_arg(i+1, old, av+count+i);
+      _PL_get_arg(i+1, new, av+2*count+i);
+      if ( (rc=update_moded_value(table->data.update.mode[i],
+				  av+count+i, av+2*count+i, av+i
+				  PASS_LD)) != TRUE )
+	return rc;
+    }
+
+    return PL_cons_functor_v(r, f, av) ? TRUE : -1;
+  }
+}
+
+
 /** '$tbl_wkl_mode_add_answer'(+Worklist, +TermNoModes, +Args, +Term) is semidet.
  *
  * Add an answer Args for moded arguments to the worklist's trie and the
@@ -980,36 +1507,57 @@ PRED_IMPL("$tbl_wkl_mode_add_answer", 4, tbl_wkl_mode_add_answer, 0)
 	    Sdprintf(": ");
 	  });
 
+    if ( !table_update_modes(wl->table, A4 PASS_LD) )
+      return FALSE;
+
     if ( (rc=trie_lookup(wl->table, &node, kp, TRUE PASS_LD)) == TRUE )
     { if ( node->value )
       { static predicate_t PRED_update4 = 0;
 	term_t av;
 
-	if ( !PRED_update4 )
-	  PRED_update4 = PL_predicate("update", 4, "$tabling");
-
-	if ( !((av=PL_new_term_refs(4)) &&
-	       PL_put_term(av+0, A4) &&
-	       tbl_put_trie_value(av+1, node PASS_LD) &&
-	       PL_put_term(av+2, A3) &&
-	       PL_call_predicate(NULL, PL_Q_PASS_EXCEPTION, PRED_update4, av) &&
-	       set_trie_value(node, av+3 PASS_LD)) )
-	{ DEBUG(MSG_TABLING_MODED, Sdprintf("No change!\n"));
+	if ( !(av=PL_new_term_refs(4)) ||
+	     !tbl_put_trie_value(av+1, node PASS_LD) )
 	  return FALSE;
+
+	if ( wl->table->data.update.native &&
+	     (rc=native_moded_update(wl->table, av+1, A3, av+3 PASS_LD)) )
+	{ if ( rc < 0 )
+	    return FALSE;
+	  if ( is_variant_ptr(valTermRef(av+1), valTermRef(av+3) PASS_LD) )
+	  { DEBUG(MSG_TABLING_MODED, Sdprintf("No change!\n"));
+	    return FALSE;
+	  }
+	} else
+	{ if ( !PRED_update4 )
+	    PRED_update4 = PL_predicate("update", 4, "$tabling");
+
+	  if ( !(PL_put_term(av+0, A4) &&
+		 PL_put_term(av+2, A3) &&
+		 PL_call_predicate(NULL, PL_Q_PASS_EXCEPTION, PRED_update4, av)) )
+	  { DEBUG(MSG_TABLING_MODED, Sdprintf("No change!\n"));
+	    return FALSE;
+	  }
 	}
 
+	if ( !set_trie_value(node, av+3 PASS_LD) )
+	  return FALSE;
+
 	DEBUG(MSG_TABLING_MODED,
 	      { Sdprintf("Updated answer to: ");
 		PL_write_term(Serror, av+3, 1200, PL_WRT_NEWLINE);
 	      });
 	return wkl_add_answer(wl, node PASS_LD);
       } else
-      { if ( !set_trie_value(node, A3 PASS_LD) )
+      { term_t first = PL_new_term_ref();
+
+	if ( !first ||
+	     !first_moded_value(wl->table, A3, first PASS_LD) ||
+	     !set_trie_value(node, first PASS_LD) )
 	  return FALSE;
 
 	DEBUG(MSG_TABLING_MODED,
 	      { Sdprintf("Set first answer: ");
-		PL_write_term(Serror, A3, 1200, PL_WRT_NEWLINE);
+		PL_write_term(Serror, first, 1200, PL_WRT_NEWLINE);
 	      });
 	return wkl_add_answer(wl, node PASS_LD);
       }
@@ -1289,7 +1837,13 @@ PRED_IMPL("$tbl_variant_table", 4, tbl_variant_table, 0)
   trie *trie;
 
   if ( (trie=get_variant_table(A1, TRUE PASS_LD)) )
-  { return ( _PL_unify_atomic(A2, trie->symbol) &&
+  { if ( trie->data.space )
+      lru_touch(trie PASS_LD);
+    if ( trie->data.worklist == WL_COMPLETE &&
+	 truePrologFlag(PLFLAG_TABLE_STATISTICS) )
+      trie->data.stats.reused++;
+
+    return ( _PL_unify_atomic(A2, trie->symbol) &&
 	     unify_table_status(A3, trie PASS_LD)  &&
 	     unify_skeleton(trie, A1, A4 PASS_LD) );
   }
@@ -1342,13 +1896,20 @@ PRED_IMPL("$tbl_table_complete_all", 1, tbl_table_complete_all, 0)
   { worklist **wls;
     size_t ntables = worklist_set_to_array(c->created_worklists, &wls);
     size_t i;
+    double now = truePrologFlag(PLFLAG_TABLE_STATISTICS) ? WallTime() : 0.0;
 
     for(i=0; i<ntables; i++)
     { worklist *wl = wls[i];
       trie *trie = wl->table;
 
       trie->data.worklist = WL_COMPLETE;
+      if ( trie->data.stats.started != 0.0 )
+      { trie->data.stats.time = now - trie->data.stats.started;
+	trie->data.stats.started = 0.0;
+      }
+      lru_link(trie PASS_LD);
     }
+    enforce_predicate_limits(wls, ntables PASS_LD);
     reset_newly_created_worklists(c);
     c->status = SCC_COMPLETED;
 
@@ -1363,6 +1924,75 @@ PRED_IMPL("$tbl_table_complete_all", 1, tbl_table_complete_all, 0)
 }
 
 
+/** '$tbl_table_complete'(+Trie) is semidet.
+ *
+ * Mark a fresh table as complete.  This is used to add tables computed
+ * by another thread to the tables of this thread.  Fails if the table
+ * is not fresh.
+ */
+
+static
+PRED_IMPL("$tbl_table_complete", 1, tbl_table_complete, 0)
+{ PRED_LD
+  trie *trie;
+
+  if ( get_trie(A1, &trie) )
+  { if ( !trie->data.variant ||
+	 get_trie_form_node(trie->data.variant) != LD->tabling.variant_table )
+      return PL_type_error("table", A1);
+
+    if ( !trie->data.worklist )
+    { trie->data.worklist = WL_COMPLETE;
+      lru_link(trie PASS_LD);
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+
+/** '$tbl_table_statistics'(+Trie, -Stats) is det.
+ *
+ * Stats is a list of Key(Value) terms  describing the table.  The keys
+ * time, reused and suspensions are only maintained while the flag
+ * `table_statistics` is true.
+ */
+
+static
+PRED_IMPL("$tbl_table_statistics", 2, tbl_table_statistics, 0)
+{ PRED_LD
+  trie *trie;
+
+  if ( get_trie(A1, &trie) )
+  { trie_stats stats;
+    term_t tail = PL_copy_term_ref(A2);
+    term_t head = PL_new_term_ref();
+
+    stat_trie(trie, &stats);
+    return ( PL_unify_list(tail, head, tail) &&
+	     PL_unify_term(head, PL_FUNCTOR_CHARS, "answers", 1,
+			           PL_INT64, (int64_t)stats.values) &&
+	     PL_unify_list(tail, head, tail) &&
+	     PL_unify_term(head, PL_FUNCTOR_CHARS, "space", 1,
+			           PL_INT64, (int64_t)stats.bytes) &&
+	     PL_unify_list(tail, head, tail) &&
+	     PL_unify_term(head, PL_FUNCTOR_CHARS, "time", 1,
+			           PL_FLOAT, trie->data.stats.time) &&
+	     PL_unify_list(tail, head, tail) &&
+	     PL_unify_term(head, PL_FUNCTOR_CHARS, "reused", 1,
+			           PL_INT64, (int64_t)trie->data.stats.reused) &&
+	     PL_unify_list(tail, head, tail) &&
+	     PL_unify_term(head, PL_FUNCTOR_CHARS, "suspensions", 1,
+			           PL_INT64,
+				   (int64_t)trie->data.stats.suspensions) &&
+	     PL_unify_nil(tail) );
+  }
+
+  return FALSE;
+}
+
+
 /** '$tbl_free_component'(+SCC)
  *
  * Destroy a component and all subcomponents
@@ -1726,6 +2356,8 @@ BeginPredDefs(tabling)
   PRED_DEF("$tbl_variant_table",        1, tbl_variant_table,        0)
   PRED_DEF("$tbl_table_status",		4, tbl_table_status,	     0)
   PRED_DEF("$tbl_table_complete_all",	1, tbl_table_complete_all,   0)
+  PRED_DEF("$tbl_table_complete",	1, tbl_table_complete,	     0)
+  PRED_DEF("$tbl_table_statistics",	2, tbl_table_statistics,     0)
   PRED_DEF("$tbl_free_component",       1, tbl_free_component,       0)
   PRED_DEF("$tbl_table_discard_all",    1, tbl_table_discard_all,    0)
   PRED_DEF("$tbl_create_component",	1, tbl_create_component,     0)
@@ -1733,6 +2365,8 @@ BeginPredDefs(tabling)
   PRED_DEF("$tbl_component_status",     2, tbl_component_status,     0)
   PRED_DEF("$tbl_abolish_all_tables",   0, tbl_abolish_all_tables,   0)
   PRED_DEF("$tbl_destroy_table",        1, tbl_destroy_table,        0)
+  PRED_DEF("$tbl_set_space_limit",      2, tbl_set_space_limit,      0)
+  PRED_DEF("$tbl_space_limit",          3, tbl_space_limit,          0)
   PRED_DEF("$tbl_trienode",             1, tbl_trienode,             0)
 
   PRED_DEF("$tbl_scc",                  1, tbl_scc,                  0)
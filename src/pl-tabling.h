@@ -101,6 +101,22 @@ typedef struct worklist
 } worklist;
 
 
+		 /*******************************
+		 *	 MODE DIRECTED TABLING	*
+		 *******************************/
+
+typedef enum
+{ TBL_UPDATE_PROLOG = 1,		/* Call '$tabling':update/4 */
+  TBL_UPDATE_FIRST,			/* Keep the first answer */
+  TBL_UPDATE_LAST,			/* Keep the last answer */
+  TBL_UPDATE_MIN,			/* Minimum in standard order */
+  TBL_UPDATE_MAX,			/* Maximum in standard order */
+  TBL_UPDATE_SUM,			/* Sum of the answers */
+  TBL_UPDATE_COUNT			/* Number of answers */
+} tbl_update_mode;
+
+
 COMMON(void) clearThreadTablingData(PL_local_data_t *ld);
+COMMON(int)  tbl_reclaim_space(trie *into, size_t needed);
 
 #endif /*_PL_TABLING_H*/
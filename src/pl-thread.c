@@ -316,6 +316,7 @@ counting_mutex _PL_mutexes[] =
 #endif
 };
 
+int _PL_lock_profile = 0;		/* Time 1/N acquisitions (pl-mutex.c) */
 
 static void
 link_mutexes(void)
@@ -438,6 +439,7 @@ win_thread_initialize(void)
 static PL_thread_info_t *alloc_thread(void);
 static void	destroy_message_queue(message_queue *queue);
 static void	destroy_thread_message_queue(message_queue *queue);
+static void	flush_pending_messages(message_queue *queue);
 static void	init_message_queue(message_queue *queue, size_t max_size);
 static void	freeThreadSignals(PL_local_data_t *ld);
 static void	run_thread_exit_hooks(PL_local_data_t *ld);
@@ -452,6 +454,8 @@ static void	detach_engine(PL_engine_t e);
 static int	unify_queue(term_t t, message_queue *q);
 static int	get_message_queue_unlocked__LD(term_t t, message_queue **queue ARG_LD);
 static int	get_message_queue__LD(term_t t, message_queue **queue ARG_LD);
+static int	get_message_queue_unlocked_ref__LD(term_t t, message_queue **queue
+						   ARG_LD);
 static void	release_message_queue(message_queue *queue);
 static void	initMessageQueues(void);
 static int	thread_at_exit(term_t goal, PL_local_data_t *ld);
@@ -550,6 +554,85 @@ free_local_data(PL_local_data_t *ld)
   freeHeap(ld, sizeof(*ld));
 }
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Local data blocks of terminated threads are  kept in GD->thread.cache for
+reuse by alloc_thread(), up to the flag thread_cache_size. Together with
+the stack cache (see cacheStacks()) this   avoids most of the allocation
+work when creating and joining short-lived threads and engines.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+cache_local_data(PL_local_data_t *ld)
+{ int rc = FALSE;
+
+  if ( GD->thread.cache.ld_count < GD->thread.cache.size )
+  { PL_LOCK(L_THREAD);
+    if ( GD->thread.cache.ld_count < GD->thread.cache.size )
+    { simpleMutexDelete(&ld->thread.scan_lock);
+      ld->next_free = GD->thread.cache.local_data;
+      GD->thread.cache.local_data = ld;
+      GD->thread.cache.ld_count++;
+      rc = TRUE;
+    }
+    PL_UNLOCK(L_THREAD);
+  }
+
+  return rc;
+}
+
+static PL_local_data_t *
+reuse_local_data(void)
+{ PL_local_data_t *ld = NULL;
+
+  if ( GD->thread.cache.local_data )
+  { PL_LOCK(L_THREAD);
+    if ( (ld=GD->thread.cache.local_data) )
+    { GD->thread.cache.local_data = ld->next_free;
+      GD->thread.cache.ld_count--;
+    }
+    PL_UNLOCK(L_THREAD);
+  }
+
+  return ld;
+}
+
+static void
+trim_thread_cache(int size)
+{ PL_local_data_t *ld, *next;
+
+  PL_LOCK(L_THREAD);
+  for(ld=NULL; GD->thread.cache.ld_count > size; ld=next)
+  { next = GD->thread.cache.local_data;
+    GD->thread.cache.local_data = next->next_free;
+    GD->thread.cache.ld_count--;
+    next->next_free = ld;
+  }
+  PL_UNLOCK(L_THREAD);
+
+  for(; ld; ld=next)
+  { next = ld->next_free;
+    freeHeap(ld, sizeof(*ld));
+  }
+  trimStackCache(size);
+}
+
+int
+set_thread_cache_size(int64_t size)
+{ if ( size < 0 || size > INT_MAX )
+  { GET_LD
+    term_t t;
+
+    return ( (t=PL_new_term_ref()) &&
+	     PL_put_int64(t, size) &&
+	     PL_domain_error("thread_cache_size", t) );
+  }
+
+  GD->thread.cache.size = (int)size;
+  trim_thread_cache((int)size);
+
+  return TRUE;
+}
+
 static PL_local_data_t *ld_free_list = NULL;
 
 static void
@@ -570,7 +653,8 @@ clean_ld_free_list(void)
 static void
 maybe_free_local_data(PL_local_data_t *ld)
 { if ( !ldata_in_use(ld) )
-  { free_local_data(ld);
+  { if ( !cache_local_data(ld) )
+      free_local_data(ld);
   } else
   { PL_LOCK(L_THREAD);
     clean_ld_free_list();
@@ -638,7 +722,8 @@ freePrologThread(PL_local_data_t *ld, int after_fork)
   ld->magic = 0;
   if ( ld->stacks.global.base )		/* otherwise not initialised */
   { simpleMutexLock(&ld->thread.scan_lock);
-    freeStacks(ld);
+    if ( !cacheStacks(ld) )
+      freeStacks(ld);
     simpleMutexUnlock(&ld->thread.scan_lock);
   }
   freePrologLocalData(ld);
@@ -666,6 +751,10 @@ freePrologThread(PL_local_data_t *ld, int after_fork)
 #endif
   info->thread_data = NULL;		/* avoid a loop */
   info->has_tid = FALSE;		/* needed? */
+  if ( info->access.ldata )
+  { info->access.ldata = NULL;
+    ATOMIC_DEC(&GD->thread.ldata_access);
+  }
   if ( !after_fork )
     PL_UNLOCK(L_THREAD);
 
@@ -842,6 +931,7 @@ initPrologThreads(void)
     memset(info, 0, sizeof(*info));
     info->pl_tid = 1;
     info->debug = TRUE;
+    info->numa_node = -1;
     thread_highest_id = 1;
     info->thread_data = &PL_local_data;
     info->status = PL_THREAD_RUNNING;
@@ -853,6 +943,7 @@ initPrologThreads(void)
 
     GD->statistics.thread_cputime = 0.0;
     GD->statistics.threads_created = 1;
+    GD->thread.cache.size = THREAD_CACHE_SIZE;
     pthread_mutex_init(&GD->thread.index.mutex, NULL);
     pthread_cond_init(&GD->thread.index.cond, NULL);
     initMutexes();
@@ -880,10 +971,15 @@ cleanupThreads(void)
   { destroyHTable(GD->thread.mutexTable);
     GD->thread.mutexTable = NULL;
   }
+  if ( GD->thread.rwlockTable )
+  { destroyHTable(GD->thread.rwlockTable);
+    GD->thread.rwlockTable = NULL;
+  }
   if ( threadTable )
   { destroyHTable(threadTable);
     threadTable = NULL;
   }
+  trim_thread_cache(0);
   for(i=1; i<GD->thread.thread_max; i++)
   { PL_thread_info_t *info = GD->thread.threads[i];
 
@@ -1342,11 +1438,13 @@ alloc_thread(void)
     assert(info->status == PL_THREAD_UNUSED);
     memset(info, 0, sizeof(*info));
     info->pl_tid = i;
+    info->numa_node = -1;
   } else
   { int i;
 
     info = allocHeapOrHalt(sizeof(*info));
     memset(info, 0, sizeof(*info));
+    info->numa_node = -1;
 
     PL_LOCK(L_THREAD);
     i = info->pl_tid = ++GD->thread.highest_allocated;
@@ -1358,7 +1456,8 @@ alloc_thread(void)
     PL_UNLOCK(L_THREAD);
   }
 
-  ld = allocHeapOrHalt(sizeof(PL_local_data_t));
+  if ( !(ld = reuse_local_data()) )
+    ld = allocHeapOrHalt(sizeof(PL_local_data_t));
   memset(ld, 0, sizeof(PL_local_data_t));
 
   ld->thread.info = info;
@@ -1689,6 +1788,7 @@ static const opt_spec make_thread_options[] =
   { ATOM_inherit_from,	 OPT_TERM },
   { ATOM_affinity,	 OPT_TERM },
   { ATOM_queue_max_size, OPT_SIZE },
+  { ATOM_numa_node,	 OPT_INT },
   { NULL_ATOM,		 0 }
 };
 
@@ -1713,6 +1813,168 @@ set_thread_completion(PL_thread_info_t *info, int rc, term_t ex)
 }
 
 
+		 /*******************************
+		 *	       NUMA		*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+NUMA support (Linux). The node of each CPU is read from sysfs the first
+time it is needed. A thread whose CPU  set   is  on a single node (see
+the thread_create/3 options affinity  and   numa_node  and  the last
+thread_affinity/3 call on itself) is _bound_ to  this node. A bound thread
+prefers memory from its node for everything it touches (stacks, clauses,
+message records, ...) and moves its  local   data  to  the node when it
+starts. Cached stacks are only reused by threads bound to the same node
+(see cacheStacks()).
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#if defined(__linux__) && defined(HAVE_SCHED_SETAFFINITY) && \
+    defined(HAVE_LINUX_MEMPOLICY_H) && \
+    defined(SYS_mbind) && defined(SYS_set_mempolicy)
+#include <linux/mempolicy.h>
+#include <dirent.h>
+#define O_NUMA 1
+
+#define NUMA_MAX_NODES 256
+
+static pthread_once_t numa_once = PTHREAD_ONCE_INIT;
+static int	      numa_nodes = 0;	/* # nodes (highest+1) */
+static short	      numa_cpu_node[CPU_SETSIZE]; /* cpu --> node */
+
+static void
+numa_read_cpulist(int node, const char *path)
+{ FILE *fd;
+
+  if ( (fd = fopen(path, "r")) )
+  { int from, to;
+    char sep;
+
+    while( fscanf(fd, "%d", &from) == 1 )
+    { to = from;
+      if ( (sep=getc(fd)) == '-' )
+      { if ( fscanf(fd, "%d", &to) != 1 )
+	  break;
+	sep = getc(fd);
+      }
+      for(; from <= to && from < CPU_SETSIZE; from++)
+      { if ( from >= 0 )
+	  numa_cpu_node[from] = (short)node;
+      }
+      if ( sep != ',' )
+	break;
+    }
+    fclose(fd);
+  }
+}
+
+static void
+init_numa(void)
+{ DIR *dir;
+  int i;
+
+  for(i=0; i<CPU_SETSIZE; i++)
+    numa_cpu_node[i] = -1;
+
+  if ( (dir = opendir("/sys/devices/system/node")) )
+  { struct dirent *e;
+
+    while( (e=readdir(dir)) )
+    { int node;
+      char path[PATH_MAX];
+
+      if ( sscanf(e->d_name, "node%d", &node) == 1 &&
+	   node >= 0 && node < NUMA_MAX_NODES )
+      { Ssnprintf(path, sizeof(path),
+		  "/sys/devices/system/node/%s/cpulist", e->d_name);
+	numa_read_cpulist(node, path);
+	if ( node >= numa_nodes )
+	  numa_nodes = node+1;
+      }
+    }
+    closedir(dir);
+  }
+}
+
+static int
+cpu_numa_node(int cpu)
+{ pthread_once(&numa_once, init_numa);
+
+  return cpu >= 0 && cpu < CPU_SETSIZE ? numa_cpu_node[cpu] : -1;
+}
+
+/* The node of all CPUs in set or -1 if they are not on a single node
+*/
+
+static int
+cpuset_numa_node(const cpu_set_t *set)
+{ int cpu, node = -1;
+
+  for(cpu=0; cpu<CPU_SETSIZE; cpu++)
+  { if ( CPU_ISSET(cpu, set) )
+    { int n = cpu_numa_node(cpu);
+
+      if ( n < 0 || (node >= 0 && n != node) )
+	return -1;
+      node = n;
+    }
+  }
+
+  return node;
+}
+
+static int
+numa_node_cpuset(int node, cpu_set_t *set)
+{ int cpu, count = 0;
+
+  CPU_ZERO(set);
+  for(cpu=0; cpu<CPU_SETSIZE; cpu++)
+  { if ( cpu_numa_node(cpu) == node )
+    { CPU_SET(cpu, set);
+      count++;
+    }
+  }
+
+  return count > 0;
+}
+
+/* Make the calling thread prefer memory from node and move the pages
+   that are entirely inside the local data block `ld` there.  If node is
+   -1, restore the default policy.  Failure (e.g., no permission) is
+   silently ignored as this is an optimization.
+*/
+
+static void
+numa_bind_memory(int node, PL_local_data_t *ld)
+{ unsigned long mask[NUMA_MAX_NODES/(sizeof(long)*8)] = {0};
+  unsigned long maxnode = sizeof(mask)*8+1;
+
+  if ( node < 0 || node >= NUMA_MAX_NODES )
+  { (void)syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+    return;
+  }
+
+  mask[node/(sizeof(long)*8)] = 1UL << (node%(sizeof(long)*8));
+  if ( syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, maxnode) != 0 )
+    return;
+
+  if ( ld )
+  { size_t psize = sysconf(_SC_PAGESIZE);
+    uintptr_t start = ROUND((uintptr_t)ld, psize);
+    uintptr_t end   = ((uintptr_t)ld+sizeof(*ld)) & ~(uintptr_t)(psize-1);
+
+    if ( end > start )
+      (void)syscall(SYS_mbind, (void*)start, (size_t)(end-start),
+		    MPOL_PREFERRED, mask, maxnode, MPOL_MF_MOVE);
+  }
+}
+
+#else /*O_NUMA*/
+
+#define numa_bind_memory(node, ld) (void)0
+
+#endif /*O_NUMA*/
+
+
 static void *
 start_thread(void *closure)
 { PL_thread_info_t *info = closure;
@@ -1724,6 +1986,8 @@ start_thread(void *closure)
   blockSignal(SIGINT);			/* only the main thread processes */
 					/* Control-C */
   set_system_thread_id(info);		/* early to get exit code ok */
+  if ( info->numa_node >= 0 )
+    numa_bind_memory(info->numa_node, info->thread_data);
 
   if ( !initialise_thread(info) )
     return (void *)FALSE;
@@ -1807,6 +2071,7 @@ copy_local_data(PL_local_data_t *ldnew, PL_local_data_t *ldold,
   ldnew->IO			  = ldold->IO;
   ldnew->IO.input_stack		  = NULL;
   ldnew->IO.output_stack	  = NULL;
+  ldnew->IO.redirect_stream	  = NULL;
   ldnew->encoding		  = ldold->encoding;
 #ifdef O_LOCALE
   ldnew->locale.current		  = acquireLocale(ldold->locale.current);
@@ -1902,21 +2167,55 @@ get_cpuset(term_t affinity, cpu_set_t *set)
 #endif /*defined(HAVE_PTHREAD_ATTR_SETAFFINITY_NP) || defined(HAVE_SCHED_SETAFFINITY)*/
 
 static int
-set_affinity(term_t affinity, pthread_attr_t *attr)
+set_affinity(term_t affinity, int numa_node,
+	     PL_thread_info_t *info, pthread_attr_t *attr)
 {
 #ifdef HAVE_PTHREAD_ATTR_SETAFFINITY_NP
   cpu_set_t cpuset;
 
-  if ( !get_cpuset(affinity, &cpuset) )
-    return EINVAL;
+  if ( affinity )
+  { if ( !get_cpuset(affinity, &cpuset) )
+      return EINVAL;
+  } else
+  {
+#ifdef O_NUMA
+    if ( !numa_node_cpuset(numa_node, &cpuset) )
+#endif
+      return EINVAL;
+  }
+#ifdef O_NUMA
+  info->numa_node = numa_node >= 0 ? numa_node : cpuset_numa_node(&cpuset);
+#endif
 
   return pthread_attr_setaffinity_np(attr, sizeof(cpuset), &cpuset);
+#else
+  (void)affinity;
+  (void)numa_node;
+  (void)info;
+  (void)attr;
 #endif
 
   return 0;
 }
 
 
+/* TRUE if node is a NUMA node with CPUs
+*/
+
+static int
+valid_numa_node(int node)
+{
+#ifdef O_NUMA
+  cpu_set_t set;
+
+  return node >= 0 && numa_node_cpuset(node, &set);
+#else
+  (void)node;
+  return FALSE;
+#endif
+}
+
+
 word
 pl_thread_create(term_t goal, term_t id, term_t options)
 { GET_LD
@@ -1931,6 +2230,7 @@ pl_thread_create(term_t goal, term_t id, term_t options)
   term_t at_exit = 0;
   term_t affinity = 0;
   size_t queue_max_size = 0;
+  int numa_node = -1;
   int rc = 0;
   const char *func;
   int debug = -1;
@@ -1959,10 +2259,19 @@ pl_thread_create(term_t goal, term_t id, term_t options)
 		     &at_exit,
 		     &inherit_from,
 		     &affinity,
-		     &queue_max_size) )
+		     &queue_max_size,
+		     &numa_node) )
   { free_thread_info(info);
     fail;
   }
+  if ( numa_node != -1 && !valid_numa_node(numa_node) )
+  { term_t culprit;
+
+    free_thread_info(info);
+    return ( (culprit=PL_new_term_ref()) &&
+	     PL_put_integer(culprit, numa_node) &&
+	     PL_existence_error("numa_node", culprit) );
+  }
   info->detached = detached;
   if ( at_exit && !PL_is_callable(at_exit) )
   { free_thread_info(info);
@@ -2023,8 +2332,8 @@ pl_thread_create(term_t goal, term_t id, term_t options)
   { func = "pthread_attr_setdetachstate";
     rc = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
   }
-  if ( rc == 0 && affinity )
-    rc = set_affinity(affinity, &attr);
+  if ( rc == 0 && (affinity || numa_node >= 0) )
+    rc = set_affinity(affinity, numa_node, info, &attr);
   if ( rc == 0 )
   {
 #ifdef USE_COPY_STACK_SIZE
@@ -2560,6 +2869,16 @@ thread_tid_propery(PL_thread_info_t *info, term_t prop ARG_LD)
   return FALSE;
 }
 
+static int
+thread_numa_node_propery(PL_thread_info_t *info, term_t prop ARG_LD)
+{ IGNORE_LD
+
+  if ( info->numa_node >= 0 )
+    return PL_unify_integer(prop, info->numa_node);
+
+  return FALSE;
+}
+
 static const tprop tprop_list [] =
 { { FUNCTOR_id1,	       thread_id_propery },
   { FUNCTOR_alias1,	       thread_alias_propery },
@@ -2569,6 +2888,7 @@ static const tprop tprop_list [] =
   { FUNCTOR_engine1,	       thread_engine_propery },
   { FUNCTOR_thread1,	       thread_thread_propery },
   { FUNCTOR_system_thread_id1, thread_tid_propery },
+  { FUNCTOR_numa_node1,	       thread_numa_node_propery },
   { 0,			       NULL }
 };
 
@@ -2783,7 +3103,13 @@ PRED_IMPL("thread_affinity", 3, thread_affinity, 0)
     if ( PL_compare(A2, A3) != 0 )
     { if ( (rc=get_cpuset(A3, &cpuset)) )
       { if ( (rc=sched_setaffinity(info->pid, sizeof(cpuset), &cpuset)) == 0 )
-	{ rc = TRUE;
+	{
+#ifdef O_NUMA
+	  info->numa_node = cpuset_numa_node(&cpuset);
+	  if ( info == LD->thread.info )
+	    numa_bind_memory(info->numa_node, NULL);
+#endif
+	  rc = TRUE;
 	} else
 	{ rc = PL_error(NULL, 0, ThError(rc),
 			ERR_SYSCALL, "sched_setaffinity");
@@ -3172,6 +3498,7 @@ static const opt_spec make_engine_options[] =
 { { ATOM_stack_limit,	OPT_SIZE|OPT_INF },
   { ATOM_alias,		OPT_ATOM },
   { ATOM_inherit_from,	OPT_TERM },
+  { ATOM_small_stacks,	OPT_BOOL },
   { NULL_ATOM,		0 }
 };
 
@@ -3184,14 +3511,18 @@ PRED_IMPL("$engine_create", 3, engine_create, 0)
   size_t stack	      =	0;
   atom_t alias	      =	NULL_ATOM;
   term_t inherit_from =	0;
+  int small_stacks    = FALSE;
 
   memset(&attrs, 0, sizeof(attrs));
   if ( !scan_options(A3, 0,
 		     ATOM_engine_option, make_engine_options,
 		     &stack,
 		     &alias,
-		     &inherit_from) )
+		     &inherit_from,
+		     &small_stacks) )
     return FALSE;
+  if ( small_stacks )
+    attrs.flags |= PL_THREAD_SMALL_STACKS;
 
   if ( stack )
     attrs.stack_limit = stack;
@@ -3808,9 +4139,106 @@ free_thread_message(thread_message *msg)
 }
 
 
+#if defined(HAVE_LINUX_FUTEX_H) && defined(SYS_futex)
+#include <linux/futex.h>
+#define O_QUEUE_FUTEX 1
+
+static int
+futex_wait(unsigned int *addr, unsigned int val, struct timespec *timeout)
+{ return (int)syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout,
+		      NULL, 0);
+}
+
+static void
+futex_wake(unsigned int *addr, int count)
+{ syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+#endif
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+wakeup_readers() wakes threads  waiting  for  a  message  after  a  new
+message was added.  The caller must hold the queue-mutex.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+wakeup_readers(message_queue *queue)
+{ if ( queue->waiting )
+  {
+#ifdef O_QUEUE_FUTEX
+    if ( queue->waiting_var )
+    { DEBUG(MSG_THREAD, Sdprintf("var waiters; waking one\n"));
+      ATOMIC_INC(&queue->wakeup);
+      futex_wake(&queue->wakeup, 1);
+    }
+    if ( queue->waiting > queue->waiting_var )
+    { DEBUG(MSG_THREAD,
+	    Sdprintf("%d non-var waiters; broadcasting\n",
+		     queue->waiting - queue->waiting_var));
+      cv_broadcast(&queue->cond_var);
+    }
+#else
+    if ( queue->waiting > queue->waiting_var && queue->waiting > 1 )
+    { DEBUG(MSG_THREAD,
+	    Sdprintf("%d of %d non-var waiters; broadcasting\n",
+		     queue->waiting - queue->waiting_var,
+		     queue->waiting));
+      cv_broadcast(&queue->cond_var);
+    } else
+    { DEBUG(MSG_THREAD, Sdprintf("%d var waiters; signalling\n", queue->waiting));
+      cv_signal(&queue->cond_var);
+    }
+#endif
+  } else
+  { DEBUG(MSG_THREAD, Sdprintf("No waiters\n"));
+  }
+}
+
+
+/* A reader waiting with an unbound message stops waiting without taking
+   a message.  If it consumed the futex wakeup for a message, pass it on.
+   The caller must hold the queue-mutex.
+*/
+
+static void
+pass_wakeup(message_queue *queue, int isvar)
+{
+#ifdef O_QUEUE_FUTEX
+  if ( isvar && queue->waiting_var && (queue->head || queue->pending) )
+  { ATOMIC_INC(&queue->wakeup);
+    futex_wake(&queue->wakeup, 1);
+  }
+#else
+  (void)queue;
+  (void)isvar;
+#endif
+}
+
+
+/* Wake all readers and writers, used if the queue is destroyed.  The
+   caller must hold the queue-mutex.
+*/
+
+static void
+wakeup_all(message_queue *queue)
+{ if ( queue->waiting )
+  { cv_broadcast(&queue->cond_var);
+#ifdef O_QUEUE_FUTEX
+    ATOMIC_INC(&queue->wakeup);
+    futex_wake(&queue->wakeup, INT_MAX);
+#endif
+  }
+  if ( queue->wait_for_drain )
+    cv_broadcast(&queue->drain_var);
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 queue_message() adds a message to a message queue.  The caller must hold
-the queue-mutex.
+the queue-mutex.  Messages sent without locking may still be pending, so
+we first move these to the queue to preserve the sending order.  As the
+lock-free senders update queue->size without the mutex, the size is
+updated atomically.
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 static int
@@ -3850,6 +4278,7 @@ queue_message(message_queue *queue, thread_message *msgp,
     queue->wait_for_drain--;
   }
 
+  flush_pending_messages(queue);
   msgp->sequence_id = ++queue->sequence_next;
   if ( !queue->head )
   { queue->head = queue->tail = msgp;
@@ -3857,24 +4286,111 @@ queue_message(message_queue *queue, thread_message *msgp,
   { queue->tail->next = msgp;
     queue->tail = msgp;
   }
-  queue->size++;
+  ATOMIC_INC(&queue->size);
+
+  wakeup_readers(queue);
+
+  return TRUE;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Lock-free sending.  Unbounded queues (max_size  is 0) accept messages
+without  taking  queue->mutex.  The  sender  pushes  the  message  on
+queue->pending,  a  lock-free  LIFO  list  that  is  only  extended  by
+senders.  Readers  hold  the  mutex  and call flush_pending_messages()
+before scanning the  queue,  which  moves  the  pending  messages  in
+sending order to the tail of the  queue and assigns their sequence ids.
+The queue itself, and thus selective  receive  and  peeking, is left
+untouched.
+
+Readers that wait with an unbound  message  park  on  the  futex word
+queue->wakeup (Linux) rather  than  on  cond_var,  such  that  a  sender
+can wake exactly one of them  without  taking  the  mutex.  Readers that
+wait with a pattern keep  using  cond_var  and  are  woken  using  a
+broadcast while holding the mutex.  To  avoid  lost  wakeups, senders
+push, increment queue->wakeup  and  then  read  the waiting counts, while
+readers increment the waiting counts,  read  queue->wakeup  and  check
+queue->pending before they go to sleep.
+
+While a sender uses the queue without holding the mutex, queue->senders
+is non-zero, which delays releasing the queue.  Bounded queues use the
+locked queue_message() as senders may have to wait for the queue to
+drain.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/* push_messages() adds  a  chain  of  `count`  messages  linked  from
+   `first` to `last`.  As queue->pending is LIFO, `first` is the last
+   message sent.
+*/
+
+static void
+push_messages(message_queue *queue,
+	      thread_message *first, thread_message *last, size_t count)
+{ thread_message *head;
+
+  do
+  { head = queue->pending;
+    last->next = head;
+  } while( !COMPARE_AND_SWAP(&queue->pending, head, first) );
+
+  ATOMIC_ADD(&queue->size, count);
+  ATOMIC_INC(&queue->wakeup);		/* also a full barrier */
 
   if ( queue->waiting )
-  { if ( queue->waiting > queue->waiting_var && queue->waiting > 1 )
-    { DEBUG(MSG_THREAD,
-	    Sdprintf("%d of %d non-var waiters; broadcasting\n",
-		     queue->waiting - queue->waiting_var,
-		     queue->waiting));
+  {
+#ifdef O_QUEUE_FUTEX
+    if ( queue->waiting_var )
+    { DEBUG(MSG_THREAD, Sdprintf("var waiters; waking %zd\n", count));
+      futex_wake(&queue->wakeup, count > INT_MAX ? INT_MAX : (int)count);
+    }
+    if ( queue->waiting > queue->waiting_var )
+#endif
+    { simpleMutexLock(&queue->mutex);
+#ifdef O_QUEUE_FUTEX
       cv_broadcast(&queue->cond_var);
-    } else
-    { DEBUG(MSG_THREAD, Sdprintf("%d var waiters; signalling\n", queue->waiting));
-      cv_signal(&queue->cond_var);
+#else
+      wakeup_readers(queue);
+#endif
+      simpleMutexUnlock(&queue->mutex);
     }
-  } else
-  { DEBUG(MSG_THREAD, Sdprintf("No waiters\n"));
   }
+}
 
-  return TRUE;
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+flush_pending_messages() moves the messages  sent  without  locking  to
+the queue.  The caller must hold  the  queue-mutex.  We  also  lock
+queue->gc_mutex as markAtomsMessageQueue() must see each message either
+in the pending list or in the queue.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+flush_pending_messages(message_queue *queue)
+{ thread_message *msgp, *next, *first = NULL, *last;
+
+  if ( !queue->pending )
+    return;
+
+  simpleMutexLock(&queue->gc_mutex);
+  do
+  { msgp = queue->pending;
+  } while( !COMPARE_AND_SWAP(&queue->pending, msgp, NULL) );
+
+  for(last = msgp; msgp; msgp = next)	/* reverse to sending order */
+  { next = msgp->next;
+    msgp->next = first;
+    first = msgp;
+  }
+  for(msgp = first; msgp; msgp = msgp->next)
+    msgp->sequence_id = ++queue->sequence_next;
+
+  if ( !queue->head )
+    queue->head = first;
+  else
+    queue->tail->next = first;
+  queue->tail = last;
+  simpleMutexUnlock(&queue->gc_mutex);
 }
 
 
@@ -4014,6 +4530,48 @@ dispatch_cond_wait(message_queue *queue, queue_wait_type wait, struct timespec *
 
 #endif /*__WINDOWS__*/
 
+#ifdef O_QUEUE_FUTEX
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+dispatch_futex_wait() is the futex  version  of  dispatch_cond_wait(),
+used by readers waiting with an unbound message.  `seen` is the value of
+queue->wakeup read after announcing we are waiting.  We wake up at least
+every 250ms to check for signals.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+dispatch_futex_wait(message_queue *queue, unsigned int seen,
+		    struct timespec *deadline)
+{ GET_LD
+  struct timespec timeout = {0, 250000000};
+  int at_deadline = FALSE;
+  int rc;
+
+  if ( deadline )
+  { struct timespec now, left;
+
+    get_current_timespec(&now);
+    timespec_diff(&left, deadline, &now);
+    if ( timespec_sign(&left) <= 0 )
+      return ETIMEDOUT;
+    if ( timespec_cmp(&left, &timeout) <= 0 )
+    { timeout = left;
+      at_deadline = TRUE;
+    }
+  }
+
+  simpleMutexUnlock(&queue->mutex);
+  rc = (futex_wait(&queue->wakeup, seen, &timeout) == 0 ? 0 : errno);
+  simpleMutexLock(&queue->mutex);
+
+  if ( is_signalled(LD) )
+    return EINTR;
+  if ( rc == ETIMEDOUT && at_deadline )
+    return ETIMEDOUT;
+
+  return 0;
+}
+#endif /*O_QUEUE_FUTEX*/
+
 #ifdef O_QUEUE_STATS
 static uint64_t getmsg  = 0;
 static uint64_t unified = 0;
@@ -4029,6 +4587,77 @@ msg_statistics(void)
 #define QSTAT(n) ((void)0)
 #endif
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+wait_for_message() waits for a new message to arrive.  It must be called
+with queue->mutex locked after scanning the queue.  `isvar` is 1 if the
+reader accepts any message.  Returns TRUE if the queue must be scanned
+again, MSG_WAIT_INTR or MSG_WAIT_TIMEOUT.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+wait_for_message(message_queue *queue, int isvar,
+		 struct timespec *deadline ARG_LD)
+{ unsigned int wakeup;
+  int rc;
+
+  ATOMIC_INC(&queue->waiting);		/* see push_messages() */
+  if ( isvar )
+    ATOMIC_INC(&queue->waiting_var);
+  wakeup = queue->wakeup;
+  if ( queue->pending )
+  { queue->waiting--;
+    queue->waiting_var -= isvar;
+    return TRUE;
+  }
+
+  DEBUG(MSG_QUEUE_WAIT, Sdprintf("%d: waiting on queue\n", PL_thread_self()));
+#ifdef O_QUEUE_FUTEX
+  if ( isvar )
+    rc = dispatch_futex_wait(queue, wakeup, deadline);
+  else
+#endif
+    rc = dispatch_cond_wait(queue, QUEUE_WAIT_READ, deadline);
+  (void)wakeup;
+
+  switch ( rc )
+  { case EINTR:
+    { DEBUG(MSG_QUEUE_WAIT, Sdprintf("%d: EINTR\n", PL_thread_self()));
+
+      if ( !LD )			/* needed for clean exit */
+      { Sdprintf("Forced exit from get_message()\n");
+	exit(1);
+      }
+
+      if ( is_signalled(LD) )		/* thread-signal */
+      { queue->waiting--;
+	queue->waiting_var -= isvar;
+	pass_wakeup(queue, isvar);
+	return MSG_WAIT_INTR;
+      }
+      break;
+    }
+    case ETIMEDOUT:
+    { DEBUG(MSG_QUEUE_WAIT, Sdprintf("%d: ETIMEDOUT\n", PL_thread_self()));
+
+      queue->waiting--;
+      queue->waiting_var -= isvar;
+      pass_wakeup(queue, isvar);
+      return MSG_WAIT_TIMEOUT;
+    }
+    case 0:
+      DEBUG(MSG_QUEUE_WAIT,
+	    Sdprintf("%d: wakeup on queue\n", PL_thread_self()));
+      break;
+    default:
+      assert(0);
+  }
+  queue->waiting--;
+  queue->waiting_var -= isvar;
+
+  return TRUE;
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 get_message() reads the next message from the  message queue. It must be
 called with queue->mutex locked.  It returns one of
@@ -4064,12 +4693,16 @@ get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
   QSTAT(getmsg);
 
   for(;;)
-  { thread_message *msgp = queue->head;
+  { thread_message *msgp;
     thread_message *prev = NULL;
+    int wrc;
 
     if ( queue->destroyed )
       return MSG_WAIT_DESTROYED;
 
+    flush_pending_messages(queue);
+    msgp = queue->head;
+
     DEBUG(MSG_QUEUE,
 	  if ( queue->size > 0 )
 	    Sdprintf("%d: scanning queue (size=%ld)\n",
@@ -4120,7 +4753,7 @@ get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
         simpleMutexUnlock(&queue->gc_mutex);
 
 	free_thread_message(msgp);
-	queue->size--;
+	ATOMIC_DEC(&queue->size);
 	if ( queue->wait_for_drain )
 	{ DEBUG(MSG_QUEUE, Sdprintf("Queue drained. wakeup writers\n"));
 	  cv_signal(&queue->drain_var);
@@ -4136,43 +4769,74 @@ get_message(message_queue *queue, term_t msg, struct timespec *deadline ARG_LD)
       PL_rewind_foreign_frame(fid);
     }
 
-    queue->waiting++;
-    queue->waiting_var += isvar;
-    DEBUG(MSG_QUEUE_WAIT, Sdprintf("%d: waiting on queue\n", PL_thread_self()));
-    switch ( dispatch_cond_wait(queue, QUEUE_WAIT_READ, deadline) )
-    { case EINTR:
-      { DEBUG(MSG_QUEUE_WAIT, Sdprintf("%d: EINTR\n", PL_thread_self()));
+    if ( (wrc=wait_for_message(queue, isvar, deadline PASS_LD)) != TRUE )
+    { PL_discard_foreign_frame(fid);
+      return wrc;
+    }
+  }
+}
 
-	if ( !LD )			/* needed for clean exit */
-	{ Sdprintf("Forced exit from get_message()\n");
-	  exit(1);
-	}
 
-	if ( is_signalled(LD) )		/* thread-signal */
-	{ queue->waiting--;
-	  queue->waiting_var -= isvar;
-	  PL_discard_foreign_frame(fid);
-	  return MSG_WAIT_INTR;
-	}
-	break;
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+get_messages() unifies `list` with the first `max` messages of the queue,
+waiting for at least one message to arrive.  The messages are removed
+from the queue using a single  update  of  the  list.  As  get_message(),
+it must be called with queue->mutex locked and returns the same values.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+get_messages(message_queue *queue, term_t list, size_t max,
+	     struct timespec *deadline ARG_LD)
+{ for(;;)
+  { int rc;
+
+    if ( queue->destroyed )
+      return MSG_WAIT_DESTROYED;
+
+    flush_pending_messages(queue);
+    if ( queue->head )
+    { term_t tail = PL_copy_term_ref(list);
+      term_t head = PL_new_term_ref();
+      term_t tmp  = PL_new_term_ref();
+      thread_message *msgp, *first = queue->head, *stop, *next;
+      size_t count = 0;
+
+      for(msgp = first; msgp && count < max; msgp = msgp->next, count++)
+      { if ( !PL_unify_list(tail, head, tail) )
+	  return FALSE;
+	if ( !PL_recorded(msgp->message, tmp) )
+	  return raiseStackOverflow(GLOBAL_OVERFLOW);
+	if ( !PL_unify(head, tmp) )
+	  return FALSE;
       }
-      case ETIMEDOUT:
-      { DEBUG(MSG_QUEUE_WAIT, Sdprintf("%d: ETIMEDOUT\n", PL_thread_self()));
+      if ( !PL_unify_nil(tail) )
+	return FALSE;
 
-	queue->waiting--;
-	queue->waiting_var -= isvar;
-	PL_discard_foreign_frame(fid);
-	return MSG_WAIT_TIMEOUT;
+      stop = msgp;
+
+      if ( GD->atoms.gc_active )
+      { for(msgp = first; msgp != stop; msgp = msgp->next)
+	  markAtomsRecord(msgp->message);
       }
-      case 0:
-	DEBUG(MSG_QUEUE_WAIT,
-	      Sdprintf("%d: wakeup on queue\n", PL_thread_self()));
-	break;
-      default:
-	assert(0);
+
+      simpleMutexLock(&queue->gc_mutex);	/* see get_message() */
+      if ( !(queue->head = stop) )
+	queue->tail = NULL;
+      simpleMutexUnlock(&queue->gc_mutex);
+
+      for(msgp = first; msgp != stop; msgp = next)
+      { next = msgp->next;
+	free_thread_message(msgp);
+      }
+      ATOMIC_SUB(&queue->size, count);
+      if ( queue->wait_for_drain )
+	cv_broadcast(&queue->drain_var);
+
+      return TRUE;
     }
-    queue->waiting--;
-    queue->waiting_var -= isvar;
+
+    if ( (rc=wait_for_message(queue, TRUE, deadline PASS_LD)) != TRUE )
+      return rc;
   }
 }
 
@@ -4184,7 +4848,7 @@ peek_message(message_queue *queue, term_t msg ARG_LD)
   word key = getIndexOfTerm(msg);
   fid_t fid = PL_open_foreign_frame();
 
-  msgp = queue->head;
+  flush_pending_messages(queue);
 
   for( msgp = queue->head; msgp; msgp = msgp->next )
   { if ( key && msgp->key && key != msgp->key )
@@ -4218,8 +4882,9 @@ destroy_message_queue(message_queue *queue)
     return;				/* deallocation is centralised */
   queue->initialized = FALSE;
 
-  assert(!queue->waiting && !queue->wait_for_drain);
+  assert(!queue->waiting && !queue->wait_for_drain && !queue->senders);
 
+  flush_pending_messages(queue);
   for( msgp = queue->head; msgp; msgp = next )
   { next = msgp->next;
 
@@ -4251,12 +4916,10 @@ destroy_thread_message_queue(message_queue *q)
   while(!done)
   { simpleMutexLock(&q->mutex);
     q->destroyed = TRUE;
-    if ( q->waiting || q->wait_for_drain )
-    { if ( q->waiting )
-	cv_broadcast(&q->cond_var);
-      if ( q->wait_for_drain )
-	cv_broadcast(&q->drain_var);
-    } else
+    MemoryBarrier();
+    if ( q->waiting || q->wait_for_drain || q->senders )
+      wakeup_all(q);
+    else
       done = TRUE;
     simpleMutexUnlock(&q->mutex);
   }
@@ -4406,13 +5069,24 @@ thread_send_message__LD(term_t queue, term_t msgterm,
   thread_message *msg;
   int rc;
 
-  if ( !get_message_queue__LD(queue, &q PASS_LD) )
-    return FALSE;
   if ( !(msg = create_thread_message(msgterm PASS_LD)) )
-  { release_message_queue(q);
     return PL_no_memory();
+
+  if ( !get_message_queue_unlocked_ref__LD(queue, &q PASS_LD) )
+  { free_thread_message(msg);
+    return FALSE;
+  }
+  if ( q->max_size == 0 )
+  { push_messages(q, msg, msg, 1);
+    ATOMIC_DEC(&q->senders);
+    return TRUE;
   }
+  ATOMIC_DEC(&q->senders);
 
+  if ( !get_message_queue__LD(queue, &q PASS_LD) )
+  { free_thread_message(msg);
+    return FALSE;
+  }
   rc = wait_queue_message(queue, q, msg, deadline PASS_LD);
   release_message_queue(q);
 
@@ -4422,6 +5096,86 @@ thread_send_message__LD(term_t queue, term_t msgterm,
   return rc;
 }
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+thread_send_messages(+Queue, +List)
+    Send all elements of List to Queue.  Unbounded queues receive the
+    messages using a single update of the queue and a single wakeup.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static void
+free_thread_messages(thread_message *msg)
+{ thread_message *next;
+
+  for( ; msg; msg = next )
+  { next = msg->next;
+    free_thread_message(msg);
+  }
+}
+
+static int
+thread_send_messages__LD(term_t queue, term_t list ARG_LD)
+{ term_t tail = PL_copy_term_ref(list);
+  term_t head = PL_new_term_ref();
+  thread_message *first = NULL, *last = NULL, *msg, *next;
+  message_queue *q;
+  size_t count = 0;
+  int rc = TRUE;
+
+  while( PL_get_list(tail, head, tail) )
+  { if ( !(msg = create_thread_message(head PASS_LD)) )
+    { free_thread_messages(first);
+      return PL_no_memory();
+    }
+    msg->next = first;			/* most recent first */
+    first = msg;
+    if ( !last )
+      last = msg;
+    count++;
+  }
+  if ( !PL_get_nil_ex(tail) ||
+       !get_message_queue_unlocked_ref__LD(queue, &q PASS_LD) )
+  { free_thread_messages(first);
+    return FALSE;
+  }
+  if ( q->max_size == 0 )
+  { if ( count > 0 )
+      push_messages(q, first, last, count);
+    ATOMIC_DEC(&q->senders);
+    return TRUE;
+  }
+  ATOMIC_DEC(&q->senders);
+
+  if ( !get_message_queue__LD(queue, &q PASS_LD) )
+  { free_thread_messages(first);
+    return FALSE;
+  }
+  for(msg = first, first = NULL; msg; msg = next) /* to sending order */
+  { next = msg->next;
+    msg->next = first;
+    first = msg;
+  }
+  for(msg = first; msg; msg = next)
+  { next = msg->next;
+    msg->next = NULL;
+    if ( (rc=wait_queue_message(queue, q, msg, NULL PASS_LD)) != TRUE )
+    { free_thread_message(msg);
+      free_thread_messages(next);
+      break;
+    }
+  }
+  release_message_queue(q);
+
+  return rc;
+}
+
+static
+PRED_IMPL("thread_send_messages", 2, thread_send_messages, 0)
+{ PRED_LD
+
+  return thread_send_messages__LD(A1, A2 PASS_LD);
+}
+
+
 static
 PRED_IMPL("thread_send_message", 2, thread_send_message, PL_FA_ISO)
 { PRED_LD
@@ -4739,6 +5493,43 @@ get_message_queue__LD(term_t t, message_queue **queue ARG_LD)
 }
 
 
+/* Get a message queue for lock-free sending.  The queue is not locked,
+   but queue->senders is incremented, which prevents releasing the queue.
+   The caller must decrement queue->senders when done.
+*/
+
+static int
+get_message_queue_unlocked_ref__LD(term_t t, message_queue **queue ARG_LD)
+{ message_queue *q;
+  PL_blob_t *type;
+  void *data;
+
+  if ( PL_get_blob(t, &data, NULL, &type) && type == &message_queue_blob )
+  { mqref *ref = data;
+
+    q = ref->queue;
+    ATOMIC_INC(&q->senders);
+  } else
+  { int rc;
+
+    PL_LOCK(L_THREAD);
+    if ( (rc = get_message_queue_unlocked__LD(t, &q PASS_LD)) )
+      ATOMIC_INC(&q->senders);
+    PL_UNLOCK(L_THREAD);
+    if ( !rc )
+      return FALSE;
+  }
+
+  if ( q->destroyed )
+  { ATOMIC_DEC(&q->senders);
+    return PL_error(NULL, 0, NULL, ERR_EXISTENCE, ATOM_message_queue, t);
+  }
+
+  *queue = q;
+  return TRUE;
+}
+
+
 /* Release a message queue, deleting it if it is no longer needed
 */
 
@@ -4751,7 +5542,10 @@ release_message_queue(message_queue *queue)
   simpleMutexUnlock(&queue->mutex);
 
   if ( del )
-  { destroy_message_queue(queue);
+  { MemoryBarrier();
+    while ( queue->senders )		/* see push_messages() */
+      Pause(0.0001);
+    destroy_message_queue(queue);
     if ( !queue->anonymous )
       PL_free(queue);
   }
@@ -4823,11 +5617,7 @@ PRED_IMPL("message_queue_destroy", 1, message_queue_destroy, 0)
     PL_unregister_atom(q->id);
 
   q->destroyed = TRUE;
-
-  if ( q->waiting )
-    cv_broadcast(&q->cond_var);
-  if ( q->wait_for_drain )
-    cv_broadcast(&q->drain_var);
+  wakeup_all(q);
 
   release_message_queue(q);
 
@@ -5097,6 +5887,74 @@ PRED_IMPL("thread_get_message", 3, thread_get_message, 0)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+thread_get_messages(+Queue, -List, +Max)
+thread_get_messages(+Queue, -List, +Max, +Options)
+    Wait for messages on Queue and unify List with at most Max of them.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+thread_get_messages__LD(term_t queue, term_t list, term_t tmax,
+			struct timespec *deadline ARG_LD)
+{ size_t max;
+  int rc;
+
+  if ( !PL_get_size_ex(tmax, &max) )
+    return FALSE;
+  if ( max == 0 )
+    return PL_error(NULL, 0, NULL, ERR_DOMAIN, ATOM_not_less_than_one, tmax);
+
+  for(;;)
+  { message_queue *q;
+
+    if ( !get_message_queue__LD(queue, &q PASS_LD) )
+      return FALSE;
+
+    rc = get_messages(q, list, max, deadline PASS_LD);
+    release_message_queue(q);
+
+    switch(rc)
+    { case MSG_WAIT_INTR:
+	if ( PL_handle_signals() >= 0 )
+	  continue;
+	rc = FALSE;
+	break;
+      case MSG_WAIT_DESTROYED:
+	rc = PL_error(NULL, 0, NULL, ERR_EXISTENCE, ATOM_message_queue, queue);
+        break;
+      case MSG_WAIT_TIMEOUT:
+	rc = FALSE;
+        break;
+      default:
+	;
+    }
+
+    break;
+  }
+
+  return rc;
+}
+
+
+static
+PRED_IMPL("thread_get_messages", 3, thread_get_messages, 0)
+{ PRED_LD
+
+  return thread_get_messages__LD(A1, A2, A3, NULL PASS_LD);
+}
+
+
+static
+PRED_IMPL("thread_get_messages", 4, thread_get_messages, 0)
+{ PRED_LD
+  struct timespec deadline;
+  struct timespec *dlop=NULL;
+
+  return process_deadline_options(A4,&deadline,&dlop)
+    &&   thread_get_messages__LD(A1, A2, A3, dlop PASS_LD);
+}
+
+
 static
 PRED_IMPL("thread_peek_message", 2, thread_peek_message_2, 0)
 { PRED_LD
@@ -5335,6 +6193,8 @@ PL_thread_attach_engine(PL_thread_attr_t *attr)
   if ( attr )
   { if ( attr->stack_limit )
       info->stack_limit = attr->stack_limit;
+    if ( (attr->flags & PL_THREAD_SMALL_STACKS) )
+      info->small_stacks = TRUE;
 
     info->cancel = attr->cancel;
   }
@@ -6203,6 +7063,7 @@ forThreadLocalDataUnsuspended(void (*func)(PL_local_data_t *), unsigned flags)
 	{ simpleMutexLock(&ld->thread.scan_lock);
 	  (*func)(ld);
 	  simpleMutexUnlock(&ld->thread.scan_lock);
+	  release_ldata(ld);
 	}
       }
     }
@@ -6235,6 +7096,9 @@ markAtomsMessageQueue(message_queue *queue)
   for(msg=queue->head; msg; msg=msg->next)
   { markAtomsRecord(msg->message);
   }
+  for(msg=queue->pending; msg; msg=msg->next)
+  { markAtomsRecord(msg->message);
+  }
   simpleMutexUnlock(&queue->gc_mutex);
 }
 
@@ -6677,6 +7541,28 @@ pl_kvs_in_use(KVS kvs)
 }
 
 
+		 /*******************************
+		 *   SHARED MAP RECORD IN USE   *
+		 *******************************/
+
+int
+pl_record_in_use(Record r)
+{
+#ifdef O_PLMT
+  int i;
+
+  for(i=1; i<=thread_highest_id; i++)
+  { PL_thread_info_t *info = GD->thread.threads[i];
+    if ( info && info->access.record == r )
+    { return TRUE;
+    }
+  }
+#endif
+
+  return FALSE;
+}
+
+
 		 /*******************************
 		 *      ATOM-TABLE IN USE       *
 		 *******************************/
@@ -6722,6 +7608,10 @@ static int
 ldata_in_use(PL_local_data_t *ld)
 { int i;
 
+  MemoryBarrier();
+  if ( GD->thread.ldata_access == 0 )
+    return FALSE;
+
   for(i=1; i<=thread_highest_id; i++)
   { PL_thread_info_t *info = GD->thread.threads[i];
     if ( info && info->access.ldata == ld )
@@ -7045,6 +7935,9 @@ BeginPredDefs(thread)
   PRED_DEF("thread_get_message",     1,	thread_get_message,    PL_FA_ISO)
   PRED_DEF("thread_get_message",     2,	thread_get_message,    PL_FA_ISO)
   PRED_DEF("thread_get_message",     3,	thread_get_message,    PL_FA_ISO)
+  PRED_DEF("thread_send_messages",   2,	thread_send_messages,  0)
+  PRED_DEF("thread_get_messages",    3,	thread_get_messages,   0)
+  PRED_DEF("thread_get_messages",    4,	thread_get_messages,   0)
   PRED_DEF("thread_peek_message",    1,	thread_peek_message_1, PL_FA_ISO)
   PRED_DEF("thread_peek_message",    2,	thread_peek_message_2, PL_FA_ISO)
   PRED_DEF("message_queue_destroy",  1,	message_queue_destroy, PL_FA_ISO)
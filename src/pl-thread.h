@@ -99,6 +99,8 @@ typedef struct _PL_thread_info_t
   unsigned	    in_exit_hooks : 1;	/* TRUE: running exit hooks */
   unsigned	    has_tid       : 1;	/* TRUE: tid = valid */
   unsigned	    is_engine	  : 1;	/* TRUE: created as engine */
+  unsigned	    small_stacks  : 1;	/* TRUE: minimal initial stacks */
+  int		    numa_node;		/* Bound NUMA node (-1: none) */
   thread_status	    status;		/* PL_THREAD_* */
   pthread_t	    tid;		/* Thread identifier */
 #ifdef __linux__
@@ -121,6 +123,7 @@ typedef struct _PL_thread_info_t
     Atom *	    atom_bucket;	/* current atom bucket-list accessed */
     FunctorTable    functor_table;	/* current atom-table accessed */
     Definition	    predicate;		/* current predicate walked */
+    Record	    record;		/* current shared_map value read */
     struct PL_local_data *ldata;	/* current ldata accessed */
   } access;
 } PL_thread_info_t;
@@ -161,6 +164,7 @@ typedef struct message_queue
 #endif
   struct thread_message   *head;	/* Head of message queue */
   struct thread_message   *tail;	/* Tail of message queue */
+  struct thread_message   *pending;	/* Lock-free sent messages (LIFO) */
   uint64_t	       sequence_next;	/* next for sequence id */
   word		       id;		/* Id of the queue */
   size_t	       size;		/* # terms in queue */
@@ -168,6 +172,8 @@ typedef struct message_queue
   int		       waiting;		/* # waiting threads */
   int		       waiting_var;	/* # waiting with unbound */
   int		       wait_for_drain;	/* # threads waiting for write */
+  int		       senders;		/* # active lock-free senders */
+  unsigned int	       wakeup;		/* Futex for waiting with unbound */
   unsigned	anonymous : 1;		/* <message_queue>(0x...) */
   unsigned	initialized : 1;	/* Queue is initialised */
   unsigned	destroyed : 1;		/* Thread is being destroyed */
@@ -182,6 +188,7 @@ typedef struct pl_mutex
   int count;				/* lock count */
   int owner;				/* integer id of owner */
   atom_t id;				/* id of the mutex */
+  lock_profile profile;			/* Timing (flag lock_profile) */
   unsigned anonymous    : 1;		/* <mutex>(0x...) */
   unsigned initialized  : 1;		/* Mutex is initialized */
   unsigned destroyed    : 1;		/* Mutex is destroyed */
@@ -189,8 +196,10 @@ typedef struct pl_mutex
 } pl_mutex;
 
 #define PL_THREAD_MAGIC 0x2737234f
+#define THREAD_CACHE_SIZE 4		/* default for flag thread_cache_size */
 
 extern counting_mutex _PL_mutexes[];	/* Prolog mutexes */
+extern int _PL_lock_profile;		/* Flag lock_profile */
 
 #define L_MISC		0
 #define L_ALLOC		1
@@ -234,11 +243,35 @@ compile-time
 
 #define IF_MT(id, g) if ( id == L_THREAD || GD->thread.enabled ) g
 
+COMMON(uint64_t)	lockProfileClock(void);
+COMMON(void)	lockProfileAcquired(lock_profile *p,
+				    uint64_t t0, int contended);
+COMMON(void)	lockProfileReleased(lock_profile *p);
+COMMON(int)	setLockProfile(int64_t every);
+
+#define lockProfileSample(p, every) \
+	((p)->acquired % (unsigned)(every) == 0)
+
 static inline void
 countingMutexLock(counting_mutex *cm)
 {
 #if O_CONTENTION_STATISTICS
-  if ( !simpleMutexTryLock(&cm->mutex) )
+  int every = _PL_lock_profile;
+
+  if ( unlikely(every) )
+  { uint64_t t0 = 0;
+    int contended = FALSE;
+
+    if ( lockProfileSample(&cm->profile, every) )
+      t0 = lockProfileClock();
+
+    if ( !simpleMutexTryLock(&cm->mutex) )
+    { cm->collisions++;
+      contended = TRUE;
+      simpleMutexLock(&cm->mutex);
+    }
+    lockProfileAcquired(&cm->profile, t0, contended);
+  } else if ( !simpleMutexTryLock(&cm->mutex) )
   { cm->collisions++;
     simpleMutexLock(&cm->mutex);
   }
@@ -254,6 +287,10 @@ static inline void
 countingMutexUnlock(counting_mutex *cm)
 { assert(cm->lock_count > 0);
   cm->lock_count--;
+#if O_CONTENTION_STATISTICS
+  if ( unlikely(cm->profile.hold_start) )
+    lockProfileReleased(&cm->profile);
+#endif
   simpleMutexUnlock(&cm->mutex);
 }
 
@@ -377,6 +414,7 @@ int			PL_mutex_lock(struct pl_mutex *m);
 int			PL_mutex_unlock(struct pl_mutex *m);
 int			PL_thread_raise(int tid, int sig);
 COMMON(void)		cleanupThreads(void);
+COMMON(int)		set_thread_cache_size(int64_t size);
 COMMON(intptr_t)	system_thread_id(PL_thread_info_t *info);
 COMMON(double)	        ThreadCPUTime(PL_local_data_t *ld, int which);
 COMMON(void)		get_current_timespec(struct timespec *time);
@@ -394,7 +432,7 @@ COMMON(void)	markAtomsMessageQueues(void);
 COMMON(void)	markAtomsThreadMessageQueue(PL_local_data_t *ld);
 
 #define acquire_ldata(info)	acquire_ldata__LD(info PASS_LD)
-#define release_ldata(ld)	(LD->thread.info->access.ldata = NULL)
+#define release_ldata(ld)	release_ldata__LD(ld PASS_LD)
 
 #else /*O_PLMT, end of threading-stuff */
 
@@ -449,6 +487,7 @@ COMMON(Atom**)	pl_atom_buckets_in_use(void);
 COMMON(Definition*)	predicates_in_use(void);
 COMMON(int)	pl_functor_table_in_use(FunctorTable functor_table);
 COMMON(int)	pl_kvs_in_use(KVS kvs);
+COMMON(int)	pl_record_in_use(Record r);
 COMMON(void)	cgcActivatePredicate__LD(Definition def, gen_t gen ARG_LD);
 COMMON(gen_t)	pushPredicateAccess__LD(Definition def ARG_LD);
 COMMON(void)	popPredicateAccess__LD(Definition def ARG_LD);
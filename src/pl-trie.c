@@ -35,7 +35,17 @@
 
 #include "pl-incl.h"
 #include "pl-trie.h"
+#include "pl-tabling.h"
 #include "pl-indirect.h"
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #define AC_TERM_WALK_POP 1
 #include "pl-termwalk.c"
 
@@ -86,6 +96,9 @@ static void	trie_destroy(trie *trie);
 static int	unify_key(ukey_state *state, word key ARG_LD);
 static void	init_ukey_state(ukey_state *state, trie *trie, Word p);
 static void	destroy_ukey_state(ukey_state *state);
+static int	build_trie_image(trie *trie, TmpBuffer img ARG_LD);
+static trie *	load_trie_image(IOSTREAM *in);
+static void	free_trie_image(struct trie_image *img);
 
 
 		 /*******************************
@@ -123,18 +136,43 @@ release_trie_ref(atom_t aref)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Tries are saved as 'T' followed by  their image (see build_trie_image()).
+When loaded, the image is read into memory   and the trie is read-only,
+just as if it was loaded using trie_load/2.  If the trie cannot be saved
+we write '-' and the trie is restored as a dummy blob.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
 static int
 save_trie(atom_t aref, IOSTREAM *fd)
-{ tref *ref = PL_blob_data(aref, NULL, NULL);
-  (void)fd;
+{ GET_LD
+  tref *ref = PL_blob_data(aref, NULL, NULL);
+
+  if ( ref->trie->magic == TRIE_MAGIC )
+  { tmp_buffer img;
+    int rc;
+
+    initBuffer(&img);
+    if ( (rc=build_trie_image(ref->trie, &img PASS_LD)) )
+    { Sputc('T', fd);
+      Sfwrite(img.base, 1, sizeOfBuffer(&img), fd);
+    }
+    discardBuffer(&img);
+    if ( rc )
+      return TRUE;
+  }
 
+  Sputc('-', fd);
   return PL_warning("Cannot save reference to <trie>(%p)", ref->trie);
 }
 
 
 static atom_t
 load_trie(IOSTREAM *fd)
-{ (void)fd;
+{ trie *trie;
+
+  if ( Sgetc(fd) == 'T' && (trie=load_trie_image(fd)) )
+    return trie_symbol(trie);
 
   return PL_new_atom("<saved-trie-ref>");
 }
@@ -196,6 +234,8 @@ static void
 trie_destroy(trie *trie)
 { DEBUG(MSG_TRIE_GC, Sdprintf("Destroying trie %p\n", trie));
   trie_empty(trie);
+  if ( trie->image )
+    free_trie_image(trie->image);
   PL_free(trie);
 }
 
@@ -247,7 +287,8 @@ new_trie_node(trie *trie, word key)
 { trie_node *n;
 
   if ( trie->alloc_pool )
-  { if ( trie->alloc_pool->size+sizeof(trie_node) <= trie->alloc_pool->limit )
+  { if ( trie->alloc_pool->size+sizeof(trie_node) <= trie->alloc_pool->limit ||
+	 tbl_reclaim_space(trie, sizeof(trie_node)) )
     { ATOMIC_ADD(&trie->alloc_pool->size, sizeof(trie_node));
     } else
     { PL_resource_error("table_space");
@@ -283,15 +324,18 @@ next:
     release_value(n->value);
 
   if ( children.any &&
-       COMPARE_AND_SWAP(&n->children.any, children.any, NULL) )
-  { if ( dealloc )
-    { ATOMIC_DEC(&trie->node_count);
-      if ( trie->alloc_pool )
-	ATOMIC_SUB(&trie->alloc_pool->size, sizeof(trie_node));
-      PL_free(n);
-    }
+       !COMPARE_AND_SWAP(&n->children.any, children.any, NULL) )
+    return;				/* cleared concurrently */
+
+  if ( dealloc )
+  { ATOMIC_DEC(&trie->node_count);
+    if ( trie->alloc_pool )
+      ATOMIC_SUB(&trie->alloc_pool->size, sizeof(trie_node));
+    PL_free(n);
+  }
 
-    switch( children.any->type )
+  if ( children.any )
+  { switch( children.any->type )
     { case TN_KEY:
       { n = children.key->child;
         PL_free(children.key);
@@ -662,14 +706,6 @@ out:
 }
 
 
-typedef struct trie_stats
-{ size_t bytes;
-  size_t nodes;
-  size_t hashes;
-  size_t values;
-} trie_stats;
-
-
 static void
 stat_node(trie_node *n, trie_stats *stats)
 { trie_children children = n->children;
@@ -705,7 +741,7 @@ stat_node(trie_node *n, trie_stats *stats)
 }
 
 
-static void
+void
 stat_trie(trie *t, trie_stats *stats)
 { stats->bytes  = sizeof(*t) - sizeof(t->root);
   stats->nodes  = 0;
@@ -720,6 +756,778 @@ stat_trie(trie *t, trie_stats *stats)
 
 
 
+		 /*******************************
+		 *	     TRIE IMAGES	*
+		 *******************************/
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+A trie image is a compact and  position   independent  copy of a trie. An
+image can be mapped into memory  and   used  read-only by trie_lookup/3
+and trie_gen/3 without creating trie nodes.  The image consists of
+
+  - A header (trie_image_header)
+  - An array of nodes (timg_node).  Nodes are stored breadth-first,
+    such that the children of a node form a contiguous slice that is
+    ordered by the encoded key.  Node 0 is the root.
+  - An array of offsets into the data area for the constants, i.e.,
+    the atoms, functors and indirect data (strings, floats, big
+    integers) that appear as keys or values.
+  - The data area holding the constants and non-atomic values as
+    external records (see PL_record_external()).  Each record is
+    preceded by its length and padded to a multiple of 8 bytes.
+
+Keys and values are encoded as 64-bit integers  where the low 3 bits hold
+the type (TIMG_*). Loading an image only creates the constants. A hash
+table maps the runtime constants back to  their index such that a term
+can be translated into a sequence of encoded keys.
+
+The image uses the byte order of the  machine that created it. Loading
+an image with a different byte order fails on the magic code.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define TRIE_IMAGE_MAGIC	0x54726965	/* "Trie" */
+#define TRIE_IMAGE_VERSION	1
+
+#define TIMG_VAR		0x1		/* Variable <n> */
+#define TIMG_INT		0x2		/* Tagged integer */
+#define TIMG_CONST		0x3		/* Index in constant table */
+#define TIMG_RECORD		0x4		/* Offset of a record (values) */
+#define TIMG_POP		0x5		/* End of compound */
+
+#define TIMG_TAG(k)		((unsigned int)((k)&0x7))
+#define TIMG_VAL(k)		((k)>>3)
+#define TIMG_INTVAL(k)		((int64_t)(k)>>3)
+#define TIMG_MK(v, t)		(((uint64_t)(v)<<3)|(t))
+
+typedef struct trie_image_header
+{ uint32_t	magic;			/* TRIE_IMAGE_MAGIC */
+  uint32_t	version;		/* TRIE_IMAGE_VERSION */
+  uint64_t	size;			/* Total size in bytes */
+  uint64_t	node_count;		/* # nodes */
+  uint64_t	value_count;		/* # nodes with a value */
+  uint64_t	const_count;		/* # constants */
+  uint64_t	consts;			/* Offset of constant offsets */
+  uint64_t	data;			/* Offset of the data area */
+} trie_image_header;
+
+typedef struct timg_node
+{ uint64_t	key;			/* Encoded key */
+  uint64_t	value;			/* Encoded value or 0 */
+  uint32_t	children;		/* Index of first child */
+  uint32_t	child_count;		/* # children */
+} timg_node;
+
+typedef struct trie_image
+{ char	       *base;			/* Start of the image */
+  size_t	size;			/* Size of the image */
+  int		mapped;			/* base is mmap()ed */
+  const trie_image_header *header;	/* The header */
+  const timg_node *nodes;		/* The node array */
+  word	       *consts;			/* Runtime constants */
+  Table		const_index;		/* Runtime constant -> index+1 */
+} trie_image;
+
+typedef struct timg_builder
+{ tmp_buffer	nodes;			/* timg_node */
+  tmp_buffer	queue;			/* trie_node* (breadth-first) */
+  tmp_buffer	consts;			/* word: runtime constants */
+  tmp_buffer	data;			/* data area */
+  Table		const_index;		/* runtime constant -> index+1 */
+  uint64_t	value_count;		/* # values */
+} timg_builder;
+
+typedef struct timg_child
+{ uint64_t	key;			/* Encoded key */
+  trie_node    *node;			/* Node in the trie */
+} timg_child;
+
+
+static uint64_t
+timg_const(timg_builder *b, word w)
+{ GET_LD
+  void *idx;
+
+  if ( !(idx=lookupHTable(b->const_index, (void*)w)) )
+  { idx = (void*)(entriesBuffer(&b->consts, word)+1);
+    addBuffer(&b->consts, w, word);
+    addNewHTable(b->const_index, (void*)w, idx);
+  }
+
+  return TIMG_MK((uintptr_t)idx-1, TIMG_CONST);
+}
+
+
+static uint64_t
+timg_key(timg_builder *b, word key)
+{ if ( key == TRIE_KEY_POP )
+    return TIMG_POP;
+  if ( tag(key) == TAG_VAR )
+    return TIMG_MK(key>>LMASK_BITS, TIMG_VAR);
+  if ( isTaggedInt(key) )
+    return TIMG_MK((int64_t)valInt(key), TIMG_INT);
+
+  return timg_const(b, key);
+}
+
+
+static int
+timg_add_record(timg_builder *b, term_t t, uint64_t *offset)
+{ static const char zeros[8] = {0};
+  char *rec;
+  size_t len;
+
+  if ( (rec=PL_record_external(t, &len)) )
+  { uint64_t l = len;
+
+    *offset = sizeOfBuffer(&b->data);
+    addMultipleBuffer(&b->data, &l, sizeof(l), char);
+    addMultipleBuffer(&b->data, rec, len, char);
+    addMultipleBuffer(&b->data, zeros, (8-len%8)%8, char);
+    PL_erase_external(rec);
+
+    return TRUE;
+  }
+
+  if ( !PL_exception(0) )
+    return PL_permission_error("save", "term", t);
+  return FALSE;
+}
+
+
+static int
+timg_value(timg_builder *b, word value, uint64_t *v ARG_LD)
+{ if ( !value )
+  { *v = 0;
+    return TRUE;
+  }
+
+  if ( isTaggedInt(value) )
+  { *v = TIMG_MK((int64_t)valInt(value), TIMG_INT);
+  } else if ( isAtom(value) )
+  { *v = timg_const(b, value);
+  } else
+  { term_t t = PL_new_term_ref();
+    uint64_t offset;
+    int rc;
+
+    rc = ( PL_recorded((record_t)value, t) &&
+	   timg_add_record(b, t, &offset) );
+    PL_reset_term_refs(t);
+    if ( !rc )
+      return FALSE;
+    *v = TIMG_MK(offset, TIMG_RECORD);
+  }
+
+  b->value_count++;
+  return TRUE;
+}
+
+
+static int
+put_trie_const(trie *trie, term_t t, word w ARG_LD)
+{ if ( tagex(w) == (TAG_ATOM|STG_GLOBAL) )
+  { PL_put_variable(t);
+    return PL_unify_compound(t, w);
+  }
+  if ( isAtom(w) )
+    return PL_put_atom(t, w);
+
+  for(;;)
+  { word gw;
+
+    if ( (gw = extern_indirect_no_shift(trie->indirects, w PASS_LD)) )
+    { *valTermRef(t) = gw;
+      return TRUE;
+    }
+    if ( !makeMoreStackSpace(GLOBAL_OVERFLOW, ALLOW_GC|ALLOW_SHIFT) )
+      return FALSE;
+  }
+}
+
+
+static int
+compare_timg_child(const void *p1, const void *p2)
+{ const timg_child *c1 = p1;
+  const timg_child *c2 = p2;
+
+  return c1->key < c2->key ? -1 : c1->key > c2->key ? 1 : 0;
+}
+
+
+static int
+add_timg_children(timg_builder *b, size_t i, uint64_t value,
+		  TmpBuffer children)
+{ size_t count = entriesBuffer(children, timg_child);
+  size_t first = entriesBuffer(&b->nodes, timg_node);
+  timg_child *c = baseBuffer(children, timg_child);
+  timg_node *tn;
+  size_t j;
+
+  if ( first+count > UINT32_MAX )
+    return PL_representation_error("trie_image_size");
+
+  qsort(c, count, sizeof(*c), compare_timg_child);
+  tn = baseBuffer(&b->nodes, timg_node)+i;
+  tn->value       = value;
+  tn->children    = (uint32_t)first;
+  tn->child_count = (uint32_t)count;
+
+  for(j=0; j<count; j++)
+  { timg_node n = { c[j].key, 0, 0, 0 };
+
+    addBuffer(&b->nodes, n, timg_node);
+    addBuffer(&b->queue, c[j].node, trie_node*);
+  }
+
+  return TRUE;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+build_trie_image() creates the image for trie  in img. Tries that were
+loaded from an image are simply copied.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+build_trie_image(trie *trie, TmpBuffer img ARG_LD)
+{ timg_builder b;
+  tmp_buffer children;
+  trie_image_header hdr;
+  trie_node *root = &trie->root;
+  timg_node tn0 = {0};
+  size_t i, const_count;
+  int rc = TRUE;
+
+  if ( trie->image )
+  { addMultipleBuffer(img, trie->image->base, trie->image->size, char);
+    return TRUE;
+  }
+
+  initBuffer(&b.nodes);
+  initBuffer(&b.queue);
+  initBuffer(&b.consts);
+  initBuffer(&b.data);
+  initBuffer(&children);
+  b.const_index = newHTable(64);
+  b.value_count = 0;
+
+  acquire_trie(trie);
+  addBuffer(&b.nodes, tn0, timg_node);
+  addBuffer(&b.queue, root, trie_node*);
+  for(i=0; rc && i < entriesBuffer(&b.queue, trie_node*); i++)
+  { trie_node *n = fetchBuffer(&b.queue, i, trie_node*);
+    trie_children ch = n->children;
+    uint64_t value;
+
+    if ( !(rc=timg_value(&b, n->value, &value PASS_LD)) )
+      break;
+
+    emptyBuffer(&children);
+    if ( ch.any )
+    { switch( ch.any->type )
+      { case TN_KEY:
+	{ timg_child c;
+
+	  c.key  = timg_key(&b, ch.key->key);
+	  c.node = ch.key->child;
+	  addBuffer(&children, c, timg_child);
+	  break;
+	}
+	case TN_HASHED:
+	{ TableEnum e = newTableEnum(ch.hash->table);
+	  void *k, *v;
+
+	  while( advanceTableEnum(e, &k, &v) )
+	  { timg_child c;
+
+	    c.key  = timg_key(&b, (word)k);
+	    c.node = v;
+	    addBuffer(&children, c, timg_child);
+	  }
+	  freeTableEnum(e);
+	  break;
+	}
+	default:
+	  assert(0);
+      }
+    }
+
+    rc = add_timg_children(&b, i, value, &children);
+  }
+
+  const_count = entriesBuffer(&b.consts, word);
+  if ( rc )
+  { term_t t = PL_new_term_ref();
+    fid_t fid;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic       = TRIE_IMAGE_MAGIC;
+    hdr.version     = TRIE_IMAGE_VERSION;
+    hdr.node_count  = entriesBuffer(&b.nodes, timg_node);
+    hdr.value_count = b.value_count;
+    hdr.const_count = const_count;
+    hdr.consts      = sizeof(hdr) + sizeOfBuffer(&b.nodes);
+    hdr.data        = hdr.consts + const_count*sizeof(uint64_t);
+
+    emptyBuffer(img);
+    addMultipleBuffer(img, &hdr, sizeof(hdr), char);
+    addMultipleBuffer(img, b.nodes.base, sizeOfBuffer(&b.nodes), char);
+    if ( !allocFromBuffer(img, const_count*sizeof(uint64_t)) ||
+	 !(fid = PL_open_foreign_frame()) )
+    { fid = 0;
+      rc = FALSE;
+    }
+    for(i=0; rc && i<const_count; i++)
+    { uint64_t offset;
+
+      if ( (rc = ( put_trie_const(trie, t, fetchBuffer(&b.consts, i, word)
+				  PASS_LD) &&
+		   timg_add_record(&b, t, &offset) )) )
+      { uint64_t *offsets = (uint64_t*)(img->base+hdr.consts);
+
+	offsets[i] = offset;
+      }
+      PL_rewind_foreign_frame(fid);
+    }
+    if ( fid )
+      PL_close_foreign_frame(fid);
+
+    if ( rc )
+    { addMultipleBuffer(img, b.data.base, sizeOfBuffer(&b.data), char);
+      ((trie_image_header*)img->base)->size = sizeOfBuffer(img);
+    }
+  }
+  release_trie(trie);
+
+  destroyHTable(b.const_index);
+  discardBuffer(&children);
+  discardBuffer(&b.nodes);
+  discardBuffer(&b.queue);
+  discardBuffer(&b.consts);
+  discardBuffer(&b.data);
+
+  return rc;
+}
+
+
+static const char *
+image_record(const trie_image *img, uint64_t offset)
+{ return img->base + img->header->data + offset + sizeof(uint64_t);
+}
+
+
+static void
+free_trie_image(trie_image *img)
+{ if ( img->consts )
+  { size_t i;
+
+    for(i=0; i<img->header->const_count; i++)
+    { if ( isAtom(img->consts[i]) )
+	PL_unregister_atom(img->consts[i]);
+    }
+    PL_free(img->consts);
+  }
+  if ( img->const_index )
+    destroyHTable(img->const_index);
+
+#ifdef HAVE_MMAP
+  if ( img->mapped )
+    munmap(img->base, img->size);
+  else
+#endif
+    PL_free(img->base);
+
+  PL_free(img);
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+valid_image_nodes() verifies the node  array   of  an image whose header
+has been validated, such that the image functions need no bounds checks:
+children of a node follow the node and   are inside the node array, keys
+and values are well formed, constants are  inside the constant table and
+records are inside the data area.  As children follow their parent, the
+image is a tree.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+valid_image_record(const trie_image_header *hdr, const char *base,
+		   uint64_t offset)
+{ uint64_t avail = hdr->size - hdr->data;
+  uint64_t len;
+
+  if ( offset%sizeof(uint64_t) != 0 ||
+       offset > avail || avail-offset < sizeof(uint64_t) )
+    return FALSE;
+  memcpy(&len, base+hdr->data+offset, sizeof(len));
+
+  return len > 0 && len <= avail-offset-sizeof(uint64_t);
+}
+
+
+static int
+valid_image_nodes(const trie_image_header *hdr, const char *base)
+{ const timg_node *nodes = (const timg_node*)(base+sizeof(*hdr));
+  const uint64_t *offsets = (const uint64_t*)(base+hdr->consts);
+  uint64_t i, values = 0;
+
+  for(i=0; i<hdr->const_count; i++)
+  { if ( !valid_image_record(hdr, base, offsets[i]) )
+      return FALSE;
+  }
+
+  for(i=0; i<hdr->node_count; i++)
+  { const timg_node *n = &nodes[i];
+
+    if ( n->child_count > 0 &&
+	 ( n->children <= i ||
+	   (uint64_t)n->children + n->child_count > hdr->node_count ) )
+      return FALSE;
+
+    if ( i > 0 )			/* the root has no key */
+    { switch( TIMG_TAG(n->key) )
+      { case TIMG_VAR:
+	case TIMG_INT:
+	  break;
+	case TIMG_CONST:
+	  if ( TIMG_VAL(n->key) >= hdr->const_count )
+	    return FALSE;
+	  break;
+	case TIMG_POP:
+	  if ( TIMG_VAL(n->key) != 0 )
+	    return FALSE;
+	  break;
+	default:
+	  return FALSE;
+      }
+    }
+
+    if ( n->value )
+    { switch( TIMG_TAG(n->value) )
+      { case TIMG_INT:
+	  break;
+	case TIMG_CONST:
+	  if ( TIMG_VAL(n->value) >= hdr->const_count )
+	    return FALSE;
+	  break;
+	case TIMG_RECORD:
+	  if ( !valid_image_record(hdr, base, TIMG_VAL(n->value)) )
+	    return FALSE;
+	  break;
+	default:
+	  return FALSE;
+      }
+      values++;
+    }
+  }
+
+  return values == hdr->value_count;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+attach_trie_image() validates the image  at   base  and makes it the
+content of trie. On success, the  image   is  owned by the trie. Returns
+FALSE without an exception if the image is not valid.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+attach_trie_image(trie *trie, char *base, size_t size, int mapped)
+{ GET_LD
+  const trie_image_header *hdr = (const trie_image_header*)base;
+  const uint64_t *offsets;
+  trie_image *img;
+  term_t t;
+  fid_t fid;
+  size_t i;
+
+  if ( size < sizeof(*hdr) ||
+       hdr->magic != TRIE_IMAGE_MAGIC ||
+       hdr->version != TRIE_IMAGE_VERSION ||
+       hdr->size != size ||
+       hdr->node_count == 0 ||
+       hdr->node_count > size/sizeof(timg_node) ||
+       hdr->const_count > size/sizeof(uint64_t) ||
+       hdr->consts != sizeof(*hdr) + hdr->node_count*sizeof(timg_node) ||
+       hdr->data != hdr->consts + hdr->const_count*sizeof(uint64_t) ||
+       hdr->data > size ||
+       !valid_image_nodes(hdr, base) )
+    return FALSE;
+
+  if ( !(img = PL_malloc(sizeof(*img))) )
+    return PL_resource_error("memory");
+  memset(img, 0, sizeof(*img));
+  img->base   = base;
+  img->size   = size;
+  img->mapped = mapped;
+  img->header = hdr;
+  img->nodes  = (const timg_node*)(base+sizeof(*hdr));
+  img->const_index = newHTable(64);
+  if ( !(img->consts = PL_malloc(sizeof(word)*(hdr->const_count+1))) )
+  { PL_free(img);
+    return PL_resource_error("memory");
+  }
+  memset(img->consts, 0, sizeof(word)*hdr->const_count);
+
+  offsets = (const uint64_t*)(base+hdr->consts);
+  if ( !(fid = PL_open_foreign_frame()) )
+    goto error;
+  t = PL_new_term_ref();
+  for(i=0; i<hdr->const_count; i++)
+  { atom_t a;
+    functor_t f;
+    word w;
+
+    if ( !PL_recorded_external(image_record(img, offsets[i]), t) )
+      goto error;
+
+    if ( PL_is_compound(t) && PL_get_functor(t, &f) )
+    { w = f;
+    } else if ( PL_get_atom(t, &a) )
+    { PL_register_atom(a);
+      w = a;
+    } else
+    { Word p = valTermRef(t);
+
+      deRef(p);
+      if ( !(w = trie_intern_indirect(trie, *p, TRUE PASS_LD)) )
+	goto error;
+    }
+
+    img->consts[i] = w;
+    addNewHTable(img->const_index, (void*)w, (void*)(i+1));
+    PL_rewind_foreign_frame(fid);
+  }
+  PL_close_foreign_frame(fid);
+
+  trie->image = img;
+  return TRUE;
+
+error:
+  if ( fid )
+    PL_close_foreign_frame(fid);
+  img->mapped = FALSE;
+  img->base = NULL;			/* owned by the caller */
+  free_trie_image(img);
+  return FALSE;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+load_trie_image() reads an image from a   stream. This is used to load
+tries from saved states and if the system does not support mmap().
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static trie *
+load_trie_image(IOSTREAM *in)
+{ trie_image_header hdr;
+  char *base;
+  trie *trie;
+
+  if ( Sfread(&hdr, sizeof(hdr), 1, in) != 1 ||
+       hdr.magic != TRIE_IMAGE_MAGIC ||
+       hdr.size < sizeof(hdr) ||
+       !(base = PL_malloc_atomic(hdr.size)) )
+    return NULL;
+
+  memcpy(base, &hdr, sizeof(hdr));
+  if ( Sfread(base+sizeof(hdr), 1, hdr.size-sizeof(hdr), in) ==
+       hdr.size-sizeof(hdr) &&
+       (trie = trie_create()) )
+  { if ( attach_trie_image(trie, base, hdr.size, FALSE) )
+      return trie;
+    trie_destroy(trie);
+  }
+
+  PL_free(base);
+  return NULL;
+}
+
+
+static trie *
+map_trie_image(const char *file)
+{
+#ifdef HAVE_MMAP
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void *)-1)
+#endif
+  int fd;
+  struct stat buf;
+  char *base = MAP_FAILED;
+  trie *trie;
+
+  if ( (fd = open(file, O_RDONLY)) < 0 )
+    return NULL;
+  if ( fstat(fd, &buf) == 0 && buf.st_size > 0 )
+    base = mmap(NULL, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if ( base == MAP_FAILED )
+    return NULL;
+
+  if ( (trie = trie_create()) )
+  { if ( attach_trie_image(trie, base, buf.st_size, TRUE) )
+      return trie;
+    trie_destroy(trie);
+  }
+  munmap(base, buf.st_size);
+
+  return NULL;
+#else
+  IOSTREAM *in;
+  trie *trie = NULL;
+
+  if ( (in = Sopen_file(file, "rbr")) )
+  { trie = load_trie_image(in);
+    Sclose(in);
+  }
+
+  return trie;
+#endif
+}
+
+
+static const timg_node *
+image_child(const trie_image *img, const timg_node *n, uint64_t key)
+{ size_t lo = n->children;
+  size_t hi = lo + n->child_count;
+
+  while( lo < hi )
+  { size_t m = lo + (hi-lo)/2;
+    uint64_t mk = img->nodes[m].key;
+
+    if ( mk == key )
+      return &img->nodes[m];
+    if ( mk < key )
+      lo = m+1;
+    else
+      hi = m;
+  }
+
+  return NULL;
+}
+
+
+static const timg_node *
+image_const_child(const trie_image *img, const timg_node *n, word w ARG_LD)
+{ void *idx;
+
+  if ( (idx = lookupHTable(img->const_index, (void*)w)) )
+    return image_child(img, n, TIMG_MK((uintptr_t)idx-1, TIMG_CONST));
+
+  return NULL;
+}
+
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+image_lookup() is the read-only version of trie_lookup() for tries that
+are represented by an image.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int
+image_lookup(trie *trie, const timg_node **nodep, Word k ARG_LD)
+{ const trie_image *img = trie->image;
+  term_agenda_P agenda;
+  const timg_node *node = img->nodes;
+  size_t var_number = 0;
+  int rc = TRUE;
+
+  initTermAgenda_P(&agenda, 1, k);
+  while( node )
+  { Word p;
+    word w;
+
+    if ( !(p=nextTermAgenda_P(&agenda)) )
+      break;
+    if ( p == AC_TERM_POP )
+    { node = image_child(img, node, TIMG_POP);
+      continue;
+    }
+
+    w = *p;
+    switch( tag(w) )
+    { case TAG_VAR:
+	if ( isVar(w) )
+	  *p = w = ((((word)++var_number))<<LMASK_BITS)|TAG_VAR;
+	node = image_child(img, node, TIMG_MK(w>>LMASK_BITS, TIMG_VAR));
+	break;
+      case TAG_ATTVAR:
+	rc = TRIE_LOOKUP_CONTAINS_ATTVAR;
+	node = NULL;
+	break;
+      case TAG_COMPOUND:
+      { Functor f = valueTerm(w);
+	size_t arity = arityFunctor(f->definition);
+
+	node = image_const_child(img, node, f->definition PASS_LD);
+	pushWorkAgenda_P(&agenda, arity, f->arguments);
+	break;
+      }
+      default:
+      { if ( isTaggedInt(w) )
+	{ node = image_child(img, node, TIMG_MK((int64_t)valInt(w), TIMG_INT));
+	} else if ( isIndirect(w) )
+	{ word i = trie_intern_indirect(trie, w, FALSE PASS_LD);
+
+	  node = i ? image_const_child(img, node, i PASS_LD) : NULL;
+	} else
+	{ node = image_const_child(img, node, w PASS_LD);
+	}
+      }
+    }
+  }
+  clearTermAgenda_P(&agenda);
+  clear_vars(k, var_number PASS_LD);
+
+  if ( rc == TRUE )
+  { if ( node )
+      *nodep = node;
+    else
+      rc = FALSE;
+  }
+
+  return rc;
+}
+
+
+static word
+image_key(const trie_image *img, uint64_t key)
+{ switch( TIMG_TAG(key) )
+  { case TIMG_VAR:
+      return ((word)TIMG_VAL(key)<<LMASK_BITS)|TAG_VAR;
+    case TIMG_INT:
+      return consInt(TIMG_INTVAL(key));
+    case TIMG_CONST:
+      return img->consts[TIMG_VAL(key)];
+    case TIMG_POP:
+      return TRIE_KEY_POP;
+    default:
+      assert(0);
+      return 0;
+  }
+}
+
+
+static int
+image_unify_value(term_t t, const trie_image *img, uint64_t value ARG_LD)
+{ switch( TIMG_TAG(value) )
+  { case TIMG_INT:
+      return _PL_unify_atomic(t, consInt(TIMG_INTVAL(value)));
+    case TIMG_CONST:
+      return _PL_unify_atomic(t, img->consts[TIMG_VAL(value)]);
+    case TIMG_RECORD:
+    { term_t t2;
+
+      return ( (t2=PL_new_term_ref()) &&
+	       PL_recorded_external(image_record(img, TIMG_VAL(value)), t2) &&
+	       PL_unify(t, t2)
+	     );
+    }
+    default:
+      return FALSE;
+  }
+}
+
+
 		 /*******************************
 		 *	  PROLOG BINDING	*
 		 *******************************/
@@ -951,6 +1759,9 @@ trie_insert(term_t Trie, term_t Key, term_t Value, trie_node **nodep,
     trie_node *node;
     int rc;
 
+    if ( trie->image )
+      return PL_permission_error("modify", "trie", Trie);
+
     kp	= valTermRef(Key);
     val = intern_value(Value PASS_LD);
 
@@ -1057,6 +1868,9 @@ PRED_IMPL("trie_delete", 3, trie_delete, 0)
     trie_node *node;
     int rc;
 
+    if ( trie->image )
+      return PL_permission_error("modify", "trie", A1);
+
     kp = valTermRef(A2);
 
     if ( (rc=trie_lookup(trie, &node, kp, FALSE PASS_LD)) == TRUE )
@@ -1088,7 +1902,13 @@ PRED_IMPL("trie_lookup", 3, trie_lookup, 0)
 
     kp = valTermRef(A2);
 
-    if ( (rc=trie_lookup(trie, &node, kp, FALSE PASS_LD)) == TRUE )
+    if ( trie->image )
+    { const timg_node *inode;
+
+      if ( (rc=image_lookup(trie, &inode, kp PASS_LD)) == TRUE )
+	return ( inode->value &&
+		 image_unify_value(A3, trie->image, inode->value PASS_LD) );
+    } else if ( (rc=trie_lookup(trie, &node, kp, FALSE PASS_LD)) == TRUE )
     { if ( node->value )
 	return unify_value(A3, node->value PASS_LD);
       return FALSE;
@@ -1326,9 +2146,15 @@ typedef struct trie_choice
   trie_node *child;
 } trie_choice;
 
+typedef struct image_choice
+{ uint32_t node;			/* current node */
+  uint32_t end;				/* end of the siblings */
+} image_choice;
+
 typedef struct
 { trie        *trie;		/* trie we operate on */
   int	       allocated;
+  int	       image;		/* choicepoints are image_choice */
   tmp_buffer   choicepoints;	/* Stack of trie state choicepoints */
 } trie_gen_state;
 
@@ -1337,6 +2163,7 @@ static void
 init_trie_state(trie_gen_state *state, trie *trie)
 { state->trie = trie;
   state->allocated = FALSE;
+  state->image = (trie->image != NULL);
   initBuffer(&state->choicepoints);
 }
 
@@ -1350,9 +2177,11 @@ clear_trie_state(trie_gen_state *state)
 { trie_choice *chp = base_choice(state);
   trie_choice *top = top_choice(state);
 
-  for(; chp < top; chp++)
-  { if ( chp->choice.table )
-      freeTableEnum(chp->choice.table);
+  if ( !state->image )
+  { for(; chp < top; chp++)
+    { if ( chp->choice.table )
+	freeTableEnum(chp->choice.table);
+    }
   }
 
   discardBuffer(&state->choicepoints);
@@ -1448,6 +2277,95 @@ next_choice(trie_gen_state *state)
 }
 
 
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Enumerating a trie image uses the same  state, but the choicepoints are
+image_choice structures that hold the index  of the current node and the
+end of its siblings.
+- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static size_t
+image_add_choice(trie_gen_state *state, const timg_node *n)
+{ image_choice *ch = allocFromBuffer(&state->choicepoints, sizeof(*ch));
+
+  ch->node = n->children;
+  ch->end  = n->children + n->child_count;
+
+  return entriesBuffer(&state->choicepoints, image_choice)-1;
+}
+
+
+static int
+image_descent_node(trie_gen_state *state, size_t depth)
+{ const timg_node *nodes = state->trie->image->nodes;
+  const timg_node *n;
+
+  for(;;)
+  { n = &nodes[fetchBuffer(&state->choicepoints, depth, image_choice).node];
+    if ( !n->child_count )
+      break;
+    depth = image_add_choice(state, n);
+  }
+
+  return n->value != 0;
+}
+
+
+static int
+image_next_choice(trie_gen_state *state)
+{ size_t depth = entriesBuffer(&state->choicepoints, image_choice);
+
+  while( depth > 0 )
+  { image_choice *ch = baseBuffer(&state->choicepoints, image_choice)+depth-1;
+
+    state->choicepoints.top = (char*)(ch+1);
+    if ( ++ch->node < ch->end )
+    { if ( image_descent_node(state, depth-1) )
+	return TRUE;
+    } else
+    { depth--;
+    }
+  }
+
+  state->choicepoints.top = state->choicepoints.base;
+  return FALSE;
+}
+
+
+static int
+image_unify_trie_path(term_t term, uint64_t *value, trie_gen_state *gstate
+		      ARG_LD)
+{ const trie_image *img = gstate->trie->image;
+  ukey_state ustate;
+  image_choice *ch = baseBuffer(&gstate->choicepoints, image_choice);
+  image_choice *top = topBuffer(&gstate->choicepoints, image_choice);
+
+  init_ukey_state(&ustate, gstate->trie, valTermRef(term));
+  for( ; ch < top; ch++ )
+  { int rc;
+
+    if ( (rc=unify_key(&ustate, image_key(img, img->nodes[ch->node].key)
+		       PASS_LD)) != TRUE )
+    { destroy_ukey_state(&ustate);
+      return rc;
+    }
+  }
+
+  destroy_ukey_state(&ustate);
+  *value = img->nodes[ch[-1].node].value;
+
+  return TRUE;
+}
+
+
+static int
+gen_next_choice(trie_gen_state *state)
+{ if ( state->image )
+    return image_next_choice(state);
+  else
+    return next_choice(state);
+}
+
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Unify term with the term represented a trie path (list of trie_choice).
 Returns one of TRUE, FALSE or *_OVERFLOW.
@@ -1481,7 +2399,8 @@ PRED_IMPL("trie_gen", 3, trie_gen, PL_FA_NONDETERMINISTIC)
 { PRED_LD
   trie_gen_state state_buf;
   trie_gen_state *state;
-  word value;
+  word value = 0;
+  uint64_t ivalue = 0;
   fid_t fid;
 
   switch( CTX_CNTRL )
@@ -1489,7 +2408,21 @@ PRED_IMPL("trie_gen", 3, trie_gen, PL_FA_NONDETERMINISTIC)
     { trie *trie;
 
       if ( get_trie(A1, &trie) )
-      { if ( trie->root.children.any )
+      { if ( trie->image )
+	{ const timg_node *root = trie->image->nodes;
+
+	  if ( root->child_count )
+	  { acquire_trie(trie);
+	    state = &state_buf;
+	    init_trie_state(state, trie);
+	    if ( !image_descent_node(state, image_add_choice(state, root)) &&
+		 !image_next_choice(state) )
+	    { clear_trie_state(state);
+	      return FALSE;
+	    }
+	    break;
+	  }
+	} else if ( trie->root.children.any )
 	{ acquire_trie(trie);
 	  state = &state_buf;
 	  init_trie_state(state, trie);
@@ -1516,11 +2449,15 @@ PRED_IMPL("trie_gen", 3, trie_gen, PL_FA_NONDETERMINISTIC)
   }
 
   fid = PL_open_foreign_frame();
-  for( ; !isEmptyBuffer(&state->choicepoints); next_choice(state) )
+  for( ; !isEmptyBuffer(&state->choicepoints); gen_next_choice(state) )
   { int rc;
 
     for(;;)
-    { if ( (rc=unify_trie_path(A2, &value, state PASS_LD)) == TRUE )
+    { if ( state->image )
+	rc = image_unify_trie_path(A2, &ivalue, state PASS_LD);
+      else
+	rc = unify_trie_path(A2, &value, state PASS_LD);
+      if ( rc == TRUE )
 	break;
 
       PL_rewind_foreign_frame(fid);
@@ -1536,8 +2473,9 @@ PRED_IMPL("trie_gen", 3, trie_gen, PL_FA_NONDETERMINISTIC)
 
     DEBUG(CHK_SECURE, PL_check_data(A2));
 
-    if ( unify_value(A3, value PASS_LD) )
-    { if ( next_choice(state) )
+    if ( state->image ? image_unify_value(A3, state->trie->image, ivalue PASS_LD)
+		      : unify_value(A3, value PASS_LD) )
+    { if ( gen_next_choice(state) )
       { if ( !state->allocated )
 	{ trie_gen_state *nstate = allocForeignState(sizeof(*state));
 	  TmpBuffer nchp = &nstate->choicepoints;
@@ -1545,6 +2483,7 @@ PRED_IMPL("trie_gen", 3, trie_gen, PL_FA_NONDETERMINISTIC)
 
 	  nstate->trie = state->trie;
 	  nstate->allocated = TRUE;
+	  nstate->image = state->image;
 	  if ( ochp->base == ochp->static_buffer )
 	  { size_t bytes = ochp->top - ochp->base;
 	    initBuffer(nchp);
@@ -1590,6 +2529,20 @@ PRED_IMPL("$trie_property", 2, trie_property, 0)
 
       _PL_get_arg(1, A2, arg);
 
+      if ( trie->image )
+      { const trie_image_header *hdr = trie->image->header;
+
+	if ( name == ATOM_node_count )		/* root is not counted */
+	  return PL_unify_int64(arg, hdr->node_count-1);
+	else if ( name == ATOM_size )
+	  return PL_unify_int64(arg, trie->image->size);
+	else if ( name == ATOM_hashed )
+	  return PL_unify_integer(arg, 0);
+	else if ( name == ATOM_value_count )
+	  return PL_unify_int64(arg, hdr->value_count);
+	return FALSE;
+      }
+
       if ( name == ATOM_node_count )
       { return PL_unify_integer(arg, trie->node_count);
       } else if ( name == ATOM_size )
@@ -1608,6 +2561,89 @@ PRED_IMPL("$trie_property", 2, trie_property, 0)
     }
   }
 
+  return FALSE;
+}
+
+
+/**
+ * trie_save(+Trie, +File) is det.
+ *
+ * Save Trie as an image to File.  The image can be loaded using
+ * trie_load/2.
+ */
+
+static
+PRED_IMPL("trie_save", 2, trie_save, 0)
+{ PRED_LD
+  trie *trie;
+  char *fn;
+
+  if ( get_trie(A1, &trie) &&
+       PL_get_file_name(A2, &fn, 0) )
+  { tmp_buffer img;
+    IOSTREAM *out;
+    int rc;
+
+    initBuffer(&img);
+    if ( !build_trie_image(trie, &img PASS_LD) )
+    { discardBuffer(&img);
+      return FALSE;
+    }
+
+    if ( (out = Sopen_file(fn, "wbr")) )
+    { size_t size = sizeOfBuffer(&img);
+
+      rc = ( Sfwrite(img.base, 1, size, out) == size );
+      rc = ( Sclose(out) == 0 && rc );
+      if ( !rc )
+	rc = PL_error(NULL, 0, OsError(), ERR_FILE_OPERATION,
+		      ATOM_write, ATOM_source_sink, A2);
+    } else
+    { rc = PL_error(NULL, 0, OsError(), ERR_FILE_OPERATION,
+		    ATOM_open, ATOM_source_sink, A2);
+    }
+    discardBuffer(&img);
+
+    return rc;
+  }
+
+  return FALSE;
+}
+
+
+/**
+ * trie_load(+File, -Trie) is det.
+ *
+ * Load a trie image saved using trie_save/2.  If possible, the image
+ * is mapped into memory.  The resulting trie is read-only.
+ */
+
+static
+PRED_IMPL("trie_load", 2, trie_load, 0)
+{ PRED_LD
+  char *fn;
+
+  if ( PL_get_file_name(A1, &fn, 0) )
+  { trie *trie;
+
+    if ( (trie = map_trie_image(fn)) )
+    { atom_t symbol = trie_symbol(trie);
+      int rc;
+
+      rc = unify_trie(A2, trie);
+      PL_unregister_atom(symbol);
+
+      return rc;
+    }
+
+    if ( PL_exception(0) )
+      return FALSE;
+    if ( !AccessFile(fn, ACCESS_EXIST) )
+      return PL_error(NULL, 0, NULL, ERR_EXISTENCE,
+		      ATOM_source_sink, A1);
+    return PL_domain_error("trie_image", A1);
+  }
+
   return FALSE;
 }
 
@@ -1627,6 +2663,8 @@ BeginPredDefs(trie)
   PRED_DEF("trie_delete",         3, trie_delete,        0)
   PRED_DEF("trie_term",		  2, trie_term,		 0)
   PRED_DEF("trie_gen",            3, trie_gen, PL_FA_NONDETERMINISTIC)
+  PRED_DEF("trie_save",           2, trie_save,          0)
+  PRED_DEF("trie_load",           2, trie_load,          0)
   PRED_DEF("$trie_property",      2, trie_property,      0)
 EndPredDefs
 
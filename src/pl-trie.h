@@ -40,6 +40,8 @@
 #define TRIE_MAGIC  0x4bcbcf87
 #define TRIE_CMAGIC 0x4bcbcf88
 
+#define TBL_MAX_NATIVE_MODES 8		/* Size of trie->data.update.mode */
+
 typedef enum
 { TN_KEY,				/* Single key */
   TN_HASHED				/* Hashed */
@@ -76,7 +78,7 @@ typedef struct trie_node
 
 
 typedef struct trie_allocation_pool
-{ size_t	size;			/* # nodes in use */
+{ size_t	size;			/* Bytes in use */
   size_t	limit;			/* Limit of the pool */
 } trie_allocation_pool;
 
@@ -89,13 +91,36 @@ typedef struct trie
   indirect_table       *indirects;	/* indirect values */
   void		      (*release_node)(struct trie *, trie_node *);
   trie_allocation_pool *alloc_pool;	/* Node allocation pool */
+  struct trie_image    *image;		/* Read-only image (trie_load/2) */
   struct
   { struct worklist *worklist;		/* tabling worklist */
     trie_node	    *variant;		/* node in variant trie */
     fastheap_term   *skeleton;		/* Wrapper-Vars */
+    struct trie	    *lru_prev;		/* LRU list of completed tables */
+    struct trie	    *lru_next;
+    size_t	     space;		/* Bytes (stat_trie()); 0: not in LRU */
+    struct definition *predicate;	/* Tabled predicate */
+    struct
+    { unsigned char count;		/* # moded arguments (0: unknown) */
+      unsigned char native;		/* All modes are implemented in C */
+      unsigned char mode[TBL_MAX_NATIVE_MODES]; /* TBL_UPDATE_* per arg */
+    } update;				/* Mode directed tabling */
+    struct
+    { double	     started;		/* WallTime() evaluation started */
+      double	     time;		/* Time to complete (sec) */
+      size_t	     reused;		/* # calls using the complete table */
+      size_t	     suspensions;	/* # suspensions on the table */
+    } stats;				/* See flag table_statistics */
   } data;
 } trie;
 
+typedef struct trie_stats
+{ size_t bytes;
+  size_t nodes;
+  size_t hashes;
+  size_t values;
+} trie_stats;
+
 #define acquire_trie(t) ATOMIC_INC(&(t)->references)
 #define release_trie(t) do { if ( ATOMIC_DEC(&(t)->references) == 0 ) \
 			       trie_clean(t); \
@@ -116,5 +141,6 @@ COMMON(atom_t)	trie_symbol(trie *trie);
 COMMON(trie *)	symbol_trie(atom_t symbol);
 COMMON(int)	put_trie_value(term_t t, trie_node *node ARG_LD);
 COMMON(int)	set_trie_value(trie_node *node, term_t value ARG_LD);
+COMMON(void)	stat_trie(trie *t, trie_stats *stats);
 
 #endif /*_PL_TRIE_H*/
@@ -344,14 +344,7 @@ Putc(int c, IOSTREAM *s)
 
 static bool
 PutString(const char *str, IOSTREAM *s)
-{ const unsigned char *q = (const unsigned char *)str;
-
-  for( ; *q != EOS; q++ )
-  { if ( Sputcode(*q, s) == EOF )
-      return FALSE;
-  }
-
-  return TRUE;
+{ return Sput_latin1(str, strlen(str), s) == 0;
 }
 
 
@@ -375,15 +368,7 @@ PutBar(write_options *options)
 
 static bool
 PutStringN(const char *str, size_t length, IOSTREAM *s)
-{ size_t i;
-  const unsigned char *q = (const unsigned char *)str;
-
-  for(i=0; i<length; i++, q++)
-  { if ( Sputcode(*q, s) == EOF )
-      return FALSE;
-  }
-
-  return TRUE;
+{ return Sput_latin1(str, length, s) == 0;
 }
 
 
@@ -834,6 +819,8 @@ writeString(term_t t, write_options *options)
     }
 
     return Putc(quote, options->out);
+  } else if ( txt.encoding == ENC_ISO_LATIN_1 )
+  { return PutStringN(txt.text.t, txt.length, options->out);
   } else
   { unsigned int i;
 